@@ -18,11 +18,22 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <stdexcept>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined( __linux__ )
+    #include <sys/mman.h>
+#endif
 
 // includes.end
 
@@ -36,6 +47,30 @@
     #define AV_MOVE_IF_NOEXCEPT std::move
 #endif
 
+#if ( defined( __clang__ ) || __GNUC__ >= 5 )
+    #define AV_IS_TRIVIALLY_COPYABLE( type ) std::is_trivially_copyable< type >::value
+#else
+    #define AV_IS_TRIVIALLY_COPYABLE( type ) ( __has_trivial_copy( type ) && __has_trivial_assign( type ) )
+#endif
+
+#if defined( __linux__ )
+    #define AV_HAS_HUGE_PAGE_ALLOCATOR
+#endif
+
+#ifndef AV_HUGE_PAGE_SIZE
+    #define AV_HUGE_PAGE_SIZE ( 2 * 1024 * 1024 )
+#endif
+
+#if ( defined( __clang__ ) || defined( __GNUC__ ) )
+    #define AV_PREFETCH( address ) __builtin_prefetch( address )
+#else
+    #define AV_PREFETCH( address ) (void)( 0 )
+#endif
+
+#ifndef AV_PREFETCH_GROUP_SIZE
+    #define AV_PREFETCH_GROUP_SIZE 16
+#endif
+
 // configuration.end
 
 #ifndef NDEBUG
@@ -203,6 +238,201 @@ namespace util
 
 namespace util
 {
+    //
+    // is_trivially_copyable
+    //
+    template< typename _T >
+    struct is_trivially_copyable
+        : std::integral_constant< bool, AV_IS_TRIVIALLY_COPYABLE( _T ) >
+    {
+    };
+
+    // std::pair has its own operator= so it is never trivially copyable,
+    // however it is safe to copy it bitwise if both of its members are
+    template<
+          typename _T1
+        , typename _T2
+    >
+    struct is_trivially_copyable< std::pair< _T1, _T2 > >
+        : std::integral_constant<
+              bool
+            , is_trivially_copyable< _T1 >::value && is_trivially_copyable< _T2 >::value
+          >
+    {
+    };
+
+    //
+    // is_trivially_relocatable
+    //
+    // An object is trivially relocatable if moving it to a new address and forgetting
+    // the old one is equivalent to memcpy. It is true for every trivially copyable type
+    // and can be specialized by a user for types like std::unique_ptr or std::string
+    // which are not trivially copyable but do not keep pointers to themselves.
+    //
+    template< typename _T >
+    struct is_trivially_relocatable
+        : is_trivially_copyable< _T >
+    {
+    };
+
+    template<
+          typename _T1
+        , typename _T2
+    >
+    struct is_trivially_relocatable< std::pair< _T1, _T2 > >
+        : std::integral_constant<
+              bool
+            , is_trivially_relocatable< _T1 >::value && is_trivially_relocatable< _T2 >::value
+          >
+    {
+    };
+
+    namespace detail
+    {
+        //
+        // IsBitwiseMovable, raw pointers to the same trivially copyable type
+        //
+        template<
+              typename _InputPtr
+            , typename _OutputPtr
+        >
+        struct IsBitwiseMovable
+            : std::integral_constant<
+                  bool
+                ,    std::is_pointer< _InputPtr >::value
+                  && std::is_pointer< _OutputPtr >::value
+                  && std::is_same<
+                           typename std::iterator_traits< _InputPtr >::value_type
+                         , typename std::iterator_traits< _OutputPtr >::value_type
+                     >::value
+                  && is_trivially_copyable<
+                         typename std::iterator_traits< _OutputPtr >::value_type
+                     >::value
+              >
+        {
+        };
+
+        template< bool _IsBitwiseMovable >
+        struct MoveImpl
+        {
+        };
+
+        template<>
+        struct MoveImpl< true >
+        {
+            template<
+                  typename _InputPtr
+                , typename _OutputPtr
+            >
+            static
+            void move( _InputPtr first, _InputPtr const last, _OutputPtr first2 )
+            {
+                AV_PRECONDITION( less_equal( first, last ) );
+
+                if( first == last ){
+                    return;
+                }
+
+                typedef typename std::iterator_traits< _OutputPtr >::value_type T;
+
+                // memmove handles overlapping ranges in both directions
+                std::memmove(
+                      static_cast< void * >( first2 )
+                    , static_cast< void const * >( first )
+                    , ( last - first ) * sizeof( T )
+                );
+            }
+
+            template<
+                  typename _InputPtr
+                , typename _OutputPtr
+            >
+            static
+            void copy( _InputPtr first, _InputPtr const last, _OutputPtr first2 )
+            {
+                move( first, last, first2 );
+            }
+
+            template<
+                  typename _InputPtr
+                , typename _OutputPtr
+            >
+            static
+            _OutputPtr uninitialized_move( _InputPtr first, _InputPtr const last, _OutputPtr output )
+            {
+                AV_PRECONDITION( less_equal( first, last ) );
+
+                if( first == last ){
+                    return output;
+                }
+
+                typedef typename std::iterator_traits< _OutputPtr >::value_type T;
+
+                std::memcpy(
+                      static_cast< void * >( output )
+                    , static_cast< void const * >( first )
+                    , ( last - first ) * sizeof( T )
+                );
+
+                return output + ( last - first );
+            }
+        };
+
+        template<>
+        struct MoveImpl< false >
+        {
+            template<
+                  typename _InputPtr
+                , typename _OutputPtr
+            >
+            static
+            void move( _InputPtr first, _InputPtr const last, _OutputPtr first2 )
+            {
+                if( first < first2 ){
+                    std::move_backward( first, last, first2 + ( last - first ) );
+                }
+                else if( first > first2 ){
+                    std::move( first, last, first2 );
+                }
+                else{
+                    // first == first2 -> do nothing
+                }
+            }
+
+            template<
+                  typename _InputPtr
+                , typename _OutputPtr
+            >
+            static
+            void copy( _InputPtr first, _InputPtr const last, _OutputPtr first2 )
+            {
+                if( first < first2 ){
+                    std::copy_backward( first, last, first2 + ( last - first ) );
+                }
+                else if( first > first2 ){
+                    std::copy( first, last, first2 );
+                }
+                else{
+                    // first == first2 -> do nothing
+                }
+            }
+
+            template<
+                  typename _InputPtr
+                , typename _OutputPtr
+            >
+            static
+            _OutputPtr uninitialized_move( _InputPtr first, _InputPtr const last, _OutputPtr output )
+            {
+                return std::uninitialized_copy(
+                      std::make_move_iterator( first )
+                    , std::make_move_iterator( last )
+                    , output
+                );
+            }
+        };
+    }
+
     //
     // move
     //
@@ -216,17 +446,14 @@ namespace util
         , _OutputPtr first2
     )
     {
-        if( first < first2 ){
-            std::move_backward( first, last, first2 + ( last - first ) );
-        }
-        else if( first > first2 ){
-            std::move( first, last, first2 );
-        }
-        else{
-            // first == first2 -> do nothing
-        }
+        detail::MoveImpl<
+            detail::IsBitwiseMovable< _InputPtr, _OutputPtr >::value
+        >::move( first, last, first2 );
     }
 
+    //
+    // copy
+    //
     template<
           typename _InputPtr
         , typename _OutputPtr
@@ -237,18 +464,28 @@ namespace util
         , _OutputPtr first2
     )
     {
-        if( first < first2 ){
-            std::copy_backward( first, last, first2 + ( last - first ) );
-        }
-        else if( first > first2 ){
-            std::copy( first, last, first2 );
-        }
-        else{
-            // first == first2 -> do nothing
-        }
+        detail::MoveImpl<
+            detail::IsBitwiseMovable< _InputPtr, _OutputPtr >::value
+        >::copy( first, last, first2 );
     }
 
-
+    //
+    // uninitialized_move
+    //
+    template<
+          typename _InputPtr
+        , typename _OutputPtr
+    >
+    inline _OutputPtr uninitialized_move(
+          _InputPtr first
+        , _InputPtr last
+        , _OutputPtr output
+    )
+    {
+        return detail::MoveImpl<
+            detail::IsBitwiseMovable< _InputPtr, _OutputPtr >::value
+        >::uninitialized_move( first, last, output );
+    }
 
     namespace detail
     {
@@ -399,83 +636,403 @@ bool has_intersection(
 
 }
 
-namespace array
+namespace util
 {
-    //
-    // I need much more control over Array inside AssocVector than std::vector offers
-    //
 
-    // C' style array with some useful methods and functions
+//
+// gallop_lower_bound, lower_bound searching exponentially from first,
+// O( log( distance ) ) to the result instead of O( log( last - first ) )
+//
+template<
+      typename _Iterator
+    , typename _T
+    , typename _Cmp
+>
+_Iterator
+gallop_lower_bound(
+      _Iterator first
+    , _Iterator const last
+    , _T const & t
+    , _Cmp cmp
+)
+{
+    AV_PRECONDITION( less_equal( first, last ) );
 
-    //
-    // Array
-    //
-    template<
-          typename _T
-        , typename _Alloc = std::allocator< _T >
-    >
-    struct ArrayBase
-    {
-        struct ArrayImpl
-            : public _Alloc
-        {
-            ArrayImpl( _Alloc const & alloc = _Alloc() )
-                : _Alloc( alloc )
-                , _data( nullptr )
-                , _capacity( 0 )
-                , _size( 0 )
-            {
-            }
+    std::size_t const size = last - first;
 
-            ArrayImpl( std::size_t capacity, _Alloc const & alloc = _Alloc() )
-                : _Alloc( alloc )
-                , _data( capacity ? this->allocate( capacity ) : nullptr )
-                , _capacity( capacity )
-                , _size( 0 )
-            {
-                AV_PRECONDITION( _capacity < this->max_size() );
-            }
+    if( size == 0 || cmp( first[ 0 ], t ) == false ){
+        return first;
+    }
 
-            ~ArrayImpl()
-            {
-                util::destroy_range( _data, _data + _size );
+    std::size_t bound = 1;
 
-                this->deallocate( _data, _capacity );
-            }
+    while( bound < size && cmp( first[ bound ], t ) ){
+        bound *= 2;
+    }
 
-            void swap( ArrayImpl & other )noexcept
-            {
-                std::swap( _data, other._data );
-                std::swap( _capacity, other._capacity );
-                std::swap( _size, other._size );
-            }
+    // first[ bound / 2 ] < t <= first[ bound ]
+    return std::lower_bound( first + bound / 2 + 1, first + std::min( bound, size ), t, cmp );
+}
 
-        public:
-            _T * _data;
+//
+// fold_second, op( init, item.second ) over [ first, last ),
+// unrolled by 4 into a tree so independent ops may overlap or vectorize,
+// op has to be associative
+//
+template<
+      typename _Iterator
+    , typename _T
+    , typename _BinaryOp
+>
+_T
+fold_second(
+      _Iterator first
+    , _Iterator const last
+    , _T init
+    , _BinaryOp op
+)
+{
+    AV_PRECONDITION( less_equal( first, last ) );
 
-            std::size_t _capacity;
-            std::size_t _size;
-        };
+    for( /*empty*/ ; last - first >= 4 ; first += 4 )
+    {
+        init = op(
+              init
+            , op(
+                  op( first[ 0 ].second, first[ 1 ].second )
+                , op( first[ 2 ].second, first[ 3 ].second )
+              )
+        );
+    }
 
-        typedef _Alloc allocator_type;
+    for( /*empty*/ ; first != last ; ++ first ){
+        init = op( init, first->second );
+    }
 
-        allocator_type
-        get_allocator() const {
-            return * static_cast< allocator_type const * >( & this->_impl );
-        }
+    return init;
+}
 
-    public:
-        ArrayBase( _Alloc const & alloc = _Alloc() )
-            : _impl( alloc )
-        {
-        }
+//
+// Min, Max, binary ops for fold_second and AssocVector::aggregate
+//
+template< typename _T >
+struct Min
+{
+    _T operator()( _T const & lhs, _T const & rhs )const
+    {
+        return rhs < lhs ? rhs : lhs;
+    }
+};
 
-        ArrayBase( std::size_t capacity, _Alloc const & alloc = _Alloc() )
-            : _impl( capacity, alloc )
-        {
-        }
+template< typename _T >
+struct Max
+{
+    _T operator()( _T const & lhs, _T const & rhs )const
+    {
+        return lhs < rhs ? rhs : lhs;
+    }
+};
 
-        ~ArrayBase() = default;
+//
+// radix_sort, stable LSD radix sort of ( unsigned key, payload ) pairs by key, a byte per pass,
+// a pass is skipped if all keys share its byte
+//
+template<
+      typename _Unsigned
+    , typename _Payload
+>
+void
+radix_sort( std::vector< std::pair< _Unsigned, _Payload > > & items )
+{
+    static_assert( std::is_unsigned< _Unsigned >::value, "radix_sort: keys have to be unsigned" );
+
+    if( items.empty() ){
+        return;
+    }
+
+    std::vector< std::pair< _Unsigned, _Payload > > buffer( items.size() );
+
+    for( std::size_t shift = 0 ; shift < 8 * sizeof( _Unsigned ) ; shift += 8 )
+    {
+        std::size_t offsets[ 256 ] = { 0 };
+
+        for( std::size_t i = 0 ; i < items.size() ; ++ i ){
+            ++ offsets[ ( items[ i ].first >> shift ) & 0xff ];
+        }
+
+        if( offsets[ ( items[ 0 ].first >> shift ) & 0xff ] == items.size() ){
+            continue;
+        }
+
+        for( std::size_t digit = 0, sum = 0 ; digit < 256 ; ++ digit )
+        {
+            std::size_t const count = offsets[ digit ];
+
+            offsets[ digit ] = sum;
+            sum += count;
+        }
+
+        for( std::size_t i = 0 ; i < items.size() ; ++ i ){
+            buffer[ offsets[ ( items[ i ].first >> shift ) & 0xff ] ++ ] = items[ i ];
+        }
+
+        items.swap( buffer );
+    }
+}
+
+//
+// gallop_lower_bound_backward, lower_bound searching exponentially from last down to first,
+// O( log( distance ) ) to the result instead of O( log( last - first ) )
+//
+template<
+      typename _Iterator
+    , typename _T
+    , typename _Cmp
+>
+_Iterator
+gallop_lower_bound_backward(
+      _Iterator const first
+    , _Iterator last
+    , _T const & t
+    , _Cmp cmp
+)
+{
+    AV_PRECONDITION( less_equal( first, last ) );
+
+    std::size_t step = 1;
+
+    // result is in [ first, last ]
+    while( static_cast< std::size_t >( last - first ) >= step && cmp( * ( last - step ), t ) == false )
+    {
+        last -= step;
+        step *= 2;
+    }
+
+    _Iterator const lower
+        = static_cast< std::size_t >( last - first ) >= step ? last - step : first;
+
+    return std::lower_bound( lower, last, t, cmp );
+}
+
+//
+// interleaved_lower_bound, count independent branchless lower_bound searches over
+// [ first, last ) advanced in lockstep, next probe of each of them is prefetched
+// so count cache misses are in flight at once instead of one
+//
+template<
+      typename _Iterator
+    , typename _T
+    , typename _Cmp
+>
+void
+interleaved_lower_bound(
+      _Iterator const first
+    , _Iterator const last
+    , _T const * const * values
+    , std::size_t const count
+    , _Iterator * results
+    , _Cmp cmp
+)
+{
+    AV_PRECONDITION( less_equal( first, last ) );
+
+    std::size_t size = last - first;
+
+    for( std::size_t i = 0 ; i < count ; ++ i ){
+        results[ i ] = first;
+    }
+
+    if( size == 0 ){
+        return;
+    }
+
+    while( size > 1 )
+    {
+        std::size_t const half = size / 2;
+
+        size -= half;
+
+        for( std::size_t i = 0 ; i < count ; ++ i )
+        {
+            results[ i ] = cmp( results[ i ][ half ], * values[ i ] ) ? results[ i ] + half : results[ i ];
+
+            AV_PREFETCH( & results[ i ][ size / 2 ] );
+        }
+    }
+
+    for( std::size_t i = 0 ; i < count ; ++ i ){
+        results[ i ] += cmp( * results[ i ], * values[ i ] ) ? 1 : 0;
+    }
+}
+
+//
+// is_strictly_sorted, range is sorted and has no equal items
+//
+template<
+      typename _Iterator
+    , typename _Cmp
+>
+bool
+is_strictly_sorted(
+      _Iterator first
+    , _Iterator const last
+    , _Cmp cmp
+)
+{
+    if( first == last ){
+        return true;
+    }
+
+    for( _Iterator next = first ; ++ next != last ; first = next )
+    {
+        if( cmp( * first, * next ) == false ){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// unique_sorted, like std::unique for a range sorted with cmp, first of equal items stays
+//
+template<
+      typename _Iterator
+    , typename _Cmp
+>
+_Iterator
+unique_sorted(
+      _Iterator first
+    , _Iterator const last
+    , _Cmp cmp
+)
+{
+    AV_PRECONDITION( less_equal( first, last ) );
+
+    if( first == last ){
+        return last;
+    }
+
+    _Iterator result = first;
+
+    while( ++ first != last )
+    {
+        if( cmp( * result, * first ) )
+        {
+            ++ result;
+
+            if( result != first ){
+                * result = std::move( * first );
+            }
+        }
+    }
+
+    return ++ result;
+}
+
+}
+
+namespace array
+{
+    namespace detail
+    {
+        //
+        // HasReallocate, allocator is able to grow a block keeping its content:
+        //     pointer reallocate( pointer p, size_type oldCapacity, size_type newCapacity )
+        //
+        template< typename _Alloc >
+        struct HasReallocate
+        {
+        private:
+            template< typename __Alloc >
+            static char test( decltype( & __Alloc::reallocate ) );
+
+            template< typename __Alloc >
+            static long test( ... );
+
+        public:
+            static bool const value = sizeof( test< _Alloc >( 0 ) ) == sizeof( char );
+        };
+    }
+}
+
+namespace array
+{
+    //
+    // I need much more control over Array inside AssocVector than std::vector offers
+    //
+
+    // C' style array with some useful methods and functions
+
+    //
+    // Array
+    //
+    template<
+          typename _T
+        , typename _Alloc = std::allocator< _T >
+    >
+    struct ArrayBase
+    {
+        struct ArrayImpl
+            : public _Alloc
+        {
+            ArrayImpl( _Alloc const & alloc = _Alloc() )
+                : _Alloc( alloc )
+                , _data( nullptr )
+                , _capacity( 0 )
+                , _size( 0 )
+            {
+            }
+
+            ArrayImpl( std::size_t capacity, _Alloc const & alloc = _Alloc() )
+                : _Alloc( alloc )
+                , _data( capacity ? this->allocate( capacity ) : nullptr )
+                , _capacity( capacity )
+                , _size( 0 )
+            {
+                AV_PRECONDITION( _capacity < this->max_size() );
+            }
+
+            ~ArrayImpl()
+            {
+                util::destroy_range( _data, _data + _size );
+
+                this->deallocate( _data, _capacity );
+            }
+
+            void swap( ArrayImpl & other )noexcept
+            {
+                std::swap( _data, other._data );
+                std::swap( _capacity, other._capacity );
+                std::swap( _size, other._size );
+            }
+
+        public:
+            _T * _data;
+
+            std::size_t _capacity;
+            std::size_t _size;
+        };
+
+        typedef _Alloc allocator_type;
+
+        allocator_type
+        get_allocator() const {
+            return * static_cast< allocator_type const * >( & this->_impl );
+        }
+
+    public:
+        ArrayBase( _Alloc const & alloc = _Alloc() )
+            : _impl( alloc )
+        {
+        }
+
+        ArrayBase( std::size_t capacity, _Alloc const & alloc = _Alloc() )
+            : _impl( capacity, alloc )
+        {
+        }
+
+        ~ArrayBase() = default;
 
         ArrayBase( ArrayBase const & other ) = delete;
         ArrayBase( ArrayBase && other ) = delete;
@@ -506,6 +1063,11 @@ namespace array
         typedef _T * iterator;
         typedef _T const * const_iterator;
 
+        // Array may grow in place, its items are relocated bitwise by _Alloc::reallocate then
+        static bool const can_reallocate
+            =  detail::HasReallocate< _Alloc >::value
+            && util::is_trivially_relocatable< _T >::value;
+
     public:
         Array( _Alloc const & alloc = _Alloc() )
             : Base( alloc )
@@ -518,11 +1080,16 @@ namespace array
         }
 
         Array( Array const & other )
+            : Array( other, other.get_allocator() )
+        {
+        }
+
+        Array( Array const & other, _Alloc const & alloc )
             // In std::vector new vector's capacity is equal to old vector's size.
             // Array's capacity is equal to old array's capacity to ensure invariant that:
             // sqrt( storage.capacity ) == buffer.capacity
             // sqrt( storage.capacity ) == erased.capacity
-            : Base( other.capacity(), other.get_allocator() )
+            : Base( other.capacity(), alloc )
         {
             for( /*empty*/ ; this->_impl._size < other.size() ; ++ this->_impl._size ){
                 get_allocator().construct(
@@ -571,15 +1138,7 @@ namespace array
                 return;
             }
 
-            Array< _T, _Alloc > temp( capacity, get_allocator() );
-
-            std::uninitialized_copy(
-                  std::make_move_iterator( begin() )
-                , std::make_move_iterator( end() )
-                , temp.begin()
-            );
-
-            swap( temp );
+            reallocate( capacity, std::integral_constant< bool, can_reallocate >() );
         }
 
         iterator begin()noexcept
@@ -720,22 +1279,27 @@ namespace array
         template< typename _T2 >
         void
         insert(
-              typename Array< _T >::iterator const pos
+              iterator const pos
             , _T2 && t
         )
         {
             AV_PRECONDITION( util::less_equal( size() + 1, capacity() ) );
             AV_PRECONDITION( util::is_between( begin(), pos, end() ) );
 
+            if( pos == end() )
+            {
+                place_back( std::forward< _T2 >( t ) );
+
+                return;
+            }
+
             iterator const oldEnd = end();
 
-            get_allocator().construct( end() );
+            // the last item is moved into uninitialized memory, the rest is shifted by assignment
+            get_allocator().construct( end(), AV_MOVE_IF_NOEXCEPT( back() ) );
             setSize( getSize() + 1 );
 
-            if( pos != oldEnd )
-            {
-                util::move( pos, oldEnd, pos + 1 );
-            }
+            util::move( pos, oldEnd - 1, pos + 1 );
 
             * pos = AV_MOVE_IF_NOEXCEPT( t );
         }
@@ -755,7 +1319,7 @@ namespace array
         }
 
         void
-        erase( typename Array< _T >::iterator pos )
+        erase( iterator pos )
         {
             AV_PRECONDITION( empty() == false );
             AV_PRECONDITION( util::less_equal( begin(), pos ) );
@@ -767,6 +1331,26 @@ namespace array
         }
 
     private:
+        void reallocate( std::size_t capacity, std::true_type /*can_reallocate*/ )
+        {
+            _Alloc & alloc = this->_impl;
+
+            setData( alloc.reallocate( getData(), getCapacity(), capacity ) );
+            setCapacity( capacity );
+        }
+
+        void reallocate( std::size_t capacity, std::false_type /*can_reallocate*/ )
+        {
+            Array< _T, _Alloc > temp( capacity, get_allocator() );
+
+            util::uninitialized_move( begin(), end(), temp.begin() );
+
+            // moved-from items are destroyed in temp destructor
+            temp.setSize( getSize() );
+
+            swap( temp );
+        }
+
         void setCapacity( std::size_t newCapacity ) noexcept
         {
             AV_PRECONDITION( getData() != 0 || newCapacity == 0 );
@@ -783,14 +1367,411 @@ namespace array
 
 namespace array
 {
-    template<
-          typename _Iterator
-        , typename _T
-        , typename _Cmp
-    >
-    _Iterator
-    binary_search(
-          _Iterator first
+    //
+    // Span, non owning view of contiguous items
+    //
+    template< typename _T >
+    struct Span
+    {
+        typedef _T value_type;
+        typedef _T * iterator;
+        typedef _T * const_iterator;
+
+        Span()
+            : _data( 0 )
+            , _size( 0 )
+        {
+        }
+
+        Span( _T * data, std::size_t size )
+            : _data( data )
+            , _size( size )
+        {
+            AV_PRECONDITION( data != 0 || size == 0 );
+        }
+
+        iterator begin()const noexcept
+        {
+            return _data;
+        }
+
+        iterator end()const noexcept
+        {
+            return _data + _size;
+        }
+
+        _T * data()const noexcept
+        {
+            return _data;
+        }
+
+        std::size_t size()const noexcept
+        {
+            return _size;
+        }
+
+        bool empty()const noexcept
+        {
+            return _size == 0;
+        }
+
+        _T & operator[]( std::size_t index )const noexcept
+        {
+            AV_PRECONDITION( index < _size );
+
+            return _data[ index ];
+        }
+
+    private:
+        _T * _data;
+        std::size_t _size;
+    };
+}
+
+namespace array
+{
+    //
+    // ReallocAllocator, malloc based allocator which grows blocks with realloc
+    //
+    // Used as AssocVector allocator it lets storage grow in place for trivially
+    // relocatable items, no item is moved one by one then.
+    //
+    template< typename _T >
+    struct ReallocAllocator
+    {
+        typedef _T value_type;
+
+        typedef _T * pointer;
+        typedef _T const * const_pointer;
+
+        typedef _T & reference;
+        typedef _T const & const_reference;
+
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template< typename __T >
+        struct rebind{ typedef ReallocAllocator< __T > other; };
+
+        ReallocAllocator()noexcept
+        {
+        }
+
+        template< typename __T >
+        ReallocAllocator( ReallocAllocator< __T > const & )noexcept
+        {
+        }
+
+        pointer allocate( size_type n, void const * = 0 )
+        {
+            void * const p = std::malloc( n * sizeof( _T ) );
+
+            if( p == 0 ){
+                throw std::bad_alloc();
+            }
+
+            return static_cast< pointer >( p );
+        }
+
+        void deallocate( pointer p, size_type )
+        {
+            std::free( p );
+        }
+
+        pointer reallocate( pointer p, size_type /*oldCapacity*/, size_type newCapacity )
+        {
+            // items are trivially relocatable, see can_reallocate
+            void * const result = std::realloc( static_cast< void * >( p ), newCapacity * sizeof( _T ) );
+
+            if( result == 0 ){
+                throw std::bad_alloc();
+            }
+
+            return static_cast< pointer >( result );
+        }
+
+        template<
+              typename __T
+            , typename... __Args
+        >
+        void construct( __T * p, __Args &&... args )
+        {
+            new ( static_cast< void * >( p ) ) __T( std::forward< __Args >( args )... );
+        }
+
+        template< typename __T >
+        void destroy( __T * p )
+        {
+            p -> ~__T();
+        }
+
+        size_type max_size()const noexcept
+        {
+            return size_type( -1 ) / sizeof( _T );
+        }
+    };
+
+    template<
+          typename _T1
+        , typename _T2
+    >
+    inline bool operator==( ReallocAllocator< _T1 > const &, ReallocAllocator< _T2 > const & )
+    {
+        return true;
+    }
+
+    template<
+          typename _T1
+        , typename _T2
+    >
+    inline bool operator!=( ReallocAllocator< _T1 > const &, ReallocAllocator< _T2 > const & )
+    {
+        return false;
+    }
+}
+
+#ifdef AV_HAS_HUGE_PAGE_ALLOCATOR
+
+namespace array
+{
+    namespace detail
+    {
+        inline std::size_t round_up_to_huge_page( std::size_t bytes )
+        {
+            return ( bytes + AV_HUGE_PAGE_SIZE - 1 ) & ~std::size_t( AV_HUGE_PAGE_SIZE - 1 );
+        }
+
+        // mapping is aligned to huge page size, otherwise kernel can not back it with huge pages
+        inline void * map_huge_pages( std::size_t bytes )
+        {
+            std::size_t const mappedBytes = bytes + AV_HUGE_PAGE_SIZE;
+
+            void * const mapped = ::mmap(
+                  0
+                , mappedBytes
+                , PROT_READ | PROT_WRITE
+                , MAP_PRIVATE | MAP_ANONYMOUS
+                , -1
+                , 0
+            );
+
+            if( mapped == MAP_FAILED ){
+                throw std::bad_alloc();
+            }
+
+            char * const begin = static_cast< char * >( mapped );
+            char * const aligned = begin + ( round_up_to_huge_page( reinterpret_cast< std::size_t >( begin ) ) - reinterpret_cast< std::size_t >( begin ) );
+            char * const end = begin + mappedBytes;
+
+            if( aligned != begin ){
+                ::munmap( begin, aligned - begin );
+            }
+
+            if( aligned + bytes != end ){
+                ::munmap( aligned + bytes, end - ( aligned + bytes ) );
+            }
+
+            // advice only, ignored if transparent huge pages are disabled
+            ::madvise( aligned, bytes, MADV_HUGEPAGE );
+
+            return aligned;
+        }
+
+        inline void * remap_huge_pages( void * p, std::size_t oldBytes, std::size_t newBytes )
+        {
+            void * const result = ::mremap( p, oldBytes, newBytes, MREMAP_MAYMOVE );
+
+            if( result == MAP_FAILED ){
+                throw std::bad_alloc();
+            }
+
+            ::madvise( result, newBytes, MADV_HUGEPAGE );
+
+            return result;
+        }
+    }
+
+    //
+    // HugePageAllocator, blocks of at least _Threshold bytes are mmap-ed and backed by
+    // transparent huge pages, smaller ones come from malloc
+    //
+    // Large sorted arrays searched at random touch many pages, with huge pages they need
+    // far fewer TLB entries. Blocks grow in place with mremap, see ReallocAllocator.
+    //
+    template<
+          typename _T
+        , std::size_t _Threshold = AV_HUGE_PAGE_SIZE
+    >
+    struct HugePageAllocator
+    {
+        typedef _T value_type;
+
+        typedef _T * pointer;
+        typedef _T const * const_pointer;
+
+        typedef _T & reference;
+        typedef _T const & const_reference;
+
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template< typename __T >
+        struct rebind{ typedef HugePageAllocator< __T, _Threshold > other; };
+
+        HugePageAllocator()noexcept
+        {
+        }
+
+        template< typename __T >
+        HugePageAllocator( HugePageAllocator< __T, _Threshold > const & )noexcept
+        {
+        }
+
+        static bool isMapped( size_type n )
+        {
+            return n * sizeof( _T ) >= _Threshold;
+        }
+
+        pointer allocate( size_type n, void const * = 0 )
+        {
+            if( isMapped( n ) ){
+                return static_cast< pointer >(
+                    detail::map_huge_pages( detail::round_up_to_huge_page( n * sizeof( _T ) ) )
+                );
+            }
+
+            void * const p = std::malloc( n * sizeof( _T ) );
+
+            if( p == 0 ){
+                throw std::bad_alloc();
+            }
+
+            return static_cast< pointer >( p );
+        }
+
+        void deallocate( pointer p, size_type n )
+        {
+            if( p == 0 ){
+                return;
+            }
+
+            if( isMapped( n ) ){
+                ::munmap( p, detail::round_up_to_huge_page( n * sizeof( _T ) ) );
+            }
+            else{
+                std::free( p );
+            }
+        }
+
+        pointer reallocate( pointer p, size_type oldCapacity, size_type newCapacity )
+        {
+            if( p == 0 ){
+                return allocate( newCapacity );
+            }
+
+            bool const isOldMapped = isMapped( oldCapacity );
+            bool const isNewMapped = isMapped( newCapacity );
+
+            if( isOldMapped && isNewMapped )
+            {
+                return static_cast< pointer >(
+                    detail::remap_huge_pages(
+                          p
+                        , detail::round_up_to_huge_page( oldCapacity * sizeof( _T ) )
+                        , detail::round_up_to_huge_page( newCapacity * sizeof( _T ) )
+                    )
+                );
+            }
+
+            if( isOldMapped == false && isNewMapped == false )
+            {
+                // items are trivially relocatable, see can_reallocate
+                void * const result = std::realloc( static_cast< void * >( p ), newCapacity * sizeof( _T ) );
+
+                if( result == 0 ){
+                    throw std::bad_alloc();
+                }
+
+                return static_cast< pointer >( result );
+            }
+
+            // block crosses the threshold, items are copied bitwise once, the smaller block
+            // is the one from malloc
+            pointer const result = allocate( newCapacity );
+
+            size_type const copied = isOldMapped ? newCapacity : oldCapacity;
+
+            std::memcpy(
+                  static_cast< void * >( result )
+                , static_cast< void const * >( p )
+                , copied * sizeof( _T )
+            );
+
+            deallocate( p, oldCapacity );
+
+            return result;
+        }
+
+        template<
+              typename __T
+            , typename... __Args
+        >
+        void construct( __T * p, __Args &&... args )
+        {
+            new ( static_cast< void * >( p ) ) __T( std::forward< __Args >( args )... );
+        }
+
+        template< typename __T >
+        void destroy( __T * p )
+        {
+            p -> ~__T();
+        }
+
+        size_type max_size()const noexcept
+        {
+            return size_type( -1 ) / sizeof( _T );
+        }
+    };
+
+    template<
+          typename _T1
+        , typename _T2
+        , std::size_t _Threshold
+    >
+    inline bool operator==(
+          HugePageAllocator< _T1, _Threshold > const &
+        , HugePageAllocator< _T2, _Threshold > const &
+    )
+    {
+        return true;
+    }
+
+    template<
+          typename _T1
+        , typename _T2
+        , std::size_t _Threshold
+    >
+    inline bool operator!=(
+          HugePageAllocator< _T1, _Threshold > const &
+        , HugePageAllocator< _T2, _Threshold > const &
+    )
+    {
+        return false;
+    }
+}
+
+#endif
+
+namespace array
+{
+    template<
+          typename _Iterator
+        , typename _T
+        , typename _Cmp
+    >
+    _Iterator
+    binary_search(
+          _Iterator first
         , _Iterator last
         , _T const & t
         , _Cmp cmp
@@ -815,19 +1796,20 @@ namespace array
 
     template<
           typename _T
+        , typename _Alloc
         , typename _T2
         , typename _Cmp
     >
-    std::pair< typename Array< _T >::iterator, bool >
+    std::pair< typename Array< _T, _Alloc >::iterator, bool >
     insert_in_sorted(
-          Array< _T > & array
+          Array< _T, _Alloc > & array
         , _T2 && t
         , _Cmp cmp
     )
     {
         AV_PRECONDITION( util::less_equal( array.size() + 1, array.capacity() ) );
 
-        typename Array< _T >::iterator const greaterEqual
+        typename Array< _T, _Alloc >::iterator const greaterEqual
             = std::lower_bound( array.begin(), array.end(), t, cmp );
 
         if( greaterEqual != array.end() )
@@ -844,11 +1826,15 @@ namespace array
         return std::make_pair( greaterEqual, true );
     }
 
-    template< typename _T >
+    template<
+          typename _T
+        , typename _Alloc
+        , typename _ErasedAlloc
+    >
     void
     erase_removed(
-          array::Array< _T > & storage
-        , array::Array< typename array::Array< _T >::const_iterator > const & erased
+          array::Array< _T, _Alloc > & storage
+        , array::Array< _T const *, _ErasedAlloc > const & erased
     )
     {
         AV_PRECONDITION( util::less_equal( erased.size(), storage.size() ) );
@@ -857,14 +1843,9 @@ namespace array
             return;
         }
 
-        typedef typename array::Array< _T >::const_iterator StorageConstIterator;
-        typedef typename array::Array< _T >::iterator StorageIterator;
-        typedef typename array::Array< StorageConstIterator >::const_iterator ErasedConstIterator;
-
-        StorageIterator currentInStorage = const_cast< StorageIterator >( erased.front() );
-        AV_CHECK( util::is_between( storage.begin(), currentInStorage, storage.end() ) );
-
-        StorageIterator const endInStorage = storage.end();
+        typedef typename array::Array< _T, _Alloc >::const_iterator StorageConstIterator;
+        typedef typename array::Array< _T, _Alloc >::iterator StorageIterator;
+        typedef typename array::Array< StorageConstIterator, _ErasedAlloc >::const_iterator ErasedConstIterator;
 
         StorageIterator whereInsertInStorage = const_cast< StorageIterator >( erased.front() );
         AV_CHECK( util::is_between( storage.begin(), whereInsertInStorage, storage.end() ) );
@@ -872,46 +1853,107 @@ namespace array
         ErasedConstIterator currentInErased = erased.begin();
         ErasedConstIterator const endInErased = erased.end();
 
-        while( currentInStorage != endInStorage )
+        while( currentInErased != endInErased )
         {
-            AV_CHECK( util::is_between( storage.begin(), whereInsertInStorage, storage.end() ) );
+            // items placed between two erased items are moved as one run
+            StorageIterator const firstInRun = const_cast< StorageIterator >( * currentInErased ) + 1;
 
-            if(
-                   currentInErased != endInErased
-                && currentInStorage == ( * currentInErased )
-            )
-            {
-                ++ currentInStorage;
-                ++ currentInErased;
-            }
-            else
-            {
-              ( * whereInsertInStorage ) = AV_MOVE_IF_NOEXCEPT( * currentInStorage );
+            ++ currentInErased;
 
-              ++ whereInsertInStorage;
-              ++ currentInStorage;
-            }
-        }
+            StorageIterator const lastInRun
+                = currentInErased == endInErased
+                ? storage.end()
+                : const_cast< StorageIterator >( * currentInErased );
+
+            AV_CHECK( util::less_equal( firstInRun, lastInRun ) );
+            AV_CHECK( util::is_between( storage.begin(), lastInRun, storage.end() ) );
 
-        AV_POSTCONDITION( currentInErased == endInErased );
+            util::move( firstInRun, lastInRun, whereInsertInStorage );
+
+            whereInsertInStorage += lastInRun - firstInRun;
+        }
 
         storage.setSize( storage.size() - erased.size() );
     }
 
+    //
+    // erase_removed_if, removes erased items and items matching pred in one pass,
+    // kept items are moved as whole runs, the tail is destroyed
+    //
     template<
           typename _T
-        , typename _Cmp
+        , typename _Alloc
+        , typename _ErasedIterator
+        , typename _Pred
     >
     void
-    move_merge(
-          array::Array< _T > & storage
-        , array::Array< _T > & buffer
-        , _Cmp const & cmp = _Cmp()
+    erase_removed_if(
+          array::Array< _T, _Alloc > & array
+        , _ErasedIterator currentInErased
+        , _ErasedIterator const endInErased
+        , _Pred pred
     )
     {
-        AV_PRECONDITION( util::less_equal( storage.size() + buffer.size(), storage.capacity() ) );
+        typedef typename array::Array< _T, _Alloc >::iterator Iterator;
 
-        typedef typename array::Array< _T >::iterator Iterator;
+        Iterator whereInsert = array.begin();
+        Iterator current = array.begin();
+        Iterator const end = array.end();
+
+        while( current != end )
+        {
+            {// skip removed items
+                while( current != end )
+                {
+                    if( currentInErased != endInErased && * currentInErased == current ){
+                        ++ currentInErased;
+                    }
+                    else if( pred( * current ) == false ){
+                        break;
+                    }
+
+                    ++ current;
+                }
+            }
+
+            Iterator const firstInRun = current;
+
+            {// find kept items
+                while(
+                       current != end
+                    && ( currentInErased == endInErased || * currentInErased != current )
+                    && pred( * current ) == false
+                )
+                {
+                    ++ current;
+                }
+            }
+
+            util::move( firstInRun, current, whereInsert );
+
+            whereInsert += current - firstInRun;
+        }
+
+        util::destroy_range( whereInsert, end );
+
+        array.setSize( whereInsert - array.begin() );
+    }
+
+    template<
+          typename _T
+        , typename _Alloc
+        , typename _Cmp
+    >
+    void
+    move_merge(
+          array::Array< _T, _Alloc > & storage
+        , array::Array< _T, _Alloc > & buffer
+        , _Cmp const & cmp = _Cmp()
+    )
+    {
+        AV_PRECONDITION( util::less_equal( storage.size() + buffer.size(), storage.capacity() ) );
+
+        typedef typename array::Array< _T, _Alloc >::iterator Iterator;
 
         Iterator rWhereInsertInStorage = storage.begin() + storage.size() + buffer.size() - 1;
 
@@ -1032,19 +2074,11 @@ move_merge_into_uninitialized(
     }
 
     if( first1 == last1 ){
-        return std::uninitialized_copy(
-              std::make_move_iterator( first2 )
-            , std::make_move_iterator( last2 )
-            , output
-        );
+        return util::uninitialized_move( first2, last2, output );
     }
 
     if( first2 == last2 ){
-        return std::uninitialized_copy(
-              std::make_move_iterator( first1 )
-            , std::make_move_iterator( last1 )
-            , output
-        );
+        return util::uninitialized_move( first1, last1, output );
     }
 
     return output;
@@ -2113,6 +3147,23 @@ namespace detail
             return _current.data();
         }
 
+        //
+        // index, position in order, O(1) when container is flat, O( log N ) otherwise,
+        // see AssocVector::nth, rank, the iterator is not random access, moving it by n is nth( index() + n )
+        //
+        std::size_t index()const
+        {
+            if( ! _current ){
+                return _container->size();
+            }
+
+            if( _container->buffer().empty() && _container->erased().empty() ){
+                return _current.data() - _container->storage().begin();
+            }
+
+            return _container->rank( _current.data()->first );
+        }
+
     private:
         bool isEmpty()const
         {
@@ -2488,296 +3539,583 @@ namespace detail
         return out;
     }
 
-} // namespace detail
-
-template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp = std::less< _Key >
-    , typename _Allocator = std::allocator< std::pair< _Key, _Mapped > >
->
-struct AssocVector
-{
-private:
-    typedef std::pair< _Key, _Mapped > value_type_mutable;
-    typedef std::pair< _Key const, _Mapped > value_type_key_const;
-
-public:
-    typedef _Key key_type;
-    typedef _Mapped mapped_type;
-
-    typedef value_type_key_const value_type;
+    //
+    // AssocVectorValuePredicate, calls user predicate with pair< K const, M > as std::map does
+    //
+    template<
+          typename _Pred
+        , typename _Value
+    >
+    struct AssocVectorValuePredicate
+    {
+        AssocVectorValuePredicate( _Pred const & pred )
+            : _pred( pred )
+        {
+        }
 
-    typedef typename _Allocator::size_type size_type;
-    typedef typename _Allocator::difference_type difference_type;
+        template< typename _ValueMutable >
+        bool operator()( _ValueMutable const & value )
+        {
+            return _pred( * reinterpret_cast< _Value const * >( & value ) );
+        }
 
-    typedef typename _Allocator::pointer pointer;
-    typedef typename _Allocator::const_pointer const_pointer;
+    private:
+        _Pred _pred;
+    };
 
-    typedef _Cmp key_compare;
-    typedef util::CmpByFirst< value_type_mutable, _Cmp > value_compare;
+    //
+    // AssocVectorKeyRangePredicate, key in [ lower, upper ), upper is optional
+    //
+    template<
+          typename _Key
+        , typename _Cmp
+    >
+    struct AssocVectorKeyRangePredicate
+    {
+        AssocVectorKeyRangePredicate(
+              _Key const & lower
+            , _Key const * upper
+            , _Cmp const & cmp
+        )
+            : _lower( lower )
+            , _upper( upper )
+            , _cmp( cmp )
+        {
+        }
 
-    typedef _Allocator allocator_type;
+        template< typename _Value >
+        bool operator()( _Value const & value )const
+        {
+            return
+                   _cmp( value.first, _lower ) == false
+                && ( _upper == 0 || _cmp( value.first, * _upper ) );
+        }
 
-    typedef mapped_type & reference;
-    typedef mapped_type const & const_reference;
+    private:
+        _Key const & _lower;
+        _Key const * _upper;
+        _Cmp _cmp;
+    };
 
-    typedef detail::AssocVectorLazyIterator< value_type_mutable *, AssocVector > iterator;
-    typedef detail::AssocVectorLazyIterator< value_type_mutable const *, AssocVector > const_iterator;
+    //
+    // AssocVectorKeysPredicate, key is in a sorted range of keys
+    //
+    // Items have to be visited in increasing order, one copy of predicate per pass.
+    //
+    template<
+          typename _KeyIterator
+        , typename _Cmp
+    >
+    struct AssocVectorKeysPredicate
+    {
+        AssocVectorKeysPredicate(
+              _KeyIterator first
+            , _KeyIterator last
+            , _Cmp const & cmp
+        )
+            : _current( first )
+            , _last( last )
+            , _cmp( cmp )
+        {
+        }
 
-    typedef std::reverse_iterator< iterator > reverse_iterator;
-    typedef std::reverse_iterator< const_iterator > const_reverse_iterator;
+        template< typename _Value >
+        bool operator()( _Value const & value )
+        {
+            while( _current != _last && _cmp( * _current, value.first ) ){
+                ++ _current;
+            }
 
-    typedef array::Array< value_type_mutable > _Storage;
-    typedef array::Array< typename _Storage::const_iterator > _Erased;
+            return _current != _last && _cmp( value.first, * _current ) == false;
+        }
 
-#ifdef AV_ENABLE_EXTENSIONS
-    public:
-#else
     private:
-#endif
+        _KeyIterator _current;
+        _KeyIterator _last;
+        _Cmp _cmp;
+    };
 
     //
-    // extension, faster, non STL compatible version of iterator, working with _find end _end
+    // AssocVectorCursor, visits items of storage and buffer in order skipping erased ones
     //
-    typedef detail::_AssocVectorIterator< value_type_mutable *, AssocVector > _iterator;
-    typedef detail::_AssocVectorIterator< value_type_mutable const *, AssocVector > _const_iterator;
-
-private:
-    struct _FindOrInsertToBufferResult
-    {
-        typename _Storage::iterator _inBuffer;
-        bool _isInserted;
-        bool _isReallocated;
-    };
-
-    struct _TryRemoveBackResult
+    // Lighter than AssocVectorLazyIterator, forward only, no container needed. Storage is visited
+    // in runs which end at the next erased item or before the next buffer key, both found
+    // when a run starts, so next() within a run is one increment and one comparison.
+    //
+    template<
+          typename _Pointer
+        , typename _ErasedIterator
+        , typename _Cmp
+    >
+    struct AssocVectorCursor
     {
-        bool _anyItemRemoved;
-        bool _erasedItemRemoved;
-    };
+        AssocVectorCursor(
+              _Pointer storageFirst
+            , _Pointer storageLast
+            , _Pointer bufferFirst
+            , _Pointer bufferLast
+            , _ErasedIterator erasedFirst
+            , _ErasedIterator erasedLast
+            , _Cmp const & cmp
+        )
+            : _inStorage( storageFirst )
+            , _storageLast( storageLast )
+            , _runLast( storageFirst )
+            , _inBuffer( bufferFirst )
+            , _bufferLast( bufferLast )
+            , _inErased( erasedFirst )
+            , _erasedLast( erasedLast )
+            , _current( 0 )
+            , _cmp( cmp )
+        {
+            nextRun();
+        }
 
-    struct _FindImplResult
-    {
-        typename _Storage::iterator _inStorage;
-        typename _Storage::iterator _inBuffer;
-        typename _Erased::iterator _inErased;
-        typename _Storage::iterator _current;
+        bool done()const
+        {
+            return _current == 0;
+        }
 
-        bool validate()const
+        _Pointer get()const
         {
-            return
-                   ( _current == 0 && _inStorage == 0 && _inBuffer == 0 && _inErased == 0 )
-                || _inStorage != 0;
+            AV_PRECONDITION( done() == false );
+
+            return _current;
         }
-    };
 
-    struct _InsertImplResult
-    {
-        bool _isInserted;
+        void next()
+        {
+            AV_PRECONDITION( done() == false );
 
-        typename _Storage::iterator _inStorage;
-        typename _Storage::iterator _inBuffer;
-        typename _Erased::iterator _inErased;
-        typename _Storage::iterator _current;
+            if( _current == _inStorage )
+            {
+                ++ _inStorage;
 
-        bool validate()const
+                if( _inStorage != _runLast )
+                {
+                    _current = _inStorage;
+
+                    return;
+                }
+            }
+            else
+            {
+                ++ _inBuffer;
+            }
+
+            nextRun();
+        }
+
+        //
+        // for_each, calls f( value ) for all remaining items, storage runs in tight loops
+        //
+        template< typename __Function >
+        void for_each( __Function & f )
         {
-            if( _current == 0 )
+            while( done() == false )
             {
-                AV_ERROR();
+                if( _current == _inStorage )
+                {
+                    for( /*empty*/ ; _inStorage != _runLast ; ++ _inStorage ){
+                        f( * _inStorage );
+                    }
+                }
+                else
+                {
+                    f( * _inBuffer );
 
-                return false;
+                    ++ _inBuffer;
+                }
+
+                nextRun();
+            }
+        }
+
+    private:
+        typedef typename std::iterator_traits< _Pointer >::value_type _Value;
+
+        //
+        // nextRun, the next buffer item or the next run of storage
+        //
+        void nextRun()
+        {
+            while(
+                   _inErased != _erasedLast
+                && _inStorage != _storageLast
+                && * _inErased == _inStorage
+            ){
+                ++ _inStorage;
+                ++ _inErased;
             }
 
-            if( _inStorage == 0 && ( _inBuffer == 0 || _inErased == 0 ) )
+            if(
+                   _inBuffer != _bufferLast
+                && ( _inStorage == _storageLast || _cmp( _inBuffer->first, _inStorage->first ) )
+            ){
+                _current = _inBuffer;
+
+                return;
+            }
+
+            if( _inStorage == _storageLast )
             {
-                AV_ERROR();
+                _current = 0;
 
-                return false;
+                return;
             }
 
-            return true;
-        }
-    };
+            _runLast = _inErased != _erasedLast ? * _inErased : _storageLast;
 
-    struct _TryEraseFromStorageResult
-    {
-        typename _Erased::iterator _inErased;
-        bool _isErased;
-        bool _isMerged;
-    };
+            if( _inBuffer != _bufferLast ){
+                // keys of storage and buffer are distinct, the run is not empty
+                _runLast = std::lower_bound(
+                      _inStorage + 1
+                    , _runLast
+                    , _inBuffer->first
+                    , util::CmpByFirst< _Value, _Cmp >( _cmp )
+                );
+            }
 
-public:
-    //
-    // constructor
-    //
-    explicit
-    AssocVector(
-          _Cmp const & cmp = _Cmp()
-        , _Allocator const & allocator = _Allocator()
-    );
+            _current = _inStorage;
+        }
 
-    explicit
-    AssocVector( _Allocator const & allocator );
+    private:
+        _Pointer _inStorage;
+        _Pointer _storageLast;
 
-    template< typename __InputIterator >
-    AssocVector(
-          __InputIterator first
-        , __InputIterator last
-        , _Cmp const & cmp = _Cmp()
-        , _Allocator const & allocator = _Allocator()
-    );
+        // end of the current run of storage
+        _Pointer _runLast;
 
-    AssocVector( AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other );
-    AssocVector(
-          AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other
-        , _Allocator const & allocator
-    );
+        _Pointer _inBuffer;
+        _Pointer _bufferLast;
 
-    AssocVector( AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other );
-    AssocVector(
-         AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other
-       , _Allocator const & allocator
-    );
+        _ErasedIterator _inErased;
+        _ErasedIterator _erasedLast;
 
-    AssocVector(
-          std::initializer_list< value_type > list
-        , _Cmp const & cmp = _Cmp()
-        , _Allocator const & allocator = _Allocator()
-    );
+        _Pointer _current;
+
+        _Cmp _cmp;
+    };
 
     //
-    // destructor
+    // AssocVectorRange, slices of storage, buffer and erased holding items with keys in [ lo, hi )
     //
-    inline ~AssocVector();
-
-    //
-    // clear
+    // Made of binary searches only, no lazy iterator is built. Items are visited in order with
+    // cursor or for_each. When neither a buffer item nor an erased one falls into the range,
+    // the storage slice is the whole range and span gives it directly.
     //
-    inline void clear() noexcept;
+    template<
+          typename _Pointer
+        , typename _ErasedIterator
+        , typename _Cmp
+    >
+    struct AssocVectorRange
+    {
+        typedef typename std::iterator_traits< _Pointer >::value_type _Value;
+        typedef typename std::iterator_traits< _ErasedIterator >::value_type _Erased;
+
+        typedef AssocVectorCursor< _Pointer, _ErasedIterator, _Cmp > cursor_type;
+        typedef array::Span< _Value const > span_type;
+        typedef array::Span< _Erased const > erased_span_type;
+
+        AssocVectorRange(
+              _Pointer storageFirst
+            , _Pointer storageLast
+            , _Pointer bufferFirst
+            , _Pointer bufferLast
+            , _ErasedIterator erasedFirst
+            , _ErasedIterator erasedLast
+            , _Cmp const & cmp
+        )
+            : _storageFirst( storageFirst )
+            , _storageLast( storageLast )
+            , _bufferFirst( bufferFirst )
+            , _bufferLast( bufferLast )
+            , _erasedFirst( erasedFirst )
+            , _erasedLast( erasedLast )
+            , _cmp( cmp )
+        {
+        }
+
+        //
+        // storage, slice of storage, erased items included
+        //
+        span_type storage()const
+        {
+            return span_type( _storageFirst, _storageLast - _storageFirst );
+        }
+
+        //
+        // buffer, slice of buffer
+        //
+        span_type buffer()const
+        {
+            return span_type( _bufferFirst, _bufferLast - _bufferFirst );
+        }
+
+        //
+        // erased, erased items of the storage slice
+        //
+        erased_span_type erased()const
+        {
+            return erased_span_type( _erasedFirst, _erasedLast - _erasedFirst );
+        }
+
+        //
+        // size, number of items in range, O(1)
+        //
+        std::size_t size()const
+        {
+            return ( _storageLast - _storageFirst ) - ( _erasedLast - _erasedFirst ) + ( _bufferLast - _bufferFirst );
+        }
+
+        bool empty()const
+        {
+            return size() == 0;
+        }
+
+        //
+        // is_contiguous, all items of range are in storage slice, none of them erased
+        //
+        bool is_contiguous()const
+        {
+            return _bufferFirst == _bufferLast && _erasedFirst == _erasedLast;
+        }
+
+        //
+        // span, items of range in order, valid only if range is contiguous
+        //
+        span_type span()const
+        {
+            AV_PRECONDITION( is_contiguous() );
+
+            return storage();
+        }
+
+        //
+        // cursor, merged forward traversal of storage and buffer slices skipping erased items
+        //
+        cursor_type cursor()const
+        {
+            return cursor_type( _storageFirst, _storageLast, _bufferFirst, _bufferLast, _erasedFirst, _erasedLast, _cmp );
+        }
+
+        //
+        // for_each, calls f( value ) for items of range in order
+        //
+        template< typename __Function >
+        __Function for_each( __Function f )const
+        {
+            if( is_contiguous() )
+            {
+                for( _Pointer current = _storageFirst ; current != _storageLast ; ++ current ){
+                    f( * current );
+                }
+
+                return f;
+            }
+
+            cursor_type current = cursor();
+            current.for_each( f );
+
+            return f;
+        }
+
+    private:
+        _Pointer _storageFirst;
+        _Pointer _storageLast;
+
+        _Pointer _bufferFirst;
+        _Pointer _bufferLast;
+
+        _ErasedIterator _erasedFirst;
+        _ErasedIterator _erasedLast;
+
+        _Cmp _cmp;
+    };
 
     //
-    // operator=
+    // AssocVectorSkipExisting, merge drops items which keys are already in container
     //
-    AssocVector & operator=( AssocVector const & other );
-    AssocVector & operator=( AssocVector && other );
+    struct AssocVectorSkipExisting
+    {
+        template<
+              typename _Value
+            , typename _Existing
+        >
+        void operator()( _Value &, _Existing & )const
+        {
+        }
+    };
 
     //
-    // methods
+    // AssocVectorAssignExisting, merge assigns mapped values of items which keys are already in container
     //
-    void reserve( std::size_t newCapacity );
-    void swap( AssocVector & other ) noexcept;
+    struct AssocVectorAssignExisting
+    {
+        template<
+              typename _Value
+            , typename _Existing
+        >
+        void operator()( _Value & value, _Existing & existing )const
+        {
+            existing.second = std::move( value.second );
+        }
+    };
 
     //
-    // iterators
+    // AssocVectorKeepExisting, merge compacts items which keys are already in container
+    // to the front of their flat source storage, relative order is kept
     //
-    inline iterator begin();
-    inline const_iterator begin()const;
-    inline const_iterator cbegin()const;
+    template< typename _Storage >
+    struct AssocVectorKeepExisting
+    {
+        AssocVectorKeepExisting( _Storage & storage )
+            : _storage( storage )
+            , _kept( 0 )
+        {
+        }
 
-    inline reverse_iterator rbegin();
-    inline const_reverse_iterator rbegin()const;
-    inline const_reverse_iterator crbegin()const;
+        template< typename _Existing >
+        void operator()( typename _Storage::value_type & value, _Existing & )
+        {
+            if( & value != & _storage[ _kept ] ){
+                _storage[ _kept ] = AV_MOVE_IF_NOEXCEPT( value );
+            }
 
-    inline iterator end();
-    inline const_iterator end()const;
-    inline const_iterator cend()const;
+            ++ _kept;
+        }
 
-    inline reverse_iterator rend();
-    inline const_reverse_iterator rend()const;
-    inline const_reverse_iterator crend()const;
+        std::size_t kept()const
+        {
+            return _kept;
+        }
 
-    //
-    // size
-    //
-    inline bool empty()const noexcept;
-    inline std::size_t size()const noexcept;
-    inline std::size_t capacity()const noexcept;
-    inline std::size_t max_size()const noexcept;
+    private:
+        _Storage & _storage;
+        std::size_t _kept;
+    };
 
     //
-    // insert
+    // AssocVectorQueryCmp, orders ( key iterator, position ) pairs by key
     //
-    std::pair< iterator, bool > insert( value_type const & value );
+    template< typename _Cmp >
+    struct AssocVectorQueryCmp
+    {
+        AssocVectorQueryCmp( _Cmp const & cmp )
+            : _cmp( cmp )
+        {
+        }
 
-    template< typename __ValueType >
-    std::pair< iterator, bool > insert( __ValueType && value );
+        template< typename _Query >
+        bool operator()( _Query const & lhs, _Query const & rhs )const
+        {
+            return _cmp( * lhs.first, * rhs.first );
+        }
 
-    iterator insert( const_iterator hint, value_type const & value );
+    private:
+        _Cmp _cmp;
+    };
 
-    template< typename __ValueType >
-    iterator insert( const_iterator hint, __ValueType && value );
+} // namespace detail
 
-    template< typename _Iterator >
-    inline void insert( _Iterator first, _Iterator last );
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp = std::less< _Key >
+    , typename _Allocator = std::allocator< std::pair< _Key, _Mapped > >
+>
+struct AssocVector
+{
+private:
+    typedef std::pair< _Key, _Mapped > value_type_mutable;
+    typedef std::pair< _Key const, _Mapped > value_type_key_const;
 
-    inline void insert( std::initializer_list< value_type > list );
+public:
+    typedef _Key key_type;
+    typedef _Mapped mapped_type;
 
-    //
-    // emplace
-    //
-    template< class... __Args >
-    std::pair< iterator, bool > emplace( __Args... args );
+    typedef value_type_key_const value_type;
 
-    template< class... __Args >
-    std::pair< iterator, bool > emplace_hint( const_iterator hint, __Args... args );
+    typedef typename _Allocator::size_type size_type;
+    typedef typename _Allocator::difference_type difference_type;
 
-    //
-    // find
-    //
-    iterator find( key_type const & k );
-    const_iterator find( key_type const & k )const;
+    typedef typename _Allocator::pointer pointer;
+    typedef typename _Allocator::const_pointer const_pointer;
 
-    iterator lower_bound( key_type const & k );
-    const_iterator lower_bound( key_type const & k )const;
+    typedef _Cmp key_compare;
+    typedef util::CmpByFirst< value_type_mutable, _Cmp > value_compare;
 
-    iterator upper_bound( key_type const & k );
-    const_iterator upper_bound( key_type const & k )const;
+    typedef _Allocator allocator_type;
 
-    std::pair< iterator, iterator > equal_range( key_type const & k );
-    std::pair< const_iterator, const_iterator > equal_range( key_type const & k )const;
+    typedef mapped_type & reference;
+    typedef mapped_type const & const_reference;
 
-    //
-    // count
-    //
-    inline std::size_t count( key_type const & k )const;
+    typedef detail::AssocVectorLazyIterator< value_type_mutable *, AssocVector > iterator;
+    typedef detail::AssocVectorLazyIterator< value_type_mutable const *, AssocVector > const_iterator;
+
+    typedef std::reverse_iterator< iterator > reverse_iterator;
+    typedef std::reverse_iterator< const_iterator > const_reverse_iterator;
+
+    typedef array::Array<
+          value_type_mutable
+        , typename _Allocator::template rebind< value_type_mutable >::other
+    > _Storage;
+
+    typedef array::Array<
+          typename _Storage::const_iterator
+        , typename _Allocator::template rebind< typename _Storage::const_iterator >::other
+    > _Erased;
 
     //
-    // operator[]
+    // const_cursor, forward only, faster than const_iterator, see cursor and for_each
     //
-    reference operator[]( key_type const & k );
-    reference operator[]( key_type && k );
+    typedef detail::AssocVectorCursor<
+          typename _Storage::const_iterator
+        , typename _Erased::const_iterator
+        , _Cmp
+    > const_cursor;
 
     //
-    // at
+    // part_type, cursor over one of contiguous parts given by split
     //
-    reference at( key_type const & k );
-    const_reference at( key_type const & k )const;
+    typedef const_cursor part_type;
 
     //
-    // erase
+    // const_range, slices of storage, buffer and erased for keys in [ lo, hi ), see range
     //
-    std::size_t erase( key_type const & k );
-    iterator erase( iterator pos );
+    typedef detail::AssocVectorRange<
+          typename _Storage::const_iterator
+        , typename _Erased::const_iterator
+        , _Cmp
+    > const_range;
 
     //
-    // observers
+    // handle, remembers key and position of an item, see make_handle and resolve
     //
-    key_compare key_comp()const
+    struct handle
     {
-        return _cmp;
-    }
+        key_type const & key()const
+        {
+            return _key;
+        }
 
-    value_compare value_comp()const
-    {
-        return value_compare( _cmp );
-    }
+    private:
+        friend struct AssocVector;
 
-    //allocator_type get_allocator()const
-    //{
-    //    return _allocator;
-    //}
+        handle( key_type const & k )
+            : _key( k )
+            , _generation( 0 )
+            , _index( static_cast< std::size_t >( -1 ) )
+            , _inBuffer( false )
+        {
+        }
+
+        key_type _key;
+        std::size_t _generation;
+        std::size_t _index;
+        bool _inBuffer;
+    };
 
 #ifdef AV_ENABLE_EXTENSIONS
     public:
@@ -2786,183 +4124,1479 @@ public:
 #endif
 
     //
-    // extension, flatenize container, enforce merge of _storage with _erased and with _buffer
+    // extension, faster, non STL compatible version of iterator, working with _find end _end
     //
-    void _merge();
+    typedef detail::_AssocVectorIterator< value_type_mutable *, AssocVector > _iterator;
+    typedef detail::_AssocVectorIterator< value_type_mutable const *, AssocVector > _const_iterator;
 
-    //
-    // extension, faster, non STL compatible version of insert
-    //
-    bool _insert( value_type const & value );
+private:
+    struct _FindOrInsertToBufferResult
+    {
+        typename _Storage::iterator _inBuffer;
+        bool _isInserted;
+        bool _isReallocated;
+    };
 
-    template< typename __ValueType >
-    bool _insert( __ValueType && value );
+    struct _TryRemoveBackResult
+    {
+        bool _anyItemRemoved;
+        bool _erasedItemRemoved;
+    };
 
-    //
-    // extension, faster, non STL compatible version of end, works with _find
-    //
-    inline _iterator _end();
-    inline _const_iterator _end()const;
+    struct _FindManyCursor
+    {
+        typename _Storage::iterator _inStorage;
+        typename _Storage::iterator _inBuffer;
+        typename _Erased::iterator _inErased;
+    };
 
     //
-    // extension, faster, non STL compatible version of find, works with _end
+    // _InsertHint, positions in storage and buffer where a search starts, 0 if unknown
     //
-    _iterator _find( key_type const & k );
-    _const_iterator _find( key_type const & k )const;
+    struct _InsertHint
+    {
+        _InsertHint()
+            : _inStorage( 0 )
+            , _inBuffer( 0 )
+        {
+        }
 
-    //
-    // extension, faster, non STL compatible version of erase
-    //
-    bool _erase( iterator pos );
+        typename _Storage::iterator _inStorage;
+        typename _Storage::iterator _inBuffer;
+    };
 
-private:
-    bool validateStorage()const;
-    bool validateBuffer()const;
-    bool validateErased()const;
-    bool validate()const;
+    struct _FindImplResult
+    {
+        typename _Storage::iterator _inStorage;
+        typename _Storage::iterator _inBuffer;
+        typename _Erased::iterator _inErased;
+        typename _Storage::iterator _current;
 
-    //
-    // merge
-    //
-    void mergeStorageWithBuffer();
-    void mergeStorageWithErased();
+        bool validate()const
+        {
+            return
+                   ( _current == 0 && _inStorage == 0 && _inBuffer == 0 && _inErased == 0 )
+                || _inStorage != 0;
+        }
+    };
+
+    struct _InsertImplResult
+    {
+        bool _isInserted;
+
+        typename _Storage::iterator _inStorage;
+        typename _Storage::iterator _inBuffer;
+        typename _Erased::iterator _inErased;
+        typename _Storage::iterator _current;
+
+        bool validate()const
+        {
+            if( _current == 0 )
+            {
+                AV_ERROR();
+
+                return false;
+            }
+
+            if( _inStorage == 0 && ( _inBuffer == 0 || _inErased == 0 ) )
+            {
+                AV_ERROR();
+
+                return false;
+            }
+
+            return true;
+        }
+    };
+
+    struct _TryEraseFromStorageResult
+    {
+        typename _Erased::iterator _inErased;
+        bool _isErased;
+        bool _isMerged;
+    };
 
+public:
     //
-    // insert
+    // constructor
     //
-    template< typename __ValueType >
-    void pushBack( __ValueType && value );
+    explicit
+    AssocVector(
+          _Cmp const & cmp = _Cmp()
+        , _Allocator const & allocator = _Allocator()
+    );
 
-    template< typename __ValueType >
-    bool shouldBePushBack( __ValueType && value )const;
+    explicit
+    AssocVector( _Allocator const & allocator );
 
-    template< typename __ValueType >
-    _FindOrInsertToBufferResult
-    findOrInsertToBuffer( __ValueType && value );
+    template< typename __InputIterator >
+    AssocVector(
+          __InputIterator first
+        , __InputIterator last
+        , _Cmp const & cmp = _Cmp()
+        , _Allocator const & allocator = _Allocator()
+    );
+
+    AssocVector( AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other );
+    AssocVector(
+          AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other
+        , _Allocator const & allocator
+    );
+
+    AssocVector( AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other );
+    AssocVector(
+         AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other
+       , _Allocator const & allocator
+    );
+
+    AssocVector(
+          std::initializer_list< value_type > list
+        , _Cmp const & cmp = _Cmp()
+        , _Allocator const & allocator = _Allocator()
+    );
 
     //
-    // insertImpl, function does as little as needed but returns as much data as possible
+    // from_sorted_unique, builds container from a range sorted by key without duplicates,
+    // checked in debug only, items are copied into storage in O(N)
     //
-    template< typename __ValueType >
-    _InsertImplResult
-    insertImpl( __ValueType && value );
+    template< typename __InputIterator >
+    static AssocVector from_sorted_unique(
+          __InputIterator first
+        , __InputIterator last
+        , _Cmp const & cmp = _Cmp()
+        , _Allocator const & allocator = _Allocator()
+    );
 
     //
-    // emplace_impl
+    // from_sorted_unique, adopts storage built by a user, no item is copied or moved
     //
-    template< class __Head, class... __Tail >
-    std::pair< iterator, bool > emplaceImpl( __Head && head, __Tail... tail );
+    static AssocVector from_sorted_unique(
+          _Storage && storage
+        , _Cmp const & cmp = _Cmp()
+    );
 
     //
-    // erase
+    // destructor
     //
-    _TryRemoveBackResult
-    tryRemoveStorageBack( typename _Storage::iterator pos );
+    inline ~AssocVector();
 
     //
-    // tryEraseFromStorage
+    // clear
     //
-    _TryEraseFromStorageResult
-    tryEraseFromStorage( typename _Storage::iterator pos );
+    inline void clear() noexcept;
 
     //
-    // isErased
+    // operator=
     //
-    bool isErased( typename _Storage::const_iterator iterator )const;
+    AssocVector & operator=( AssocVector const & other );
+    AssocVector & operator=( AssocVector && other );
 
     //
-    // findImpl, function does as little as needed but returns as much data as possible
+    // methods
     //
-    _FindImplResult
-    findImpl( key_type const & key );
+    void reserve( std::size_t newCapacity );
+    void swap( AssocVector & other ) noexcept;
 
     //
-    // getAllocator (method specialization)
+    // merge, moves items of other which keys are not in container, as std::map::merge does,
+    // other is flattened and both are merged in one pass O(N+M)
     //
-    //_Allocator getAllocator( _Storage const & ){ return _allocator; }
+    void merge( AssocVector & other );
+    void merge( AssocVector && other );
+
     //
-    //typename _Allocator::template rebind< typename _Storage::const_iterator >::other
-    //getAllocator( _Erased const & )
-    //{return typename _Allocator::template rebind< typename _Storage::const_iterator >::other( _allocator );}
+    // absorb, moves all items of other, existing keys win, other is left empty
+    //
+    void absorb( AssocVector && other );
 
-public: // public for unit tests only
-    void dump( int width = -1 )const;
+    //
+    // release_sorted, flattens container and gives its storage away without copying,
+    // container is left empty
+    //
+    _Storage release_sorted();
 
-    std::size_t bufferSize()const{ return _buffer.size(); }
-    std::size_t bufferCapacity()const{ return _buffer.capacity(); }
-    _Storage const & storage()const{ return _storage; }
+    //
+    // sorted_span, flattens container and exposes its storage, valid until next modification
+    //
+    array::Span< value_type_mutable const > sorted_span();
 
-    std::size_t storageSize()const{ return _storage.size(); }
-    std::size_t storageCapacity()const{ return _storage.capacity(); }
-    _Storage const & buffer()const{ return _buffer; }
+    //
+    // sorted_span, container has to be flat already (right after _merge or release_sorted)
+    //
+    array::Span< value_type_mutable const > sorted_span()const;
 
-    std::size_t erasedSize()const{ return _erased.size(); }
-    std::size_t erasedCapacity()const{ return _erased.capacity(); }
-    _Erased const & erased()const{ return _erased; }
+    //
+    // is_flat, storage holds all items, buffer and erased are empty, true right after a merge
+    //
+    inline bool is_flat()const noexcept;
 
-    static std::size_t calculateNewBufferCapacity( std::size_t storageSize );
-    static std::size_t calculateNewErasedCapacity( std::size_t storageSize );
-    static std::size_t calculateNewStorageCapacity( std::size_t storageSize );
+    //
+    // iterators
+    //
+    inline iterator begin();
+    inline const_iterator begin()const;
+    inline const_iterator cbegin()const;
 
-private:
-    _Storage _storage;
-    _Storage _buffer;
-    _Erased _erased;
+    inline reverse_iterator rbegin();
+    inline const_reverse_iterator rbegin()const;
+    inline const_reverse_iterator crbegin()const;
 
-    _Cmp _cmp;
-};
+    inline iterator end();
+    inline const_iterator end()const;
+    inline const_iterator cend()const;
 
-template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
->
-bool operator==(
-      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
-    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
-)
-{
-    if( lhs.size() != rhs.size() ){
-        return false;
-    }
+    inline reverse_iterator rend();
+    inline const_reverse_iterator rend()const;
+    inline const_reverse_iterator crend()const;
 
-    typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator begin = lhs.begin();
-    typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator const end = lhs.end();
+    //
+    // size
+    //
+    inline bool empty()const noexcept;
+    inline std::size_t size()const noexcept;
+    inline std::size_t capacity()const noexcept;
+    inline std::size_t max_size()const noexcept;
 
-    typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator begin2 = rhs.begin();
+    //
+    // insert
+    //
+    std::pair< iterator, bool > insert( value_type const & value );
 
-    for( /*empty*/ ; begin != end ; ++ begin, ++ begin2 )
-    {
-        if( begin->first != begin2->first ){
-            return false;
-        }
+    template< typename __ValueType >
+    std::pair< iterator, bool > insert( __ValueType && value );
 
-        if( begin->second != begin2->second ){
-            return false;
-        }
-    }
+    iterator insert( const_iterator hint, value_type const & value );
 
-    return true;
-}
+    template< typename __ValueType >
+    iterator insert( const_iterator hint, __ValueType && value );
 
-template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
->
-bool operator!=(
-      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
-    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
-)
-{
-    return ! ( lhs == rhs );
-}
+    template< typename _Iterator >
+    inline void insert( _Iterator first, _Iterator last );
 
-//
-// Method Definitions
-//
+    inline void insert( std::initializer_list< value_type > list );
+
+    //
+    // emplace, emplace( key, mapped args... ) or emplace( std::piecewise_construct, key tuple, mapped tuple ),
+    // mapped value is constructed only if key is not present
+    //
+    template< class... __Args >
+    std::pair< iterator, bool > emplace( __Args && ... args );
+
+    template< class... __Args >
+    std::pair< iterator, bool > emplace_hint( const_iterator hint, __Args && ... args );
+
+    //
+    // try_emplace, mapped value is constructed in place only if key is not present
+    //
+    template< class... __Args >
+    std::pair< iterator, bool > try_emplace( key_type const & k, __Args && ... args );
+
+    template< class... __Args >
+    std::pair< iterator, bool > try_emplace( key_type && k, __Args && ... args );
+
+    template< class... __Args >
+    iterator try_emplace( const_iterator hint, key_type const & k, __Args && ... args );
+
+    template< class... __Args >
+    iterator try_emplace( const_iterator hint, key_type && k, __Args && ... args );
+
+    //
+    // insert_or_assign, assigns to mapped value if key is present, inserts otherwise
+    //
+    template< typename __Mapped >
+    std::pair< iterator, bool > insert_or_assign( key_type const & k, __Mapped && m );
+
+    template< typename __Mapped >
+    std::pair< iterator, bool > insert_or_assign( key_type && k, __Mapped && m );
+
+    template< typename __Mapped >
+    iterator insert_or_assign( const_iterator hint, key_type const & k, __Mapped && m );
+
+    template< typename __Mapped >
+    iterator insert_or_assign( const_iterator hint, key_type && k, __Mapped && m );
+
+    //
+    // insert_or_assign_many, as a loop of insert_or_assign, the last of items with equal keys wins,
+    // a range larger than buffer is sorted and merged with the container in one pass
+    //
+    template< typename _Iterator >
+    void insert_or_assign_many( _Iterator first, _Iterator last );
+
+    //
+    // find
+    //
+    iterator find( key_type const & k );
+    const_iterator find( key_type const & k )const;
+
+    iterator lower_bound( key_type const & k );
+    const_iterator lower_bound( key_type const & k )const;
+
+    iterator upper_bound( key_type const & k );
+    const_iterator upper_bound( key_type const & k )const;
+
+    std::pair< iterator, iterator > equal_range( key_type const & k );
+    std::pair< const_iterator, const_iterator > equal_range( key_type const & k )const;
+
+    //
+    // make_handle, handle to an item, O(1) for an iterator, O( log N ) for a key,
+    // a handle to a missing key resolves to null until the key is inserted
+    //
+    handle make_handle( const_iterator pos )const;
+    handle make_handle( key_type const & k )const;
+
+    //
+    // resolve, pointer to mapped value of the handle's item or null if it is not in container,
+    // O(1) while the item has not been moved since the handle was taken, otherwise the key is
+    // looked up in O( log N ) and the handle is rebound to the new position
+    //
+    mapped_type * resolve( handle & h );
+    mapped_type const * resolve( handle & h )const;
+
+    //
+    // generation, changes whenever items of storage are moved or erased, buffer is not tracked
+    //
+    std::size_t generation()const noexcept;
+
+    //
+    // find_many, finds a batch of keys in one sweep with galloping search, O( Q log( N / Q ) )
+    // for a sorted batch, unsorted one is sorted first, results are written in keys order
+    //
+    template<
+          typename _KeyIterator
+        , typename _OutputIterator
+    >
+    _OutputIterator find_many( _KeyIterator first, _KeyIterator last, _OutputIterator out );
+
+    template<
+          typename _KeyIterator
+        , typename _OutputIterator
+    >
+    _OutputIterator find_many( _KeyIterator first, _KeyIterator last, _OutputIterator out )const;
+
+    //
+    // find_many_interleaved, finds an unsorted batch of keys running AV_PREFETCH_GROUP_SIZE
+    // binary searches in lockstep with prefetching, for maps much larger than cache
+    //
+    template<
+          typename _KeyIterator
+        , typename _OutputIterator
+    >
+    _OutputIterator find_many_interleaved( _KeyIterator first, _KeyIterator last, _OutputIterator out );
+
+    template<
+          typename _KeyIterator
+        , typename _OutputIterator
+    >
+    _OutputIterator find_many_interleaved( _KeyIterator first, _KeyIterator last, _OutputIterator out )const;
+
+    //
+    // rank, number of items with keys less than k, O( log N )
+    //
+    std::size_t rank( key_type const & k )const;
+
+    //
+    // nth, iterator to i-th item in order, end() for size(), O( log^2 N ), O(1) when flat,
+    // sorted_span gives random access to a flat container
+    //
+    iterator nth( std::size_t i );
+    const_iterator nth( std::size_t i )const;
+
+    //
+    // split, n cursors over contiguous parts of container in key order, cut points are taken
+    // from storage by index and projected onto buffer and erased by binary search, O( n log N )
+    //
+    std::vector< part_type > split( std::size_t n )const;
+
+    //
+    // cursor, over all items or over items with keys in [ lo, hi ), invalidated by any modification
+    //
+    const_cursor cursor()const;
+    const_cursor cursor( key_type const & lo, key_type const & hi )const;
+
+    //
+    // range, view of items with keys in [ lo, hi ) found with four binary searches in O( log N ),
+    // no iterator is built, invalidated by any modification
+    //
+    const_range range( key_type const & lo, key_type const & hi )const;
+
+    //
+    // for_each, calls f( std::pair< key_type, mapped_type > const & ) in key order,
+    // runs of storage between erased items and buffer keys are visited in tight loops
+    //
+    template< typename _Function >
+    _Function for_each( _Function f )const;
+
+    //
+    // for_each_in_range, for_each over items with keys in [ lo, hi )
+    //
+    template< typename _Function >
+    _Function for_each_in_range( key_type const & lo, key_type const & hi, _Function f )const;
+
+    //
+    // aggregate, folds mapped values of items with keys in [ lo, hi ), op has to be associative
+    // and commutative, storage runs between erased items are folded with util::fold_second
+    //
+    template<
+          typename _T
+        , typename _BinaryOp
+    >
+    _T aggregate( key_type const & lo, key_type const & hi, _T init, _BinaryOp op )const;
+
+    //
+    // count
+    //
+    inline std::size_t count( key_type const & k )const;
+
+    //
+    // count, number of items with keys in [ lo, hi ), O( log N )
+    //
+    std::size_t count( key_type const & lo, key_type const & hi )const;
+
+    //
+    // count_many, see find_many
+    //
+    template<
+          typename _KeyIterator
+        , typename _OutputIterator
+    >
+    _OutputIterator count_many( _KeyIterator first, _KeyIterator last, _OutputIterator out )const;
+
+    //
+    // operator[]
+    //
+    reference operator[]( key_type const & k );
+    reference operator[]( key_type && k );
+
+    //
+    // at
+    //
+    reference at( key_type const & k );
+    const_reference at( key_type const & k )const;
+
+    //
+    // erase
+    //
+    std::size_t erase( key_type const & k );
+    iterator erase( iterator pos );
+    iterator erase( const_iterator first, const_iterator last );
+
+    //
+    // erase_if, erases items for which pred( value_type const & ) is true, one pass, O(N)
+    //
+    template< typename _Pred >
+    std::size_t erase_if( _Pred pred );
+
+    //
+    // erase_keys, erases items with keys from a sorted range of keys
+    //
+    template< typename _KeyIterator >
+    std::size_t erase_keys( _KeyIterator first, _KeyIterator last );
+
+    //
+    // observers
+    //
+    key_compare key_comp()const
+    {
+        return _cmp;
+    }
+
+    value_compare value_comp()const
+    {
+        return value_compare( _cmp );
+    }
+
+    //allocator_type get_allocator()const
+    //{
+    //    return _allocator;
+    //}
+
+#ifdef AV_ENABLE_EXTENSIONS
+    public:
+#else
+    private:
+#endif
+
+    //
+    // extension, flatenize container, enforce merge of _storage with _erased and with _buffer
+    //
+    void _merge();
+
+    //
+    // extension, faster, non STL compatible version of insert
+    //
+    bool _insert( value_type const & value );
+
+    template< typename __ValueType >
+    bool _insert( __ValueType && value );
+
+    //
+    // extension, faster, non STL compatible version of end, works with _find
+    //
+    inline _iterator _end();
+    inline _const_iterator _end()const;
+
+    //
+    // extension, faster, non STL compatible version of find, works with _end
+    //
+    _iterator _find( key_type const & k );
+    _const_iterator _find( key_type const & k )const;
+
+    //
+    // extension, faster, non STL compatible version of erase
+    //
+    bool _erase( iterator pos );
+
+private:
+    bool validateStorage()const;
+    bool validateBuffer()const;
+    bool validateErased()const;
+    bool validate()const;
+
+    //
+    // merge
+    //
+    void mergeStorageWithBuffer();
+    void mergeStorageWithErased();
+
+    //
+    // copy
+    //
+    void rebaseErased( AssocVector const & other );
+
+    //
+    // mergeWithSortedUnique, merges flat container with sorted unique range, existing items win,
+    // onExisting( item, existing ) is called for items which keys are already in container
+    //
+    template< typename _Iterator >
+    void mergeWithSortedUnique( _Iterator first, _Iterator last );
+
+    template<
+          typename _Iterator
+        , typename _OnExisting
+    >
+    void mergeWithSortedUnique( _Iterator first, _Iterator last, _OnExisting & onExisting );
+
+    //
+    // adoptSortedUnique, replaces content with sorted unique storage
+    //
+    void adoptSortedUnique( _Storage && storage );
+
+    //
+    // compact, removes erased items and items matching pred from storage and buffer
+    //
+    template< typename _Pred >
+    std::size_t compact( _Pred const & pred );
+
+    //
+    // insert
+    //
+    template< typename __ValueType >
+    void pushBack( __ValueType && value );
+
+    template< typename __ValueType >
+    bool shouldBePushBack( __ValueType && value )const;
+
+    template< typename __ValueType >
+    _FindOrInsertToBufferResult
+    findOrInsertToBuffer( __ValueType && value, typename _Storage::iterator hint );
+
+    //
+    // insertImpl, function does as little as needed but returns as much data as possible
+    //
+    template< typename __ValueType >
+    _InsertImplResult
+    insertImpl( __ValueType && value );
+
+    template< typename __ValueType >
+    _InsertImplResult
+    insertImpl( __ValueType && value, _InsertHint const & hint );
+
+    //
+    // toInsertHint, hint positions taken from an iterator, only these inside arrays are used
+    //
+    _InsertHint toInsertHint( const_iterator hint );
+
+    //
+    // lowerBoundWithHint, O(1) for an exact hint, O( log( distance ) ) from hint otherwise
+    //
+    typename _Storage::iterator
+    lowerBoundWithHint(
+          _Storage & array
+        , typename _Storage::iterator hint
+        , key_type const & k
+    );
+
+    //
+    // emplace_impl
+    //
+    template< class __Head, class... __Tail >
+    std::pair< iterator, bool > emplaceImpl( _InsertHint const & hint, __Head && head, __Tail && ... tail );
+
+    template< class __KeyTuple, class __MappedTuple >
+    std::pair< iterator, bool > emplaceImpl(
+          _InsertHint const & hint
+        , std::piecewise_construct_t
+        , __KeyTuple && keyArgs
+        , __MappedTuple && mappedArgs
+    );
+
+    //
+    // tryEmplaceImpl, probes with findImpl, builds item on miss only
+    //
+    template< class __KeyType, class... __Args >
+    std::pair< iterator, bool > tryEmplaceImpl( _InsertHint const & hint, __KeyType && k, __Args && ... args );
+
+    //
+    // insertOrAssignImpl
+    //
+    template< class __KeyType, class __Mapped >
+    std::pair< iterator, bool > insertOrAssignImpl( _InsertHint const & hint, __KeyType && k, __Mapped && m );
+
+    //
+    // erase
+    //
+    _TryRemoveBackResult
+    tryRemoveStorageBack( typename _Storage::iterator pos );
+
+    //
+    // tryEraseFromStorage
+    //
+    _TryEraseFromStorageResult
+    tryEraseFromStorage( typename _Storage::iterator pos );
+
+    //
+    // isErased
+    //
+    bool isErased( typename _Storage::const_iterator iterator )const;
+
+    //
+    // bindHandle, points handle to an item of storage or buffer at current generation
+    //
+    void bindHandle( handle & h, typename _Storage::const_iterator current )const;
+
+    //
+    // findImpl, function does as little as needed but returns as much data as possible
+    //
+    _FindImplResult
+    findImpl( key_type const & key );
+
+    _FindImplResult
+    findImpl( key_type const & key, _InsertHint const & hint );
+
+    //
+    // findImpl, cursor based version for sorted batches, cursor moves forward only
+    //
+    _FindImplResult
+    findImpl( key_type const & key, _FindManyCursor & cursor );
+
+    //
+    // countNotErasedBefore, number of not erased items in storage before pos
+    //
+    std::size_t countNotErasedBefore( typename _Storage::const_iterator pos )const;
+
+    //
+    // nthImpl, same shape as findImpl result, zeros for end
+    //
+    _FindImplResult nthImpl( std::size_t i );
+
+    //
+    // findManyImpl, results in keys order
+    //
+    template< typename _KeyIterator >
+    void findManyImpl(
+          _KeyIterator first
+        , _KeyIterator last
+        , std::vector< _FindImplResult > & results
+    );
+
+    //
+    // findInterleavedImpl, up to AV_PREFETCH_GROUP_SIZE keys
+    //
+    void findInterleavedImpl(
+          _Key const * const * keys
+        , std::size_t count
+        , _FindImplResult * results
+    );
+
+    //
+    // toIterators, converts findImpl results into iterators
+    //
+    template< typename _OutputIterator >
+    _OutputIterator toIterators(
+          std::vector< _FindImplResult > const & results
+        , _OutputIterator out
+    );
+
+    //
+    // getAllocator (method specialization)
+    //
+    //_Allocator getAllocator( _Storage const & ){ return _allocator; }
+    //
+    //typename _Allocator::template rebind< typename _Storage::const_iterator >::other
+    //getAllocator( _Erased const & )
+    //{return typename _Allocator::template rebind< typename _Storage::const_iterator >::other( _allocator );}
+
+public: // public for unit tests only
+    void dump( int width = -1 )const;
+
+    std::size_t bufferSize()const{ return _buffer.size(); }
+    std::size_t bufferCapacity()const{ return _buffer.capacity(); }
+    _Storage const & storage()const{ return _storage; }
+
+    std::size_t storageSize()const{ return _storage.size(); }
+    std::size_t storageCapacity()const{ return _storage.capacity(); }
+    _Storage const & buffer()const{ return _buffer; }
+
+    std::size_t erasedSize()const{ return _erased.size(); }
+    std::size_t erasedCapacity()const{ return _erased.capacity(); }
+    _Erased const & erased()const{ return _erased; }
+
+    static std::size_t calculateNewBufferCapacity( std::size_t storageSize );
+    static std::size_t calculateNewErasedCapacity( std::size_t storageSize );
+    static std::size_t calculateNewStorageCapacity( std::size_t storageSize );
+
+private:
+    _Storage _storage;
+    _Storage _buffer;
+    _Erased _erased;
+
+    // bumped whenever an item of storage is moved or marked as erased, see resolve
+    std::size_t _generation;
+
+    _Cmp _cmp;
+};
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool operator==(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+)
+{
+    if( lhs.size() != rhs.size() ){
+        return false;
+    }
+
+    typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator begin = lhs.begin();
+    typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator const end = lhs.end();
+
+    typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator begin2 = rhs.begin();
+
+    for( /*empty*/ ; begin != end ; ++ begin, ++ begin2 )
+    {
+        if( begin->first != begin2->first ){
+            return false;
+        }
+
+        if( begin->second != begin2->second ){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool operator!=(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+)
+{
+    return ! ( lhs == rhs );
+}
+
+//
+// Method Definitions
+//
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+      _Cmp const & cmp
+    , _Allocator const & allocator
+)
+    : _storage( allocator )
+    , _buffer( allocator )
+    , _erased( allocator )
+    , _generation( 0 )
+    , _cmp( cmp )
+{
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector( _Allocator const & allocator )
+    : _storage( allocator )
+    , _buffer( allocator )
+    , _erased( allocator )
+    , _generation( 0 )
+{
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename __InputIterator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+      __InputIterator first
+    , __InputIterator last
+    , _Cmp const & cmp
+    , _Allocator const & allocator
+)
+    : _storage( allocator )
+    , _buffer( allocator )
+    , _erased( allocator )
+    , _generation( 0 )
+    , _cmp( cmp )
+{
+    insert( first, last );
+
+    AV_POSTCONDITION( validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+    AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other
+)
+    : _storage( other._storage )
+    , _buffer( other._buffer )
+    , _erased( other._erased )
+    , _generation( other._generation )
+    , _cmp( other._cmp )
+{
+    rebaseErased( other );
+
+    AV_POSTCONDITION( validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other
+    , _Allocator const & allocator
+)
+    : _storage( other._storage, allocator )
+    , _buffer( other._buffer, allocator )
+    , _erased( other._erased, allocator )
+    , _generation( other._generation )
+    , _cmp( other._cmp )
+{
+    rebaseErased( other );
+
+    AV_POSTCONDITION( validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+    AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other
+)
+    : _storage( std::move( other._storage ) )
+    , _buffer( std::move( other._buffer ) )
+    , _erased( std::move( other._erased ) )
+    , _generation( other._generation )
+    , _cmp( other._cmp )
+{
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other
+    , _Allocator const & allocator
+)
+    : _storage( std::move( other._storage ) )
+    , _buffer( std::move( other._buffer ) )
+    , _erased( std::move( other._erased ) )
+    , _generation( other._generation )
+    , _cmp( other._cmp )
+{
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
+      std::initializer_list< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::value_type > list
+    , _Cmp const & cmp
+    , _Allocator const & allocator
+)
+    : _storage( allocator )
+    , _buffer( allocator )
+    , _erased( allocator )
+    , _generation( 0 )
+    , _cmp( cmp )
+{
+    insert( list );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename __InputIterator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::from_sorted_unique(
+      __InputIterator first
+    , __InputIterator const last
+    , _Cmp const & cmp
+    , _Allocator const & allocator
+)
+{
+    AV_PRECONDITION( std::distance( first, last ) >= 0 );
+
+    AssocVector result( cmp, allocator );
+
+    _Storage storage( std::distance( first, last ), result._storage.get_allocator() );
+
+    for( /*empty*/ ; first != last ; ++ first ){
+        storage.place_back( * first );
+    }
+
+    result.adoptSortedUnique( std::move( storage ) );
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::from_sorted_unique(
+      _Storage && storage
+    , _Cmp const & cmp
+)
+{
+    AssocVector result( cmp, _Allocator( storage.get_allocator() ) );
+
+    result.adoptSortedUnique( std::move( storage ) );
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::~AssocVector()
+{
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::clear() noexcept
+{
+    util::destroy_range( _storage.begin(), _storage.end() );
+    util::destroy_range( _buffer.begin(), _buffer.end() );
+
+    _storage.setSize( 0 );
+    _buffer.setSize( 0 );
+    _erased.setSize( 0 );
+
+    ++ _generation;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator > &
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::operator=( AssocVector const & other )
+{
+    AssocVector temp( other );
+    temp.swap( * this );
+
+    return * this;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator > &
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::operator=( AssocVector && other )
+{
+    AssocVector temp( std::move( other ) );
+
+    temp.swap( * this );
+
+    return * this;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reserve( std::size_t newStorageCapacity )
+{
+    if( _storage.get_allocator().max_size() < newStorageCapacity ){
+        throw std::length_error( "AssocVector< _K, _M, _C, _A >::reserve" );
+    }
+
+    if( util::less_equal( newStorageCapacity, _storage.capacity() ) ){
+        return;
+    }
+
+    // buffer is merged into storage, both of them have to fit
+    newStorageCapacity = std::max( newStorageCapacity, size() );
+
+    {// _erased
+        if( _erased.empty() == false ){
+            mergeStorageWithErased();
+        }
+
+        _erased.reserve( calculateNewErasedCapacity( newStorageCapacity ) );
+
+        AV_CHECK( _erased.empty() );
+    }
+
+    std::size_t const newBufferCapacity
+        = calculateNewBufferCapacity( newStorageCapacity );
+
+    if( _Storage::can_reallocate )
+    {
+        _storage.reserve( newStorageCapacity );
+
+        mergeStorageWithBuffer();
+
+        _Storage newBuffer( newBufferCapacity, _buffer.get_allocator() );
+        newBuffer.swap( _buffer );
+
+        AV_POSTCONDITION( _buffer.empty() );
+        AV_POSTCONDITION( validate() );
+
+        return;
+    }
+
+    std::size_t const newStorageSize = _storage.size() + _buffer.size();
+
+    {
+        _Storage newStorage( newStorageCapacity, _storage.get_allocator() );
+        _Storage newBuffer( newBufferCapacity, _buffer.get_allocator() );
+
+        util::move_merge_into_uninitialized(
+              _storage.begin()
+            , _storage.end()
+            , _buffer.begin()
+            , _buffer.end()
+            , newStorage.begin()
+            , value_comp()
+        );
+
+        newStorage.swap( _storage );
+        newBuffer.swap( _buffer );
+    }// call newStorage newBuffer destructors
+
+    _storage.setSize( newStorageSize );
+
+    ++ _generation;
+
+    AV_POSTCONDITION( _buffer.empty() );
+    AV_POSTCONDITION( validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::begin()
+{
+    return iterator( this, _storage.begin(), _buffer.begin(), _erased.begin(), 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reverse_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rbegin()
+{
+    return reverse_iterator( end() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::begin()const
+{
+    return const_iterator( this, _storage.begin(), _buffer.begin(), _erased.begin(), 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::cbegin()const
+{
+    return begin();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rbegin()const
+{
+    return const_reverse_iterator( end() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::crbegin()const
+{
+    return rbegin();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::end()
+{
+    return iterator( this, _storage.end(), _buffer.end(), _erased.end(), 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reverse_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rend()
+{
+    return reverse_iterator( begin() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::end()const
+{
+    return const_iterator( this, _storage.end(), _buffer.end(), _erased.end(), 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::cend()const
+{
+    return end();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rend()const
+{
+    return const_reverse_iterator( begin() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::crend()const
+{
+    return rend();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_end()
+{
+    return _iterator( 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_end()const
+{
+    return _const_iterator( 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::empty()const noexcept
+{
+    return size() == 0;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::size()const noexcept
+{
+    return _storage.size() + _buffer.size() - _erased.size();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::capacity()const noexcept
+{
+    return _storage.capacity() + _buffer.capacity();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::max_size()const noexcept
+{
+    return _storage.get_allocator().max_size();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( value_type const & value )
+{
+    _InsertImplResult const result = insertImpl( value );
+
+    return std::make_pair(
+          iterator(
+              this
+            , result._inStorage
+            , result._inBuffer
+            , result._inErased
+            , result._current
+          )
+        , result._isInserted
+    );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename __ValueType
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( __ValueType && value )
+{
+    _InsertImplResult const result = insertImpl( std::forward< __ValueType >( value ) );
+
+    return std::make_pair(
+          iterator(
+              this
+            , result._inStorage
+            , result._inBuffer
+            , result._inErased
+            , result._current
+          )
+        , result._isInserted
+    );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert(
+      typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator hint
+    , value_type const & value
+)
+{
+    _InsertImplResult const result = insertImpl( value, toInsertHint( hint ) );
+
+    return iterator(
+          this
+        , result._inStorage
+        , result._inBuffer
+        , result._inErased
+        , result._current
+    );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename __ValueType
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert(
+      const_iterator hint
+    , __ValueType && value
+)
+{
+    _InsertImplResult const result = insertImpl( std::forward< __ValueType >( value ), toInsertHint( hint ) );
+
+    return iterator(
+          this
+        , result._inStorage
+        , result._inBuffer
+        , result._inErased
+        , result._current
+    );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert(
+    std::initializer_list< value_type > list
+)
+{
+    insert( list.begin(), list.end() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_insert( value_type const & value )
+{
+    return insertImpl( value )._isInserted;
+}
 
 template<
       typename _Key
@@ -2970,12 +5604,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-      _Cmp const & cmp
-    , _Allocator const & allocator
-)
-    : _cmp( cmp )
+template<
+    typename __ValueType
+>
+bool
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_insert( __ValueType && value )
 {
+    return insertImpl( std::forward< __ValueType >( value ) )._isInserted;
 }
 
 template<
@@ -2984,8 +5619,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector( _Allocator const & allocator )
+template<
+    typename __ValueType
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_InsertImplResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insertImpl( __ValueType && value )
 {
+    return insertImpl( std::forward< __ValueType >( value ), _InsertHint() );
 }
 
 template<
@@ -2995,30 +5635,127 @@ template<
     , typename _Allocator
 >
 template<
-    typename __InputIterator
+    typename __ValueType
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-      __InputIterator first
-    , __InputIterator last
-    , _Cmp const & cmp
-    , _Allocator const & allocator
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_InsertImplResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insertImpl(
+      __ValueType && value
+    , _InsertHint const & hint
 )
-    : _cmp( cmp )
 {
-    AV_PRECONDITION( std::distance( first, last ) >= 0 );
+    _Key const & k = value.first;
 
-    std::size_t const size = std::distance( first, last );
+    {//push back to storage
+        if( shouldBePushBack( value ) )
+        {
+            pushBack( std::forward< __ValueType >( value ) );
 
-    if( size > 0 )
-    {
-        reserve( size );
+            _InsertImplResult result;
 
-        for( /*empty*/ ; first != last ; ++ first ){
-            insert( * first );
+            {
+                AV_CHECK( _storage.empty() == false );
+
+                result._inStorage = ( _storage.end() - 1 );
+                result._current = ( _storage.end() - 1 );
+            }
+
+            result._isInserted = true;
+            result._inBuffer = 0;
+            result._inErased = _erased.end();
+
+            AV_POSTCONDITION( result.validate() );
+            AV_POSTCONDITION( validate() );
+
+            return result;
         }
     }
 
-    AV_POSTCONDITION( validate() );
+    typename _Storage::iterator const greaterEqualInStorage
+        = lowerBoundWithHint( _storage, hint._inStorage, k );
+
+    bool const notPresentInStorage
+        = greaterEqualInStorage == _storage.end()
+        || key_comp()( k, greaterEqualInStorage->first );
+
+    {//find or insert to buffer
+        if( notPresentInStorage )
+        {
+            _FindOrInsertToBufferResult const findOrInsertToBufferResult
+                = findOrInsertToBuffer( std::forward< __ValueType >( value ), hint._inBuffer );
+
+            _InsertImplResult result;
+            result._isInserted = findOrInsertToBufferResult._isInserted;
+
+            if( findOrInsertToBufferResult._isReallocated )
+            {
+                result._inStorage = 0;
+                result._inErased = _erased.end();
+            }
+            else
+            {
+                result._inStorage = greaterEqualInStorage;
+                result._inErased = 0;
+            }
+
+            result._inBuffer = findOrInsertToBufferResult._inBuffer;
+            result._current = findOrInsertToBufferResult._inBuffer;
+
+            AV_POSTCONDITION( result.validate() );
+            AV_POSTCONDITION( validate() );
+
+            return result;
+        }
+    }
+
+    {// check if not erased
+        typename _Erased::iterator const greaterEqualInErased = std::lower_bound(
+              _erased.begin()
+            , _erased.end()
+            , greaterEqualInStorage
+            , std::less< typename _Storage::const_iterator >()
+        );
+
+        bool const itemNotMarkedAsErased
+            = greaterEqualInErased == _erased.end()
+            || std::less< typename _Storage::const_iterator >()
+                    ( greaterEqualInStorage, * greaterEqualInErased );
+
+        if( itemNotMarkedAsErased )
+        {// item is in storage and is not marked as erased
+            _InsertImplResult result;
+            result._isInserted = false;
+            result._inStorage = greaterEqualInStorage;
+            result._inBuffer = 0;
+            result._inErased = greaterEqualInErased;
+            result._current = greaterEqualInStorage;
+
+            AV_POSTCONDITION( result.validate() );
+            AV_POSTCONDITION( validate() );
+
+            return result;
+        }
+        else
+        {// item is in storage but is marked as erased
+           _erased.erase( greaterEqualInErased );
+
+            greaterEqualInStorage->second = std::forward< __ValueType >( value ).second;
+
+            _InsertImplResult result;
+            result._isInserted = true;
+            result._inStorage = greaterEqualInStorage;
+            result._inBuffer = 0;
+
+            // greaterEqualInErased is after 'Array::erase' but still valid
+            result._inErased = greaterEqualInErased;
+
+            result._current = greaterEqualInStorage;
+
+            AV_POSTCONDITION( validate() );
+            AV_POSTCONDITION( result.validate() );
+
+            return result;
+        }
+    }
 }
 
 template<
@@ -3027,31 +5764,38 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-    AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other
-)
-    : _storage( other._storage )
-    , _buffer( other._buffer )
-    , _erased( other._erased )
-    , _cmp( other._cmp )
-{
-}
-
 template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
+    typename _Iterator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & other
-    , _Allocator const & allocator
-)
-    : _storage( other._storage, allocator )
-    , _buffer( other._buffer, allocator )
-    , _erased( other._erased, allocator )
-    , _cmp( other._cmp, allocator )
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( _Iterator const begin, _Iterator const end )
 {
+    typedef std::vector< value_type_mutable > Input;
+
+    Input input( begin, end );
+
+    if( util::less_equal( input.size(), _buffer.capacity() ) )
+    {
+        // each item costs at most sqrt( storage.capacity ) moves in buffer,
+        // cheaper than rebuilding the whole storage
+        for( typename Input::iterator current = input.begin() ; current != input.end() ; ++ current ){
+            insertImpl( std::move( * current ) );
+        }
+
+        return;
+    }
+
+    if( std::is_sorted( input.begin(), input.end(), value_comp() ) == false ){
+        // stable, the first of items with equal keys is inserted as in a loop of inserts
+        std::stable_sort( input.begin(), input.end(), value_comp() );
+    }
+
+    input.erase(
+          util::unique_sorted( input.begin(), input.end(), value_comp() )
+        , input.end()
+    );
+
+    mergeWithSortedUnique( input.begin(), input.end() );
 }
 
 template<
@@ -3060,14 +5804,54 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-    AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other
-)
-    : _storage( std::move( other._storage ) )
-    , _buffer( std::move( other._buffer ) )
-    , _erased( std::move( other._erased ) )
-    , _cmp( other._cmp )
+template<
+    typename _Iterator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign_many( _Iterator const first, _Iterator const last )
 {
+    typedef std::vector< value_type_mutable > Input;
+
+    Input input( first, last );
+
+    if( util::less_equal( input.size(), _buffer.capacity() ) )
+    {
+        // see insert( first, last )
+        for( typename Input::iterator current = input.begin() ; current != input.end() ; ++ current ){
+            insert_or_assign( std::move( current->first ), std::move( current->second ) );
+        }
+
+        return;
+    }
+
+    if( std::is_sorted( input.begin(), input.end(), value_comp() ) == false ){
+        // stable, the last of items with equal keys is the last one in input
+        std::stable_sort( input.begin(), input.end(), value_comp() );
+    }
+
+    typename Input::iterator unique = input.begin();
+
+    for( typename Input::iterator current = input.begin() ; current != input.end() ; ++ current )
+    {
+        typename Input::iterator const next = current + 1;
+
+        if( next != input.end() && value_comp()( * current, * next ) == false ){
+            // not the last of equal keys
+            continue;
+        }
+
+        if( unique != current ){
+            * unique = std::move( * current );
+        }
+
+        ++ unique;
+    }
+
+    input.erase( unique, input.end() );
+
+    detail::AssocVectorAssignExisting assignExisting;
+
+    mergeWithSortedUnique( input.begin(), input.end(), assignExisting );
 }
 
 template<
@@ -3076,15 +5860,18 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-      AssocVector< _Key, _Mapped, _Cmp, _Allocator > && other
-    , _Allocator const & allocator
+template<
+    typename _Iterator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::mergeWithSortedUnique(
+      _Iterator first
+    , _Iterator const last
 )
-    : _storage( std::move( other._storage ) )
-    , _buffer( std::move( other._buffer ) )
-    , _erased( std::move( other._erased ) )
-    , _cmp( other._cmp )
 {
+    detail::AssocVectorSkipExisting skipExisting;
+
+    mergeWithSortedUnique( first, last, skipExisting );
 }
 
 template<
@@ -3093,16 +5880,74 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::AssocVector(
-      std::initializer_list< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::value_type > list
-    , _Cmp const & cmp
-    , _Allocator const & allocator
+template<
+      typename _Iterator
+    , typename _OnExisting
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::mergeWithSortedUnique(
+      _Iterator first
+    , _Iterator const last
+    , _OnExisting & onExisting
 )
-    : _cmp( cmp )
 {
-    reserve( list.size() );
+    AV_PRECONDITION( std::distance( first, last ) >= 0 );
+
+    if( first == last ){
+        return;
+    }
+
+    std::size_t const newStorageCapacity
+        = std::max< std::size_t >( _storage.capacity(), size() + std::distance( first, last ) );
+
+    _Storage newStorage( newStorageCapacity, _storage.get_allocator() );
+
+    {// may throw
+        iterator current = begin();
+        iterator const end = this->end();
+
+        while( current != end )
+        {
+            // for '++ current' object has still exist and can not be moved before
+            typename iterator::pointer_mutable const current_raw_ptr = current.getCurrent();
+
+            while( first != last && value_comp()( * first, * current_raw_ptr ) )
+            {
+                newStorage.place_back( AV_MOVE_IF_NOEXCEPT( * first ) );
+
+                ++ first;
+            }
+
+            if( first != last && value_comp()( * current_raw_ptr, * first ) == false ){
+                // key is already in container
+                onExisting( * first, * current_raw_ptr );
+
+                ++ first;
+            }
+
+            ++ current;
+
+            newStorage.place_back( AV_MOVE_IF_NOEXCEPT( * current_raw_ptr ) );
+        }
+
+        for( /*empty*/ ; first != last ; ++ first ){
+            newStorage.place_back( AV_MOVE_IF_NOEXCEPT( * first ) );
+        }
+    }
 
-    insert( list );
+    _Storage newBuffer( calculateNewBufferCapacity( newStorageCapacity ), _buffer.get_allocator() );
+    _Erased newErased( calculateNewErasedCapacity( newStorageCapacity ), _erased.get_allocator() );
+
+    newStorage.swap( _storage );
+    newBuffer.swap( _buffer );
+    newErased.swap( _erased );
+
+    ++ _generation;
+
+    AV_POSTCONDITION( _buffer.empty() );
+    AV_POSTCONDITION( _erased.empty() );
+
+    AV_POSTCONDITION( validate() );
 }
 
 template<
@@ -3111,8 +5956,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::~AssocVector()
+template<
+    class... __Args
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplace( __Args && ... args )
 {
+    return emplaceImpl( _InsertHint(), std::forward< __Args >( args )... );
 }
 
 template<
@@ -3121,15 +5971,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-void
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::clear() noexcept
+template<
+    class... __Args
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplace_hint( const_iterator hint, __Args && ... args )
 {
-    util::destroy_range( _storage.begin(), _storage.end() );
-    util::destroy_range( _buffer.begin(), _buffer.end() );
-
-    _storage.setSize( 0 );
-    _buffer.setSize( 0 );
-    _erased.setSize( 0 );
+    return emplaceImpl( toInsertHint( hint ), std::forward< __Args >( args )... );
 }
 
 template<
@@ -3138,13 +5986,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator > &
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::operator=( AssocVector const & other )
+template<
+    class... __Args
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::try_emplace( key_type const & k, __Args && ... args )
 {
-    AssocVector temp( other );
-    temp.swap( * this );
-
-    return * this;
+    return tryEmplaceImpl( _InsertHint(), k, std::forward< __Args >( args )... );
 }
 
 template<
@@ -3153,14 +6001,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator > &
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::operator=( AssocVector && other )
+template<
+    class... __Args
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::try_emplace( key_type && k, __Args && ... args )
 {
-    AssocVector temp( std::move( other ) );
-
-    temp.swap( * this );
-
-    return * this;
+    return tryEmplaceImpl( _InsertHint(), std::move( k ), std::forward< __Args >( args )... );
 }
 
 template<
@@ -3169,53 +6016,17 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-void
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reserve( std::size_t newStorageCapacity )
+template<
+    class... __Args
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::try_emplace(
+      const_iterator hint
+    , key_type const & k
+    , __Args && ... args
+)
 {
-    if( _storage.get_allocator().max_size() < newStorageCapacity ){
-        throw std::length_error( "AssocVector< _K, _M, _C, _A >::reserve" );
-    }
-
-    if( util::less_equal( newStorageCapacity, _storage.capacity() ) ){
-        return;
-    }
-
-    {// _erased
-        if( _erased.empty() == false ){
-            mergeStorageWithErased();
-        }
-
-        _erased.reserve( calculateNewErasedCapacity( newStorageCapacity ) );
-
-        AV_CHECK( _erased.empty() );
-    }
-
-    std::size_t const newBufferCapacity
-        = calculateNewBufferCapacity( newStorageCapacity );
-
-    std::size_t const newStorageSize = _storage.size() + _buffer.size();
-
-    {
-        _Storage newStorage( newStorageCapacity, _storage.get_allocator() );
-        _Storage newBuffer( newBufferCapacity, _buffer.get_allocator() );
-
-        util::move_merge_into_uninitialized(
-              _storage.begin()
-            , _storage.end()
-            , _buffer.begin()
-            , _buffer.end()
-            , newStorage.begin()
-            , value_comp()
-        );
-
-        newStorage.swap( _storage );
-        newBuffer.swap( _buffer );
-    }// call newStorage newBuffer destructors
-
-    _storage.setSize( newStorageSize );
-
-    AV_POSTCONDITION( _buffer.empty() );
-    AV_POSTCONDITION( validate() );
+    return tryEmplaceImpl( toInsertHint( hint ), k, std::forward< __Args >( args )... ).first;
 }
 
 template<
@@ -3224,10 +6035,17 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
+template<
+    class... __Args
+>
 typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::begin()
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::try_emplace(
+      const_iterator hint
+    , key_type && k
+    , __Args && ... args
+)
 {
-    return iterator( this, _storage.begin(), _buffer.begin(), _erased.begin(), 0 );
+    return tryEmplaceImpl( toInsertHint( hint ), std::move( k ), std::forward< __Args >( args )... ).first;
 }
 
 template<
@@ -3236,10 +6054,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reverse_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rbegin()
+template<
+    typename __Mapped
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign( key_type const & k, __Mapped && m )
 {
-    return reverse_iterator( end() );
+    return insertOrAssignImpl( _InsertHint(), k, std::forward< __Mapped >( m ) );
 }
 
 template<
@@ -3248,10 +6069,13 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::begin()const
+template<
+    typename __Mapped
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign( key_type && k, __Mapped && m )
 {
-    return const_iterator( this, _storage.begin(), _buffer.begin(), _erased.begin(), 0 );
+    return insertOrAssignImpl( _InsertHint(), std::move( k ), std::forward< __Mapped >( m ) );
 }
 
 template<
@@ -3260,10 +6084,17 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::cbegin()const
+template<
+    typename __Mapped
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign(
+      const_iterator hint
+    , key_type const & k
+    , __Mapped && m
+)
 {
-    return begin();
+    return insertOrAssignImpl( toInsertHint( hint ), k, std::forward< __Mapped >( m ) ).first;
 }
 
 template<
@@ -3272,10 +6103,17 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rbegin()const
+template<
+    typename __Mapped
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign(
+      const_iterator hint
+    , key_type && k
+    , __Mapped && m
+)
 {
-    return const_reverse_iterator( end() );
+    return insertOrAssignImpl( toInsertHint( hint ), std::move( k ), std::forward< __Mapped >( m ) ).first;
 }
 
 template<
@@ -3284,10 +6122,18 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::crbegin()const
+template<
+      class __Head
+    , class... __Tail
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplaceImpl(
+      _InsertHint const & hint
+    , __Head && head
+    , __Tail && ... tail
+)
 {
-    return rbegin();
+    return tryEmplaceImpl( hint, key_type( std::forward< __Head >( head ) ), std::forward< __Tail >( tail )... );
 }
 
 template<
@@ -3296,10 +6142,37 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::end()
+template<
+      class __KeyTuple
+    , class __MappedTuple
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplaceImpl(
+      _InsertHint const & hint
+    , std::piecewise_construct_t
+    , __KeyTuple && keyArgs
+    , __MappedTuple && mappedArgs
+)
 {
-    return iterator( this, _storage.end(), _buffer.end(), _erased.end(), 0 );
+    _InsertImplResult const result = insertImpl(
+          value_type_mutable(
+              std::piecewise_construct
+            , std::forward< __KeyTuple >( keyArgs )
+            , std::forward< __MappedTuple >( mappedArgs )
+          )
+        , hint
+    );
+
+    return std::make_pair(
+          iterator(
+              this
+            , result._inStorage
+            , result._inBuffer
+            , result._inErased
+            , result._current
+          )
+        , result._isInserted
+    );
 }
 
 template<
@@ -3308,10 +6181,56 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reverse_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rend()
+template<
+      class __KeyType
+    , class... __Args
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::tryEmplaceImpl(
+      _InsertHint const & hint
+    , __KeyType && k
+    , __Args && ... args
+)
 {
-    return reverse_iterator( begin() );
+    {// key is present, nothing is constructed
+        _FindImplResult const found = findImpl( k, hint );
+
+        if( found._current != 0 )
+        {
+            return std::make_pair(
+                  iterator(
+                      this
+                    , found._inStorage
+                    , found._inBuffer
+                    , found._inErased
+                    , found._current
+                  )
+                , false
+            );
+        }
+    }
+
+    _InsertImplResult const result = insertImpl(
+          value_type_mutable(
+              std::piecewise_construct
+            , std::forward_as_tuple( std::forward< __KeyType >( k ) )
+            , std::forward_as_tuple( std::forward< __Args >( args )... )
+          )
+        , hint
+    );
+
+    AV_CHECK( result._isInserted );
+
+    return std::make_pair(
+          iterator(
+              this
+            , result._inStorage
+            , result._inBuffer
+            , result._inErased
+            , result._current
+          )
+        , true
+    );
 }
 
 template<
@@ -3320,10 +6239,54 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::end()const
+template<
+      class __KeyType
+    , class __Mapped
+>
+std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insertOrAssignImpl(
+      _InsertHint const & hint
+    , __KeyType && k
+    , __Mapped && m
+)
 {
-    return const_iterator( this, _storage.end(), _buffer.end(), _erased.end(), 0 );
+    {// key is present, mapped value is assigned
+        _FindImplResult const found = findImpl( k, hint );
+
+        if( found._current != 0 )
+        {
+            found._current->second = std::forward< __Mapped >( m );
+
+            return std::make_pair(
+                  iterator(
+                      this
+                    , found._inStorage
+                    , found._inBuffer
+                    , found._inErased
+                    , found._current
+                  )
+                , false
+            );
+        }
+    }
+
+    _InsertImplResult const result = insertImpl(
+          value_type_mutable( std::forward< __KeyType >( k ), std::forward< __Mapped >( m ) )
+        , hint
+    );
+
+    AV_CHECK( result._isInserted );
+
+    return std::make_pair(
+          iterator(
+              this
+            , result._inStorage
+            , result._inBuffer
+            , result._inErased
+            , result._current
+          )
+        , true
+    );
 }
 
 template<
@@ -3332,10 +6295,47 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::cend()const
+template<
+    typename __ValueType
+>
+bool
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::shouldBePushBack( __ValueType && value )const
 {
-    return end();
+    bool pushBackToStorage = false;
+
+    {// should be pushed back
+        if( _storage.empty() )
+        {
+            if( _buffer.empty() ){
+                pushBackToStorage = true;
+            }
+            else
+            {
+                if( _cmp( _buffer.back().first, value.first ) ){
+                    pushBackToStorage = true;
+                }
+            }
+        }
+        else
+        {
+            if( _buffer.empty() )
+            {
+                if( _cmp( _storage.back().first, value.first ) ){
+                    pushBackToStorage = true;
+                }
+            }
+            else
+            {
+                if(  _cmp( _storage.back().first, value.first )
+                  && _cmp( _buffer.back().first, value.first )
+                ){
+                    pushBackToStorage = true;
+                }
+            }
+        }
+    }
+
+    return pushBackToStorage;
 }
 
 template<
@@ -3344,22 +6344,92 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rend()const
-{
-    return const_reverse_iterator( begin() );
-}
-
 template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
+    typename __ValueType
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reverse_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::crend()const
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::pushBack( __ValueType && value )
 {
-    return rend();
+    if( _storage.size() != _storage.capacity() ){
+        _storage.place_back( std::forward< __ValueType >( value ) );
+
+        AV_POSTCONDITION( validate() );
+
+        return;
+    }
+
+    std::size_t const newStorageCapacity = calculateNewStorageCapacity( _storage.capacity() );
+    std::size_t const newBufferCapacity = calculateNewBufferCapacity( newStorageCapacity );
+    std::size_t const newErasedCapacity = calculateNewErasedCapacity( newStorageCapacity );
+
+    if( util::less_equal( newStorageCapacity, _storage.capacity() ) ){
+        return;
+    }
+
+    if( _storage.get_allocator().max_size() < newStorageCapacity ){
+        throw std::length_error( "AssocVector::reserve" );
+    }
+
+    if( _Storage::can_reallocate )
+    {
+        _Storage newBuffer( newBufferCapacity, _buffer.get_allocator() );
+        _Erased newErased( newErasedCapacity, _erased.get_allocator() );
+
+        if( _erased.empty() == false ){
+            mergeStorageWithErased();
+        }
+
+        // storage grows in place, no item is moved one by one unless realloc has to
+        _storage.reserve( newStorageCapacity );
+
+        mergeStorageWithBuffer();
+
+        newBuffer.swap( _buffer );
+        newErased.swap( _erased );
+
+        // may throw an exception in __ValueType copy constructor, container stays valid
+        _storage.place_back( std::forward< __ValueType >( value ) );
+
+        AV_POSTCONDITION( _buffer.empty() );
+        AV_POSTCONDITION( _erased.empty() );
+
+        AV_POSTCONDITION( validate() );
+
+        return;
+    }
+
+    _Storage newStorage( newStorageCapacity, _storage.get_allocator() );
+    _Storage newBuffer( newBufferCapacity, _buffer.get_allocator() );
+    _Erased newErased( newErasedCapacity, _erased.get_allocator() );
+
+    {// may throw
+        iterator current = begin();
+        iterator const end = this->end();
+
+        while( current != end )
+        {
+            // for '++ current' object has still exist and can not be moved before
+            typename iterator::pointer_mutable const current_raw_ptr = current.getCurrent();
+
+            ++ current;
+
+            newStorage.place_back( AV_MOVE_IF_NOEXCEPT( * current_raw_ptr ) );
+        }
+    }
+
+    // may throw an exception in __ValueType copy constructor, not exception safe
+    newStorage.place_back( std::forward< __ValueType >( value ) );
+
+    newStorage.swap( _storage );
+    newBuffer.swap( _buffer );
+    newErased.swap( _erased );
+
+    ++ _generation;
+
+    AV_POSTCONDITION( _buffer.empty() );
+    AV_POSTCONDITION( _erased.empty() );
+
+    AV_POSTCONDITION( validate() );
 }
 
 template<
@@ -3368,10 +6438,49 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_end()
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_TryRemoveBackResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::tryRemoveStorageBack(
+    typename _Storage::iterator pos
+)
 {
-    return _iterator( 0 );
+    if( pos + 1 != _storage.end() )
+    {
+        _TryRemoveBackResult result;
+        result._anyItemRemoved = false;
+        result._erasedItemRemoved = false;
+
+        return result;
+    }
+
+    _storage.get_allocator().destroy( pos );
+
+    _storage.setSize( _storage.size() - 1 );
+
+    ++ _generation;
+
+    if(
+           _erased.empty() == false
+        && _erased.back() == pos
+    )
+    {
+        _erased.setSize( _erased.size() - 1 );
+
+        _TryRemoveBackResult result;
+        result._anyItemRemoved = true;
+        result._erasedItemRemoved = true;
+
+        AV_POSTCONDITION( validate() );
+
+        return result;
+    }
+
+    _TryRemoveBackResult result;
+    result._anyItemRemoved = true;
+    result._erasedItemRemoved = false;
+
+    AV_POSTCONDITION( validate() );
+
+    return result;
 }
 
 template<
@@ -3380,10 +6489,44 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_const_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_end()const
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_TryEraseFromStorageResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::tryEraseFromStorage(
+    typename _Storage::iterator pos
+)
 {
-    return _const_iterator( 0 );
+    std::pair< typename _Erased::iterator, bool > const insertInSortedResult
+        = array::insert_in_sorted(
+              _erased
+            , typename _Storage::const_iterator( pos )
+            , std::less< typename _Storage::const_iterator >()
+        );
+
+    ++ _generation;
+
+    if( _erased.full() )
+    {
+        mergeStorageWithErased();
+
+        _TryEraseFromStorageResult result;
+        result._inErased = _erased.end();
+        result._isErased = true;
+        result._isMerged = true;
+
+        AV_POSTCONDITION( validate() );
+
+        return result;
+    }
+    else
+    {
+        _TryEraseFromStorageResult result;
+        result._inErased = insertInSortedResult.first;
+        result._isErased = insertInSortedResult.second;
+        result._isMerged = false;
+
+        AV_POSTCONDITION( validate() );
+
+        return result;
+    }
 }
 
 template<
@@ -3393,21 +6536,18 @@ template<
     , typename _Allocator
 >
 bool
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::empty()const noexcept
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::isErased(
+    typename AssocVector::_Storage::const_iterator iterator
+)const
 {
-    return size() == 0;
-}
+    typename _Erased::const_iterator const foundInErased = array::binary_search(
+          _erased.begin()
+        , _erased.end()
+        , iterator
+        , std::less< typename _Storage::const_iterator >()
+    );
 
-template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
->
-std::size_t
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::size()const noexcept
-{
-    return _storage.size() + _buffer.size() - _erased.size();
+    return foundInErased != _erased.end();
 }
 
 template<
@@ -3416,45 +6556,28 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-std::size_t
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::capacity()const noexcept
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::bindHandle(
+      handle & h
+    , typename AssocVector::_Storage::const_iterator current
+)const
 {
-    return _storage.capacity() + _buffer.capacity();
-}
+    std::less< typename _Storage::const_iterator > const less;
 
-template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
->
-std::size_t
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::max_size()const noexcept
-{
-    return _storage.get_allocator().max_size();
-}
+    if( less( current, _storage.begin() ) == false && less( current, _storage.end() ) )
+    {
+        h._index = current - _storage.begin();
+        h._inBuffer = false;
+    }
+    else
+    {
+        AV_CHECK( less( current, _buffer.begin() ) == false && less( current, _buffer.end() ) );
 
-template<
-      typename _Key
-    , typename _Mapped
-    , typename _Cmp
-    , typename _Allocator
->
-std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( value_type const & value )
-{
-    _InsertImplResult const result = insertImpl( value );
+        h._index = current - _buffer.begin();
+        h._inBuffer = true;
+    }
 
-    return std::make_pair(
-          iterator(
-              this
-            , result._inStorage
-            , result._inBuffer
-            , result._inErased
-            , result._current
-          )
-        , result._isInserted
-    );
+    h._generation = _generation;
 }
 
 template<
@@ -3462,25 +6585,11 @@ template<
     , typename _Mapped
     , typename _Cmp
     , typename _Allocator
->
-template<
-    typename __ValueType
->
-std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( __ValueType && value )
-{
-    _InsertImplResult const result = insertImpl( std::forward< __ValueType >( value ) );
-
-    return std::make_pair(
-          iterator(
-              this
-            , result._inStorage
-            , result._inBuffer
-            , result._inErased
-            , result._current
-          )
-        , result._isInserted
-    );
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_FindImplResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findImpl( _Key const & k )
+{
+    return findImpl( k, _InsertHint() );
 }
 
 template<
@@ -3489,23 +6598,96 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert(
-      typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator hint
-    , value_type const & value
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_FindImplResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findImpl(
+      _Key const & k
+    , _InsertHint const & hint
 )
 {
-    ( void )( hint );
+    typename _Storage::iterator const greaterEqualInStorage
+        = lowerBoundWithHint( _storage, hint._inStorage, k );
 
-    _InsertImplResult const result = insertImpl( value );
+    bool const presentInStorage
+        = greaterEqualInStorage != _storage.end()
+        && key_comp()( k, greaterEqualInStorage->first ) == false;
 
-    return iterator(
-          this
-        , result._inStorage
-        , result._inBuffer
-        , result._inErased
-        , result._current
-    );
+    {// item is in storage, check in erased
+        if( presentInStorage )
+        {
+            typename _Erased::iterator greaterEqualInErased = std::lower_bound(
+                  _erased.begin()
+                , _erased.end()
+                , greaterEqualInStorage
+                , std::less< typename _Storage::const_iterator >()
+            );
+
+            bool const itemNotMarkedAsErased
+                = greaterEqualInErased == _erased.end()
+                || std::less< typename _Storage::const_iterator >()(
+                         greaterEqualInStorage
+                       , * greaterEqualInErased
+                   );
+
+            if( itemNotMarkedAsErased )
+            {
+                _FindImplResult result;
+                result._inStorage = greaterEqualInStorage;
+                result._inBuffer = 0;
+                result._inErased = greaterEqualInErased;
+                result._current = greaterEqualInStorage;
+
+                AV_POSTCONDITION( result.validate() );
+
+                return result;
+            }
+            else
+            {
+                _FindImplResult result;
+                result._inStorage = 0;
+                result._inBuffer = 0;
+                result._inErased = 0;
+                result._current = 0;
+
+                AV_POSTCONDITION( result.validate() );
+
+                return result;
+            }
+        }
+    }
+
+    {// check in buffer
+        typename _Storage::iterator const greaterEqualInBuffer
+            = lowerBoundWithHint( _buffer, hint._inBuffer, k );
+
+        bool const presentInBuffer
+            = greaterEqualInBuffer != _buffer.end()
+            && key_comp()( k, greaterEqualInBuffer->first ) == false;
+
+        if( presentInBuffer )
+        {
+            _FindImplResult result;
+            result._inStorage = greaterEqualInStorage;
+            result._inBuffer = greaterEqualInBuffer;
+            result._inErased = 0;
+            result._current = greaterEqualInBuffer;
+
+            AV_POSTCONDITION( result.validate() );
+
+            return result;
+        }
+        else
+        {
+            _FindImplResult result;
+            result._inStorage = 0;
+            result._inBuffer = 0;
+            result._inErased = 0;
+            result._current = 0;
+
+            AV_POSTCONDITION( result.validate() );
+
+            return result;
+        }
+    }
 }
 
 template<
@@ -3514,26 +6696,70 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-template<
-    typename __ValueType
->
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert(
-      const_iterator hint
-    , __ValueType && value
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_FindImplResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findImpl(
+      _Key const & k
+    , _FindManyCursor & cursor
 )
 {
-    ( void )( hint );
+    cursor._inStorage = util::gallop_lower_bound( cursor._inStorage, _storage.end(), k, value_comp() );
 
-    _InsertImplResult const result = insertImpl( std::forward< __ValueType >( value ) );
+    typename _Storage::iterator const greaterEqualInStorage = cursor._inStorage;
 
-    return iterator(
-          this
-        , result._inStorage
-        , result._inBuffer
-        , result._inErased
-        , result._current
-    );
+    bool const presentInStorage
+        = greaterEqualInStorage != _storage.end()
+        && key_comp()( k, greaterEqualInStorage->first ) == false;
+
+    _FindImplResult result;
+    result._inStorage = 0;
+    result._inBuffer = 0;
+    result._inErased = 0;
+    result._current = 0;
+
+    if( presentInStorage )
+    {
+        cursor._inErased = util::gallop_lower_bound(
+              cursor._inErased
+            , _erased.end()
+            , greaterEqualInStorage
+            , std::less< typename _Storage::const_iterator >()
+        );
+
+        bool const itemNotMarkedAsErased
+            = cursor._inErased == _erased.end()
+            || std::less< typename _Storage::const_iterator >()(
+                     greaterEqualInStorage
+                   , * cursor._inErased
+               );
+
+        if( itemNotMarkedAsErased )
+        {
+            result._inStorage = greaterEqualInStorage;
+            result._inErased = cursor._inErased;
+            result._current = greaterEqualInStorage;
+        }
+
+        AV_POSTCONDITION( result.validate() );
+
+        return result;
+    }
+
+    cursor._inBuffer = util::gallop_lower_bound( cursor._inBuffer, _buffer.end(), k, value_comp() );
+
+    bool const presentInBuffer
+        = cursor._inBuffer != _buffer.end()
+        && key_comp()( k, cursor._inBuffer->first ) == false;
+
+    if( presentInBuffer )
+    {
+        result._inStorage = greaterEqualInStorage;
+        result._inBuffer = cursor._inBuffer;
+        result._current = cursor._inBuffer;
+    }
+
+    AV_POSTCONDITION( result.validate() );
+
+    return result;
 }
 
 template<
@@ -3542,12 +6768,21 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-void
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert(
-    std::initializer_list< value_type > list
-)
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::countNotErasedBefore(
+    typename _Storage::const_iterator pos
+)const
 {
-    insert( list.begin(), list.end() );
+    AV_PRECONDITION( util::is_between( _storage.begin(), pos, _storage.end() ) );
+
+    typename _Erased::const_iterator const erasedBefore = std::lower_bound(
+          _erased.begin()
+        , _erased.end()
+        , pos
+        , std::less< typename _Storage::const_iterator >()
+    );
+
+    return ( pos - _storage.begin() ) - ( erasedBefore - _erased.begin() );
 }
 
 template<
@@ -3556,10 +6791,18 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-bool
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_insert( value_type const & value )
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rank( key_type const & k )const
 {
-    return insertImpl( value )._isInserted;
+    typename _Storage::const_iterator const greaterEqualInStorage
+        = std::lower_bound( _storage.begin(), _storage.end(), k, value_comp() );
+
+    typename _Storage::const_iterator const greaterEqualInBuffer
+        = std::lower_bound( _buffer.begin(), _buffer.end(), k, value_comp() );
+
+    return
+          countNotErasedBefore( greaterEqualInStorage )
+        + ( greaterEqualInBuffer - _buffer.begin() );
 }
 
 template<
@@ -3568,13 +6811,17 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-template<
-    typename __ValueType
->
-bool
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_insert( __ValueType && value )
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::count(
+      key_type const & lo
+    , key_type const & hi
+)const
 {
-    return insertImpl( std::forward< __ValueType >( value ) )._isInserted;
+    if( key_comp()( lo, hi ) == false ){
+        return 0;
+    }
+
+    return rank( hi ) - rank( lo );
 }
 
 template<
@@ -3584,125 +6831,109 @@ template<
     , typename _Allocator
 >
 template<
-    typename __ValueType
+      typename _T
+    , typename _BinaryOp
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_InsertImplResult
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insertImpl( __ValueType && value )
+_T
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::aggregate(
+      key_type const & lo
+    , key_type const & hi
+    , _T init
+    , _BinaryOp op
+)const
 {
-    _Key const & k = value.first;
-    _Mapped const & m = value.second;
-
-    {//push back to storage
-        if( shouldBePushBack( value ) )
-        {
-            pushBack( std::forward< __ValueType >( value ) );
-
-            _InsertImplResult result;
-
-            {
-                AV_CHECK( _storage.empty() == false );
-
-                result._inStorage = ( _storage.end() - 1 );
-                result._current = ( _storage.end() - 1 );
-            }
-
-            result._isInserted = true;
-            result._inBuffer = 0;
-            result._inErased = _erased.end();
-
-            AV_POSTCONDITION( result.validate() );
-            AV_POSTCONDITION( validate() );
-
-            return result;
-        }
+    if( key_comp()( lo, hi ) == false ){
+        return init;
     }
 
-    typename _Storage::iterator const greaterEqualInStorage
-        = std::lower_bound( _storage.begin(), _storage.end(), k, value_comp() );
-
-    bool const notPresentInStorage
-        = greaterEqualInStorage == _storage.end()
-        || key_comp()( k, greaterEqualInStorage->first );
-
-    {//find or insert to buffer
-        if( notPresentInStorage )
-        {
-            _FindOrInsertToBufferResult const findOrInsertToBufferResult
-                = findOrInsertToBuffer( std::forward< __ValueType >( value ) );
-
-            _InsertImplResult result;
-            result._isInserted = findOrInsertToBufferResult._isInserted;
-
-            if( findOrInsertToBufferResult._isReallocated )
-            {
-                result._inStorage = 0;
-                result._inErased = _erased.end();
-            }
-            else
-            {
-                result._inStorage = greaterEqualInStorage;
-                result._inErased = 0;
-            }
-
-            result._inBuffer = findOrInsertToBufferResult._inBuffer;
-            result._current = findOrInsertToBufferResult._inBuffer;
-
-            AV_POSTCONDITION( result.validate() );
-            AV_POSTCONDITION( validate() );
+    {// storage, runs between erased items
+        typename _Storage::const_iterator current
+            = std::lower_bound( _storage.begin(), _storage.end(), lo, value_comp() );
 
-            return result;
-        }
-    }
+        typename _Storage::const_iterator const last
+            = std::lower_bound( current, _storage.end(), hi, value_comp() );
 
-    {// check if not erased
-        typename _Erased::iterator const greaterEqualInErased = std::lower_bound(
+        typename _Erased::const_iterator erased = std::lower_bound(
               _erased.begin()
             , _erased.end()
-            , greaterEqualInStorage
+            , current
             , std::less< typename _Storage::const_iterator >()
         );
 
-        bool const itemNotMarkedAsErased
-            = greaterEqualInErased == _erased.end()
-            || std::less< typename _Storage::const_iterator >()
-                    ( greaterEqualInStorage, * greaterEqualInErased );
+        for( /*empty*/ ; erased != _erased.end() && * erased < last ; ++ erased )
+        {
+            init = util::fold_second( current, * erased, init, op );
 
-        if( itemNotMarkedAsErased )
-        {// item is in storage and is not marked as erased
-            _InsertImplResult result;
-            result._isInserted = false;
-            result._inStorage = greaterEqualInStorage;
-            result._inBuffer = 0;
-            result._inErased = greaterEqualInErased;
-            result._current = greaterEqualInStorage;
+            current = * erased + 1;
+        }
+
+        init = util::fold_second( current, last, init, op );
+    }
 
-            AV_POSTCONDITION( result.validate() );
-            AV_POSTCONDITION( validate() );
+    {// buffer
+        typename _Storage::const_iterator const first
+            = std::lower_bound( _buffer.begin(), _buffer.end(), lo, value_comp() );
 
-            return result;
-        }
-        else
-        {// item is in storage but is marked as erased
-           _erased.erase( greaterEqualInErased );
+        typename _Storage::const_iterator const last
+            = std::lower_bound( first, _buffer.end(), hi, value_comp() );
 
-            greaterEqualInStorage->second = m;
+        init = util::fold_second( first, last, init, op );
+    }
 
-            _InsertImplResult result;
-            result._isInserted = true;
-            result._inStorage = greaterEqualInStorage;
-            result._inBuffer = 0;
+    return init;
+}
 
-            // greaterEqualInErased is after 'Array::erase' but still valid
-            result._inErased = greaterEqualInErased;
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::vector< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::part_type >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::split( std::size_t n )const
+{
+    AV_PRECONDITION( n > 0 );
 
-            result._current = greaterEqualInStorage;
+    std::vector< part_type > result;
+    result.reserve( n );
 
-            AV_POSTCONDITION( validate() );
-            AV_POSTCONDITION( result.validate() );
+    typename _Storage::const_iterator storageFirst = _storage.begin();
+    typename _Storage::const_iterator bufferFirst = _buffer.begin();
+    typename _Erased::const_iterator erasedFirst = _erased.begin();
 
-            return result;
+    for( std::size_t part = 1 ; part <= n ; ++ part )
+    {
+        typename _Storage::const_iterator storageLast = _storage.end();
+        typename _Storage::const_iterator bufferLast = _buffer.end();
+        typename _Erased::const_iterator erasedLast = _erased.end();
+
+        if( part < n && _storage.empty() ){
+            // nothing to cut by, buffer is cut by index
+            bufferLast = _buffer.begin() + part * _buffer.size() / n;
+        }
+        else if( part < n )
+        {
+            storageLast = _storage.begin() + part * _storage.size() / n;
+
+            // buffer items less than the cut point belong to the part before
+            bufferLast = std::lower_bound( bufferFirst, _buffer.end(), storageLast->first, value_comp() );
+
+            erasedLast = std::lower_bound(
+                  erasedFirst
+                , _erased.end()
+                , storageLast
+                , std::less< typename _Storage::const_iterator >()
+            );
         }
+
+        result.push_back( part_type( storageFirst, storageLast, bufferFirst, bufferLast, erasedFirst, erasedLast, key_comp() ) );
+
+        storageFirst = storageLast;
+        bufferFirst = bufferLast;
+        erasedFirst = erasedLast;
     }
+
+    return result;
 }
 
 template<
@@ -3711,15 +6942,18 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-template<
-    typename _Iterator
->
-void
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( _Iterator const begin, _Iterator const end )
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_cursor
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::cursor()const
 {
-    for( _Iterator current = begin ; current != end ; ++ current ){
-        insert( * current );
-    }
+    return const_cursor(
+          _storage.begin()
+        , _storage.end()
+        , _buffer.begin()
+        , _buffer.end()
+        , _erased.begin()
+        , _erased.end()
+        , key_comp()
+    );
 }
 
 template<
@@ -3728,13 +6962,58 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_cursor
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::cursor(
+      key_type const & lo
+    , key_type const & hi
+)const
+{
+    return range( lo, hi ).cursor();
+}
+
 template<
-    class... __Args
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
 >
-std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplace( __Args... args )
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_range
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::range(
+      key_type const & lo
+    , key_type const & hi
+)const
 {
-    return emplaceImpl( args... );
+    if( key_comp()( lo, hi ) == false ){
+        return const_range( _storage.end(), _storage.end(), _buffer.end(), _buffer.end(), _erased.end(), _erased.end(), key_comp() );
+    }
+
+    typename _Storage::const_iterator const storageFirst
+        = std::lower_bound( _storage.begin(), _storage.end(), lo, value_comp() );
+
+    typename _Storage::const_iterator const storageLast
+        = std::lower_bound( storageFirst, _storage.end(), hi, value_comp() );
+
+    typename _Storage::const_iterator const bufferFirst
+        = std::lower_bound( _buffer.begin(), _buffer.end(), lo, value_comp() );
+
+    typename _Storage::const_iterator const bufferLast
+        = std::lower_bound( bufferFirst, _buffer.end(), hi, value_comp() );
+
+    typename _Erased::const_iterator const erasedFirst = std::lower_bound(
+          _erased.begin()
+        , _erased.end()
+        , storageFirst
+        , std::less< typename _Storage::const_iterator >()
+    );
+
+    typename _Erased::const_iterator const erasedLast = std::lower_bound(
+          erasedFirst
+        , _erased.end()
+        , storageLast
+        , std::less< typename _Storage::const_iterator >()
+    );
+
+    return const_range( storageFirst, storageLast, bufferFirst, bufferLast, erasedFirst, erasedLast, key_comp() );
 }
 
 template<
@@ -3744,14 +7023,15 @@ template<
     , typename _Allocator
 >
 template<
-    class... __Args
+    typename _Function
 >
-std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplace_hint( const_iterator hint, __Args... args )
+_Function
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::for_each( _Function f )const
 {
-    ( void )( hint );
+    const_cursor current = cursor();
+    current.for_each( f );
 
-    return emplaceImpl( args... );
+    return f;
 }
 
 template<
@@ -3761,25 +7041,16 @@ template<
     , typename _Allocator
 >
 template<
-      class __Head
-    , class... __Tail
+    typename _Function
 >
-std::pair< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator, bool >
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::emplaceImpl( __Head && head, __Tail... tail )
+_Function
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::for_each_in_range(
+      key_type const & lo
+    , key_type const & hi
+    , _Function f
+)const
 {
-    _InsertImplResult const result
-        = insertImpl( value_type_mutable( key_type( head ), mapped_type( tail... ) ) );
-
-    return std::make_pair(
-          iterator(
-              this
-            , result._inStorage
-            , result._inBuffer
-            , result._inErased
-            , result._current
-          )
-        , result._isInserted
-    );
+    return range( lo, hi ).for_each( f );
 }
 
 template<
@@ -3788,47 +7059,24 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-template<
-    typename __ValueType
->
-bool
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::shouldBePushBack( __ValueType && value )const
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::nth( std::size_t i )
 {
-    bool pushBackToStorage = false;
+    AV_PRECONDITION( i <= size() );
 
-    {// should be pushed back
-        if( _storage.empty() )
-        {
-            if( _buffer.empty() ){
-                pushBackToStorage = true;
-            }
-            else
-            {
-                if( _cmp( _buffer.back().first, value.first ) ){
-                    pushBackToStorage = true;
-                }
-            }
-        }
-        else
-        {
-            if( _buffer.empty() )
-            {
-                if( _cmp( _storage.back().first, value.first ) ){
-                    pushBackToStorage = true;
-                }
-            }
-            else
-            {
-                if(  _cmp( _storage.back().first, value.first )
-                  && _cmp( _buffer.back().first, value.first )
-                ){
-                    pushBackToStorage = true;
-                }
-            }
-        }
+    if( i == size() ){
+        return end();
     }
 
-    return pushBackToStorage;
+    _FindImplResult const result = nthImpl( i );
+
+    return iterator(
+          this
+        , result._inStorage
+        , result._inBuffer
+        , result._inErased
+        , result._current
+    );
 }
 
 template<
@@ -3837,62 +7085,108 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-template<
-    typename __ValueType
->
-void
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::pushBack( __ValueType && value )
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::nth( std::size_t i )const
 {
-    if( _storage.size() != _storage.capacity() ){
-        _storage.place_back( std::forward< __ValueType >( value ) );
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
 
-        AV_POSTCONDITION( validate() );
+    return const_cast< NonConstThis >( this )->nth( i );
+}
 
-        return;
-    }
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_FindImplResult
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::nthImpl( std::size_t i )
+{
+    AV_PRECONDITION( i < size() );
 
-    std::size_t const newStorageCapacity = calculateNewStorageCapacity( _storage.capacity() );
-    std::size_t const newBufferCapacity = calculateNewBufferCapacity( newStorageCapacity );
-    std::size_t const newErasedCapacity = calculateNewErasedCapacity( newStorageCapacity );
+    _FindImplResult result;
 
-    if( util::less_equal( newStorageCapacity, _storage.capacity() ) ){
-        return;
-    }
+    {// i-th item is in buffer if its rank is i
+        std::size_t lower = 0;
+        std::size_t upper = _buffer.size();
 
-    if( _storage.get_allocator().max_size() < newStorageCapacity ){
-        throw std::length_error( "AssocVector::reserve" );
-    }
+        // first item in buffer with rank greater or equal to i
+        while( lower < upper )
+        {
+            std::size_t const middle = lower + ( upper - lower ) / 2;
 
-    _Storage newStorage( newStorageCapacity, _storage.get_allocator() );
-    _Storage newBuffer( newBufferCapacity, _buffer.get_allocator() );
-    _Erased newErased( newErasedCapacity, _erased.get_allocator() );
+            typename _Storage::const_iterator const greaterEqualInStorage = std::lower_bound(
+                  _storage.begin()
+                , _storage.end()
+                , _buffer[ middle ].first
+                , value_comp()
+            );
 
-    {// may throw
-        iterator current = begin();
-        iterator const end = this->end();
+            if( middle + countNotErasedBefore( greaterEqualInStorage ) < i ){
+                lower = middle + 1;
+            }
+            else{
+                upper = middle;
+            }
+        }
 
-        while( current != end )
+        if( lower < _buffer.size() )
         {
-            // for '++ current' object has still exist and can not be moved before
-            typename iterator::pointer_mutable const current_raw_ptr = current.getCurrent();
+            typename _Storage::iterator const greaterEqualInStorage = std::lower_bound(
+                  _storage.begin()
+                , _storage.end()
+                , _buffer[ lower ].first
+                , value_comp()
+            );
 
-            ++ current;
+            if( lower + countNotErasedBefore( greaterEqualInStorage ) == i )
+            {
+                result._inStorage = greaterEqualInStorage;
+                result._inBuffer = _buffer.begin() + lower;
+                result._inErased = 0;
+                result._current = _buffer.begin() + lower;
 
-            newStorage.place_back( AV_MOVE_IF_NOEXCEPT( * current_raw_ptr ) );
+                AV_POSTCONDITION( result.validate() );
+
+                return result;
+            }
         }
+
+        // i-th item is m-th not erased item in storage
+        i -= lower;
     }
 
-    // may throw an exception in __ValueType copy constructor, not exception safe
-    newStorage.place_back( std::forward< __ValueType >( value ) );
+    {// erased items before m-th not erased item in storage
+        std::size_t lower = 0;
+        std::size_t upper = _erased.size();
 
-    newStorage.swap( _storage );
-    newBuffer.swap( _buffer );
-    newErased.swap( _erased );
+        while( lower < upper )
+        {
+            std::size_t const middle = lower + ( upper - lower ) / 2;
 
-    AV_POSTCONDITION( _buffer.empty() );
-    AV_POSTCONDITION( _erased.empty() );
+            // not erased items before erased[ middle ]
+            if( static_cast< std::size_t >( _erased[ middle ] - _storage.begin() ) - middle <= i ){
+                lower = middle + 1;
+            }
+            else{
+                upper = middle;
+            }
+        }
 
-    AV_POSTCONDITION( validate() );
+        typename _Storage::iterator const current = _storage.begin() + i + lower;
+
+        AV_CHECK( current < _storage.end() );
+        AV_CHECK( isErased( current ) == false );
+
+        result._inStorage = current;
+        result._inBuffer = 0;
+        result._inErased = _erased.begin() + lower;
+        result._current = current;
+    }
+
+    AV_POSTCONDITION( result.validate() );
+
+    return result;
 }
 
 template<
@@ -3901,47 +7195,73 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_TryRemoveBackResult
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::tryRemoveStorageBack(
-    typename _Storage::iterator pos
+template<
+    typename _KeyIterator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findManyImpl(
+      _KeyIterator first
+    , _KeyIterator const last
+    , std::vector< _FindImplResult > & results
 )
 {
-    if( pos + 1 != _storage.end() )
+    AV_PRECONDITION( std::distance( first, last ) >= 0 );
+
+    results.resize( std::distance( first, last ) );
+
+    _FindManyCursor cursor;
+    cursor._inStorage = _storage.begin();
+    cursor._inBuffer = _buffer.begin();
+    cursor._inErased = _erased.begin();
+
+    if( std::is_sorted( first, last, key_comp() ) )
     {
-        _TryRemoveBackResult result;
-        result._anyItemRemoved = false;
-        result._erasedItemRemoved = false;
+        for( std::size_t i = 0 ; first != last ; ++ first, ++ i ){
+            results[ i ] = findImpl( * first, cursor );
+        }
 
-        return result;
+        return;
     }
 
-    _storage.get_allocator().destroy( pos );
-
-    _storage.setSize( _storage.size() - 1 );
+    // unsorted batch is swept in keys order, results go back to their positions
+    typedef std::pair< _KeyIterator, std::size_t > Query;
 
-    if(
-           _erased.empty() == false
-        && _erased.back() == pos
-    )
-    {
-        _erased.setSize( _erased.size() - 1 );
+    std::vector< Query > queries;
+    queries.reserve( results.size() );
 
-        _TryRemoveBackResult result;
-        result._anyItemRemoved = true;
-        result._erasedItemRemoved = true;
+    for( std::size_t i = 0 ; first != last ; ++ first, ++ i ){
+        queries.push_back( Query( first, i ) );
+    }
 
-        AV_POSTCONDITION( validate() );
+    std::sort( queries.begin(), queries.end(), detail::AssocVectorQueryCmp< _Cmp >( key_comp() ) );
 
-        return result;
+    for( std::size_t i = 0 ; i < queries.size() ; ++ i ){
+        results[ queries[ i ].second ] = findImpl( * queries[ i ].first, cursor );
     }
+}
 
-    _TryRemoveBackResult result;
-    result._anyItemRemoved = true;
-    result._erasedItemRemoved = false;
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+      typename _KeyIterator
+    , typename _OutputIterator
+>
+_OutputIterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::find_many(
+      _KeyIterator first
+    , _KeyIterator const last
+    , _OutputIterator out
+)
+{
+    std::vector< _FindImplResult > results;
 
-    AV_POSTCONDITION( validate() );
+    findManyImpl( first, last, results );
 
-    return result;
+    return toIterators( results, out );
 }
 
 template<
@@ -3950,42 +7270,75 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_TryEraseFromStorageResult
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::tryEraseFromStorage(
-    typename _Storage::iterator pos
+template<
+    typename _OutputIterator
+>
+_OutputIterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::toIterators(
+      std::vector< _FindImplResult > const & results
+    , _OutputIterator out
 )
 {
-    std::pair< typename _Erased::iterator, bool > const insertInSortedResult
-        = array::insert_in_sorted(
-              _erased
-            , typename _Storage::const_iterator( pos )
-            , std::less< typename _Storage::const_iterator >()
-        );
+    iterator const end = this->end();
 
-    if( _erased.full() )
+    for( std::size_t i = 0 ; i < results.size() ; ++ i, ++ out )
     {
-        mergeStorageWithErased();
+        _FindImplResult const & result = results[ i ];
 
-        _TryEraseFromStorageResult result;
-        result._inErased = _erased.end();
-        result._isErased = true;
-        result._isMerged = true;
+        if( result._current == 0 ){
+            * out = end;
+        }
+        else{
+            * out = iterator(
+                  this
+                , result._inStorage
+                , result._inBuffer
+                , result._inErased
+                , result._current
+            );
+        }
+    }
 
-        AV_POSTCONDITION( validate() );
+    return out;
+}
 
-        return result;
-    }
-    else
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+      typename _KeyIterator
+    , typename _OutputIterator
+>
+_OutputIterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::find_many_interleaved(
+      _KeyIterator first
+    , _KeyIterator const last
+    , _OutputIterator out
+)
+{
+    AV_PRECONDITION( std::distance( first, last ) >= 0 );
+
+    std::vector< _FindImplResult > results( std::distance( first, last ) );
+
+    _Key const * keys[ AV_PREFETCH_GROUP_SIZE ] = {};
+
+    for( std::size_t done = 0 ; first != last ; /*empty*/ )
     {
-        _TryEraseFromStorageResult result;
-        result._inErased = insertInSortedResult.first;
-        result._isErased = insertInSortedResult.second;
-        result._isMerged = false;
+        std::size_t count = 0;
 
-        AV_POSTCONDITION( validate() );
+        for( /*empty*/ ; first != last && count < AV_PREFETCH_GROUP_SIZE ; ++ first, ++ count ){
+            keys[ count ] = & * first;
+        }
 
-        return result;
+        findInterleavedImpl( keys, count, & results[ done ] );
+
+        done += count;
     }
+
+    return toIterators( results, out );
 }
 
 template<
@@ -3994,19 +7347,20 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-bool
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::isErased(
-    typename AssocVector::_Storage::const_iterator iterator
+template<
+      typename _KeyIterator
+    , typename _OutputIterator
+>
+_OutputIterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::find_many_interleaved(
+      _KeyIterator first
+    , _KeyIterator const last
+    , _OutputIterator out
 )const
 {
-    typename _Erased::const_iterator const foundInErased = array::binary_search(
-          _erased.begin()
-        , _erased.end()
-        , iterator
-        , std::less< typename _Storage::const_iterator >()
-    );
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
 
-    return foundInErased != _erased.end();
+    return const_cast< NonConstThis >( this )->find_many_interleaved( first, last, out );
 }
 
 template<
@@ -4015,93 +7369,153 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_FindImplResult
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findImpl( _Key const & k )
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findInterleavedImpl(
+      _Key const * const * keys
+    , std::size_t const count
+    , _FindImplResult * results
+)
 {
-    typename _Storage::iterator const greaterEqualInStorage
-        = std::lower_bound( _storage.begin(), _storage.end(), k, value_comp() );
+    AV_PRECONDITION( count <= AV_PREFETCH_GROUP_SIZE );
 
-    bool const presentInStorage
-        = greaterEqualInStorage != _storage.end()
-        && key_comp()( k, greaterEqualInStorage->first ) == false;
+    typedef typename _Storage::const_iterator StorageConstIterator;
+
+    // value initialized, only the first count items are used but the compiler can not see it
+    typename _Storage::iterator inStorage[ AV_PREFETCH_GROUP_SIZE ] = {};
+    typename _Storage::iterator inBuffer[ AV_PREFETCH_GROUP_SIZE ] = {};
+    typename _Erased::iterator inErased[ AV_PREFETCH_GROUP_SIZE ] = {};
+
+    StorageConstIterator storageItems[ AV_PREFETCH_GROUP_SIZE ] = {};
+    StorageConstIterator const * storageItemsPointers[ AV_PREFETCH_GROUP_SIZE ] = {};
+
+    util::interleaved_lower_bound(
+          _storage.begin()
+        , _storage.end()
+        , keys
+        , count
+        , inStorage
+        , value_comp()
+    );
+
+    util::interleaved_lower_bound(
+          _buffer.begin()
+        , _buffer.end()
+        , keys
+        , count
+        , inBuffer
+        , value_comp()
+    );
+
+    for( std::size_t i = 0 ; i < count ; ++ i )
+    {
+        storageItems[ i ] = inStorage[ i ];
+        storageItemsPointers[ i ] = & storageItems[ i ];
+    }
+
+    util::interleaved_lower_bound(
+          _erased.begin()
+        , _erased.end()
+        , storageItemsPointers
+        , count
+        , inErased
+        , std::less< StorageConstIterator >()
+    );
+
+    for( std::size_t i = 0 ; i < count ; ++ i )
+    {
+        _Key const & k = * keys[ i ];
+
+        _FindImplResult & result = results[ i ];
+        result._inStorage = 0;
+        result._inBuffer = 0;
+        result._inErased = 0;
+        result._current = 0;
+
+        bool const presentInStorage
+            = inStorage[ i ] != _storage.end()
+            && key_comp()( k, inStorage[ i ]->first ) == false;
 
-    {// item is in storage, check in erased
         if( presentInStorage )
         {
-            typename _Erased::iterator greaterEqualInErased = std::lower_bound(
-                  _erased.begin()
-                , _erased.end()
-                , greaterEqualInStorage
-                , std::less< typename _Storage::const_iterator >()
-            );
-
             bool const itemNotMarkedAsErased
-                = greaterEqualInErased == _erased.end()
-                || std::less< typename _Storage::const_iterator >()(
-                         greaterEqualInStorage
-                       , * greaterEqualInErased
-                   );
+                = inErased[ i ] == _erased.end()
+                || std::less< StorageConstIterator >()( inStorage[ i ], * inErased[ i ] );
 
             if( itemNotMarkedAsErased )
             {
-                _FindImplResult result;
-                result._inStorage = greaterEqualInStorage;
-                result._inBuffer = 0;
-                result._inErased = greaterEqualInErased;
-                result._current = greaterEqualInStorage;
-
-                AV_POSTCONDITION( result.validate() );
-
-                return result;
+                result._inStorage = inStorage[ i ];
+                result._inErased = inErased[ i ];
+                result._current = inStorage[ i ];
             }
-            else
-            {
-                _FindImplResult result;
-                result._inStorage = 0;
-                result._inBuffer = 0;
-                result._inErased = 0;
-                result._current = 0;
-
-                AV_POSTCONDITION( result.validate() );
 
-                return result;
-            }
+            continue;
         }
-    }
-
-    {// check in buffer
-        typename _Storage::iterator const greaterEqualInBuffer
-            = std::lower_bound( _buffer.begin(), _buffer.end(), k, value_comp() );
 
         bool const presentInBuffer
-            = greaterEqualInBuffer != _buffer.end()
-            && key_comp()( k, greaterEqualInBuffer->first ) == false;
+            = inBuffer[ i ] != _buffer.end()
+            && key_comp()( k, inBuffer[ i ]->first ) == false;
 
         if( presentInBuffer )
         {
-            _FindImplResult result;
-            result._inStorage = greaterEqualInStorage;
-            result._inBuffer = greaterEqualInBuffer;
-            result._inErased = 0;
-            result._current = greaterEqualInBuffer;
+            result._inStorage = inStorage[ i ];
+            result._inBuffer = inBuffer[ i ];
+            result._current = inBuffer[ i ];
+        }
 
-            AV_POSTCONDITION( result.validate() );
+        AV_POSTCONDITION( result.validate() );
+    }
+}
 
-            return result;
-        }
-        else
-        {
-            _FindImplResult result;
-            result._inStorage = 0;
-            result._inBuffer = 0;
-            result._inErased = 0;
-            result._current = 0;
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+      typename _KeyIterator
+    , typename _OutputIterator
+>
+_OutputIterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::find_many(
+      _KeyIterator first
+    , _KeyIterator const last
+    , _OutputIterator out
+)const
+{
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
 
-            AV_POSTCONDITION( result.validate() );
+    return const_cast< NonConstThis >( this )->find_many( first, last, out );
+}
 
-            return result;
-        }
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+      typename _KeyIterator
+    , typename _OutputIterator
+>
+_OutputIterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::count_many(
+      _KeyIterator first
+    , _KeyIterator const last
+    , _OutputIterator out
+)const
+{
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
+
+    std::vector< _FindImplResult > results;
+
+    const_cast< NonConstThis >( this )->findManyImpl( first, last, results );
+
+    for( std::size_t i = 0 ; i < results.size() ; ++ i, ++ out ){
+        * out = results[ i ]._current == 0 ? 0 : 1;
     }
+
+    return out;
 }
 
 template<
@@ -4136,18 +7550,133 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reference
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::at( _Key const & k )
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reference
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::at( _Key const & k )
+{
+    _FindImplResult const result = findImpl( k );
+
+    if( result._current == 0 ){
+        throw std::out_of_range( "AssocVector::at" );
+    }
+    else
+    {
+        return result._current->second;
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reference
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::at( _Key const & k )const
+{
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
+
+    return const_cast< NonConstThis >( this )->at( k );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::find( _Key const & k )const
+{
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
+
+    return const_cast< NonConstThis >( this )->find( k );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::handle
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::make_handle( const_iterator pos )const
+{
+    AV_PRECONDITION( pos != end() );
+
+    handle result( pos->first );
+
+    bindHandle( result, pos.getCurrent() );
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::handle
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::make_handle( _Key const & k )const
+{
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
+
+    _FindImplResult const found = const_cast< NonConstThis >( this )->findImpl( k );
+
+    handle result( k );
+
+    if( found._current != 0 ){
+        bindHandle( result, found._current );
+    }
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::mapped_type *
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::resolve( handle & h )
 {
-    _FindImplResult const result = findImpl( k );
-
-    if( result._current == 0 ){
-        throw std::out_of_range( "AssocVector::at" );
+    if( h._inBuffer )
+    {
+        // buffer items are shifted by inserts and erases, key at the index tells if it is still there
+        if(
+               h._index < _buffer.size()
+            && _cmp( h._key, _buffer[ h._index ].first ) == false
+            && _cmp( _buffer[ h._index ].first, h._key ) == false
+        )
+        {
+            return & _buffer[ h._index ].second;
+        }
     }
     else
     {
-        return result._current->second;
+        // same generation, storage item has not been moved nor erased, key check covers
+        // moved from containers whose storage is refilled by push back
+        if(
+               h._generation == _generation
+            && h._index < _storage.size()
+            && _cmp( h._key, _storage[ h._index ].first ) == false
+            && _cmp( _storage[ h._index ].first, h._key ) == false
+        )
+        {
+            return & _storage[ h._index ].second;
+        }
+    }
+
+    _FindImplResult const found = findImpl( h._key );
+
+    if( found._current == 0 ){
+        return 0;
     }
+
+    bindHandle( h, found._current );
+
+    return & found._current->second;
 }
 
 template<
@@ -4156,12 +7685,12 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_reference
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::at( _Key const & k )const
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::mapped_type const *
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::resolve( handle & h )const
 {
     typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
 
-    return const_cast< NonConstThis >( this )->at( k );
+    return const_cast< NonConstThis >( this )->resolve( h );
 }
 
 template<
@@ -4170,12 +7699,10 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::const_iterator
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::find( _Key const & k )const
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::generation()const noexcept
 {
-    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > * NonConstThis;
-
-    return const_cast< NonConstThis >( this )->find( k );
+    return _generation;
 }
 
 template<
@@ -4495,7 +8022,7 @@ template<
 typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reference
 AssocVector< _Key, _Mapped, _Cmp, _Allocator >::operator[]( key_type const & k )
 {
-    return insert( value_type( k, mapped_type() ) ).first->second;
+    return tryEmplaceImpl( _InsertHint(), k ).first->second;
 }
 
 template<
@@ -4507,7 +8034,7 @@ template<
 typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::reference
 AssocVector< _Key, _Mapped, _Cmp, _Allocator >::operator[]( key_type && k )
 {
-    return insert( value_type( std::move( k ), mapped_type() ) ).first->second;
+    return tryEmplaceImpl( _InsertHint(), std::move( k ) ).first->second;
 }
 
 template<
@@ -4586,6 +8113,139 @@ AssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase( key_type const & k )
     }
 }
 
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase(
+      const_iterator first
+    , const_iterator last
+)
+{
+    if( first == last ){
+        return last == end() ? end() : lower_bound( last->first );
+    }
+
+    {// a few items are erased one by one, each of them costs O( sqrt( N ) )
+        std::vector< _Key > keys;
+
+        for(
+            const_iterator current = first
+            ; current != last && util::less_equal( keys.size(), _erased.capacity() )
+            ; ++ current
+        )
+        {
+            keys.push_back( current->first );
+        }
+
+        if( util::less_equal( keys.size(), _erased.capacity() ) )
+        {
+            bool const isLastEnd = last == end();
+
+            _Key const upper = isLastEnd ? keys.back() : last->first;
+
+            for( std::size_t i = 0 ; i < keys.size() ; ++ i ){
+                erase( keys[ i ] );
+            }
+
+            return isLastEnd ? end() : lower_bound( upper );
+        }
+    }
+
+    _Key const lower = first->first;
+
+    if( last == end() )
+    {
+        compact( detail::AssocVectorKeyRangePredicate< _Key, _Cmp >( lower, 0, key_comp() ) );
+
+        return end();
+    }
+
+    _Key const upper = last->first;
+
+    compact( detail::AssocVectorKeyRangePredicate< _Key, _Cmp >( lower, & upper, key_comp() ) );
+
+    return lower_bound( upper );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename _Pred
+>
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase_if( _Pred pred )
+{
+    return compact( detail::AssocVectorValuePredicate< _Pred, value_type >( pred ) );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename _KeyIterator
+>
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase_keys(
+      _KeyIterator first
+    , _KeyIterator const last
+)
+{
+    AV_PRECONDITION( std::is_sorted( first, last, key_comp() ) );
+
+    if( util::less_equal( static_cast< std::size_t >( std::distance( first, last ) ), _erased.capacity() ) )
+    {
+        // a few items are erased one by one, each of them costs O( sqrt( N ) )
+        std::size_t result = 0;
+
+        for( /*empty*/ ; first != last ; ++ first ){
+            result += erase( * first );
+        }
+
+        return result;
+    }
+
+    return compact( detail::AssocVectorKeysPredicate< _KeyIterator, _Cmp >( first, last, key_comp() ) );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template<
+    typename _Pred
+>
+std::size_t
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::compact( _Pred const & pred )
+{
+    std::size_t const oldSize = size();
+
+    array::erase_removed_if( _storage, _erased.begin(), _erased.end(), _Pred( pred ) );
+
+    _erased.setSize( 0 );
+
+    array::erase_removed_if( _buffer, _erased.end(), _erased.end(), _Pred( pred ) );
+
+    ++ _generation;
+
+    AV_POSTCONDITION( _erased.empty() );
+    AV_POSTCONDITION( validate() );
+
+    return oldSize - size();
+}
+
 template<
       typename _Key
     , typename _Mapped
@@ -4676,8 +8336,177 @@ AssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase( iterator pos )
 
         AV_POSTCONDITION( validate() );
 
-        return iterator( this, greaterEqualInStorage, greaterEqualInBuffer, _erased.end(), 0 );
-    }
+        return iterator( this, greaterEqualInStorage, greaterEqualInBuffer, _erased.end(), 0 );
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_erase( iterator pos )
+{
+    // iterator::get converts  : pair< T1, T2 > *       -> pair< T1 const, T2 > *
+    // revert real iterator type: pair< T1 const, T2 > * -> pair< T1, T2 > *
+    value_type_mutable * const posBase = reinterpret_cast< value_type_mutable * >( pos.get() );
+
+    {//erase from _buffer
+        if( util::is_between( _buffer.begin(), posBase, _buffer.end() ) )
+        {
+            _buffer.erase( posBase );
+
+            AV_POSTCONDITION( validate() );
+
+            return true;
+        }
+    }
+
+    {//item not present in container
+        if( util::is_between( _storage.begin(), posBase, _storage.end() ) == false ){
+            return false;
+        }
+    }
+
+    {//erase from back
+        _TryRemoveBackResult const result = tryRemoveStorageBack( posBase );
+
+        if( result._anyItemRemoved )
+        {
+            AV_POSTCONDITION( validate() );
+
+            return true;
+        }
+    }
+
+    {//erase from _storage
+        bool const result = tryEraseFromStorage( posBase )._isErased;
+
+        AV_POSTCONDITION( validate() );
+
+        return result;
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::swap(
+    AssocVector< _Key, _Mapped, _Cmp, _Allocator > & other
+) noexcept
+{
+    std::swap( _storage, other._storage );
+    std::swap( _buffer, other._buffer );
+    std::swap( _erased, other._erased );
+
+    std::swap( _cmp, other._cmp );
+
+    // handles taken on either container must not be resolved in O(1) on the other one
+    _generation = other._generation = std::max( _generation, other._generation ) + 1;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::merge( AssocVector & other )
+{
+    if( this == & other ){
+        return;
+    }
+
+    other._merge();
+
+    detail::AssocVectorKeepExisting< _Storage > keepExisting( other._storage );
+
+    mergeWithSortedUnique( other._storage.begin(), other._storage.end(), keepExisting );
+
+    util::destroy_range( other._storage.begin() + keepExisting.kept(), other._storage.end() );
+    other._storage.setSize( keepExisting.kept() );
+
+    AV_POSTCONDITION( other.validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::merge( AssocVector && other )
+{
+    merge( other );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::absorb( AssocVector && other )
+{
+    if( this == & other ){
+        return;
+    }
+
+    if( empty() )
+    {
+        _storage.swap( other._storage );
+        _buffer.swap( other._buffer );
+        _erased.swap( other._erased );
+
+        ++ _generation;
+    }
+    else
+    {
+        other._merge();
+
+        mergeWithSortedUnique( other._storage.begin(), other._storage.end() );
+    }
+
+    other.clear();
+
+    AV_POSTCONDITION( validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_Storage
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::release_sorted()
+{
+    _merge();
+
+    AV_CHECK( _buffer.empty() );
+    AV_CHECK( _erased.empty() );
+
+    _Storage result( _storage.get_allocator() );
+    _Storage newBuffer( _buffer.get_allocator() );
+    _Erased newErased( _erased.get_allocator() );
+
+    result.swap( _storage );
+    newBuffer.swap( _buffer );
+    newErased.swap( _erased );
+
+    AV_POSTCONDITION( empty() );
+    AV_POSTCONDITION( validate() );
+
+    return result;
 }
 
 template<
@@ -4686,48 +8515,27 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-bool
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_erase( iterator pos )
+array::Span< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::value_type_mutable const >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::sorted_span()
 {
-    // iterator::get converts  : pair< T1, T2 > *       -> pair< T1 const, T2 > *
-    // revert real iterator type: pair< T1 const, T2 > * -> pair< T1, T2 > *
-    value_type_mutable * const posBase = reinterpret_cast< value_type_mutable * >( pos.get() );
-
-    {//erase from _buffer
-        if( util::is_between( _buffer.begin(), posBase, _buffer.end() ) )
-        {
-            _buffer.erase( posBase );
-
-            AV_POSTCONDITION( validate() );
-
-            return true;
-        }
-    }
-
-    {//item not present in container
-        if( util::is_between( _storage.begin(), posBase, _storage.end() ) == false ){
-            return false;
-        }
-    }
-
-    {//erase from back
-        _TryRemoveBackResult const result = tryRemoveStorageBack( posBase );
-
-        if( result._anyItemRemoved )
-        {
-            AV_POSTCONDITION( validate() );
-
-            return true;
-        }
-    }
+    _merge();
 
-    {//erase from _storage
-        bool const result = tryEraseFromStorage( posBase )._isErased;
+    return static_cast< AssocVector const & >( * this ).sorted_span();
+}
 
-        AV_POSTCONDITION( validate() );
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+array::Span< typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::value_type_mutable const >
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::sorted_span()const
+{
+    AV_PRECONDITION( _buffer.empty() );
+    AV_PRECONDITION( _erased.empty() );
 
-        return result;
-    }
+    return array::Span< value_type_mutable const >( _storage.data(), _storage.size() );
 }
 
 template<
@@ -4736,16 +8544,10 @@ template<
     , typename _Cmp
     , typename _Allocator
 >
-void
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::swap(
-    AssocVector< _Key, _Mapped, _Cmp, _Allocator > & other
-) noexcept
+bool
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::is_flat()const noexcept
 {
-    std::swap( _storage, other._storage );
-    std::swap( _buffer, other._buffer );
-    std::swap( _erased, other._erased );
-
-    std::swap( _cmp, other._cmp );
+    return _buffer.empty() && _erased.empty();
 }
 
 template<
@@ -4759,12 +8561,19 @@ AssocVector< _Key, _Mapped, _Cmp, _Allocator >::mergeStorageWithBuffer()
 {
     AV_PRECONDITION( _erased.empty() );
 
+    // growth merges an empty buffer, storage indexes stay valid then
+    bool const moved = _buffer.empty() == false;
+
     array::move_merge( _storage, _buffer, value_comp() );
 
     util::destroy_range( _buffer.begin(), _buffer.end() );
 
     _buffer.setSize( 0 );
 
+    if( moved ){
+        ++ _generation;
+    }
+
     AV_POSTCONDITION( _buffer.empty() );
     AV_POSTCONDITION( validateStorage() );
 }
@@ -4786,10 +8595,53 @@ AssocVector< _Key, _Mapped, _Cmp, _Allocator >::mergeStorageWithErased()
 
     _erased.setSize( 0 );
 
+    ++ _generation;
+
     AV_POSTCONDITION( _erased.empty() );
     AV_POSTCONDITION( validateStorage() );
 }
 
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::adoptSortedUnique( _Storage && storage )
+{
+    AV_PRECONDITION( util::is_strictly_sorted( storage.begin(), storage.end(), value_comp() ) );
+
+    _Storage newStorage( std::move( storage ) );
+    _Storage newBuffer( calculateNewBufferCapacity( newStorage.capacity() ), newStorage.get_allocator() );
+    _Erased newErased( calculateNewErasedCapacity( newStorage.capacity() ), newStorage.get_allocator() );
+
+    newStorage.swap( _storage );
+    newBuffer.swap( _buffer );
+    newErased.swap( _erased );
+
+    ++ _generation;
+
+    AV_POSTCONDITION( validate() );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::rebaseErased( AssocVector const & other )
+{
+    AV_PRECONDITION( _erased.size() == other._erased.size() );
+
+    // erased items copied from other point into other's storage
+    for( std::size_t i = 0 ; i < _erased.size() ; ++ i ){
+        _erased[ i ] = _storage.begin() + ( other._erased[ i ] - other._storage.begin() );
+    }
+}
+
 template<
       typename _Key
     , typename _Mapped
@@ -4800,10 +8652,13 @@ template<
     typename __ValueType
 >
 typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_FindOrInsertToBufferResult
-AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findOrInsertToBuffer( __ValueType && value )
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findOrInsertToBuffer(
+      __ValueType && value
+    , typename _Storage::iterator hint
+)
 {
     typename _Storage::iterator const greaterEqualInBuffer
-        = std::lower_bound( _buffer.begin(), _buffer.end(), value.first, value_comp() );
+        = lowerBoundWithHint( _buffer, hint, value.first );
 
     if( greaterEqualInBuffer != _buffer.end() )
     {
@@ -4858,6 +8713,66 @@ AssocVector< _Key, _Mapped, _Cmp, _Allocator >::findOrInsertToBuffer( __ValueTyp
     }
 }
 
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_InsertHint
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::toInsertHint( const_iterator hint )
+{
+    _InsertHint result;
+
+    if( hint.getContainer() != this ){
+        return result;
+    }
+
+    typename _Storage::iterator const inStorage
+        = const_cast< typename _Storage::iterator >( hint.getCurrentInStorage() );
+
+    typename _Storage::iterator const inBuffer
+        = const_cast< typename _Storage::iterator >( hint.getCurrentInBuffer() );
+
+    // lazy positions are 0 until computed, stale ones are just bad hints
+    if( inStorage != 0 && util::is_between( _storage.begin(), inStorage, _storage.end() ) ){
+        result._inStorage = inStorage;
+    }
+
+    if( inBuffer != 0 && util::is_between( _buffer.begin(), inBuffer, _buffer.end() ) ){
+        result._inBuffer = inBuffer;
+    }
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename AssocVector< _Key, _Mapped, _Cmp, _Allocator >::_Storage::iterator
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >::lowerBoundWithHint(
+      _Storage & array
+    , typename _Storage::iterator const hint
+    , key_type const & k
+)
+{
+    if( hint == 0 ){
+        return std::lower_bound( array.begin(), array.end(), k, value_comp() );
+    }
+
+    AV_PRECONDITION( util::is_between( array.begin(), hint, array.end() ) );
+
+    if( hint != array.end() && value_comp()( * hint, k ) ){
+        return util::gallop_lower_bound( hint + 1, array.end(), k, value_comp() );
+    }
+    else{
+        return util::gallop_lower_bound_backward( array.begin(), hint, k, value_comp() );
+    }
+}
+
 template<
       typename _Key
     , typename _Mapped
@@ -4952,4 +8867,200 @@ void AssocVector< _Key, _Mapped, _Cmp, _Allocator >::dump( int width )const
     std::cout << "." << std::endl;
 }
 
+namespace detail
+{
+    //
+    // AssocVectorKeepFirst, default collision policy of set operations
+    //
+    struct AssocVectorKeepFirst
+    {
+        template< typename _Mapped >
+        _Mapped const & operator()( _Mapped const & lhs, _Mapped const & )const
+        {
+            return lhs;
+        }
+    };
+
+    //
+    // assocVectorSetOperation, one linear merge of two containers into a new storage
+    //
+    template<
+          typename _AssocVector
+        , typename _Combine
+    >
+    _AssocVector
+    assocVectorSetOperation(
+          _AssocVector const & lhs
+        , _AssocVector const & rhs
+        , std::size_t capacity
+        , bool takeLhsOnly
+        , bool takeRhsOnly
+        , bool takeBoth
+        , _Combine combine
+    )
+    {
+        typedef typename _AssocVector::_Storage _Storage;
+        typedef typename _Storage::value_type _Value;
+
+        typedef AssocVectorCursor<
+              typename _Storage::const_iterator
+            , typename _AssocVector::_Erased::const_iterator
+            , typename _AssocVector::key_compare
+        > _Cursor;
+
+        typename _AssocVector::key_compare const cmp = lhs.key_comp();
+
+        _Storage storage( capacity, lhs.storage().get_allocator() );
+
+        _Cursor first = lhs.cursor();
+        _Cursor second = rhs.cursor();
+
+        while( first.done() == false && second.done() == false )
+        {
+            if( cmp( first.get()->first, second.get()->first ) )
+            {
+                if( takeLhsOnly ){
+                    storage.place_back( * first.get() );
+                }
+
+                first.next();
+            }
+            else if( cmp( second.get()->first, first.get()->first ) )
+            {
+                if( takeRhsOnly ){
+                    storage.place_back( * second.get() );
+                }
+
+                second.next();
+            }
+            else
+            {
+                if( takeBoth ){
+                    storage.place_back( _Value( first.get()->first, combine( first.get()->second, second.get()->second ) ) );
+                }
+
+                first.next();
+                second.next();
+            }
+        }
+
+        for( /*empty*/ ; takeLhsOnly && first.done() == false ; first.next() ){
+            storage.place_back( * first.get() );
+        }
+
+        for( /*empty*/ ; takeRhsOnly && second.done() == false ; second.next() ){
+            storage.place_back( * second.get() );
+        }
+
+        return _AssocVector::from_sorted_unique( std::move( storage ), cmp );
+    }
+
+} // namespace detail
+
+//
+// set_union, items of both containers, combine( lhs, rhs ) resolves common keys
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+    , typename _Combine
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+set_union(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+    , _Combine combine
+)
+{
+    return detail::assocVectorSetOperation( lhs, rhs, lhs.size() + rhs.size(), true, true, true, combine );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+set_union(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+)
+{
+    return set_union( lhs, rhs, detail::AssocVectorKeepFirst() );
+}
+
+//
+// set_intersection, common keys only, combine( lhs, rhs ) resolves values
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+    , typename _Combine
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+set_intersection(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+    , _Combine combine
+)
+{
+    return detail::assocVectorSetOperation( lhs, rhs, std::min( lhs.size(), rhs.size() ), false, false, true, combine );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+set_intersection(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+)
+{
+    return set_intersection( lhs, rhs, detail::AssocVectorKeepFirst() );
+}
+
+//
+// set_difference, items of lhs which keys are not in rhs
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+set_difference(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+)
+{
+    return detail::assocVectorSetOperation( lhs, rhs, lhs.size(), true, false, false, detail::AssocVectorKeepFirst() );
+}
+
+//
+// set_symmetric_difference, items which keys are in exactly one container
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+AssocVector< _Key, _Mapped, _Cmp, _Allocator >
+set_symmetric_difference(
+      AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & lhs
+    , AssocVector< _Key, _Mapped, _Cmp, _Allocator > const & rhs
+)
+{
+    return detail::assocVectorSetOperation( lhs, rhs, lhs.size() + rhs.size(), true, true, false, detail::AssocVectorKeepFirst() );
+}
+
 #endif
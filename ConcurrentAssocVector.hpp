@@ -0,0 +1,3734 @@
+/*
+ * Copyright (C) 2012 ukasz Czerwiski
+ *
+ * GitHub: https://github.com/wo3kie/AssocVector
+ * Website: http://www.lukaszczerwinski.pl/assoc_vector.en.html
+ *
+ * Distributed under the BSD Software License (see file license)
+ */
+
+#ifndef CONCURRENT_ASSOC_VECTOR_HPP
+#define CONCURRENT_ASSOC_VECTOR_HPP
+
+// includes.begin
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "AssocVector.hpp"
+
+// includes.end
+
+// configuration.begin
+
+#ifndef AV_CACHE_LINE_SIZE
+    #define AV_CACHE_LINE_SIZE 64
+#endif
+
+#ifndef AV_RCU_READERS
+    #define AV_RCU_READERS 64
+#endif
+
+#ifndef AV_PARALLEL_MIN_ITEMS
+    #define AV_PARALLEL_MIN_ITEMS 4096
+#endif
+
+#ifndef AV_SHARD_SPLIT_ITEMS
+    #define AV_SHARD_SPLIT_ITEMS 4096
+#endif
+
+// called by a ShardedAssocVector router between reading the epoch and registering in it, tests delay routers here
+#ifndef AV_SHARD_ROUTER_HOOK
+    #define AV_SHARD_ROUTER_HOOK()
+#endif
+
+#ifndef AV_FLAT_COMBINING_SLOTS
+    #define AV_FLAT_COMBINING_SLOTS 64
+#endif
+
+#ifndef AV_INGEST_BUFFER
+    #define AV_INGEST_BUFFER 16384
+#endif
+
+#if defined( __SANITIZE_THREAD__ )
+    #define AV_THREAD_SANITIZER
+#elif defined( __has_feature )
+    #if __has_feature( thread_sanitizer )
+        #define AV_THREAD_SANITIZER
+    #endif
+#endif
+
+// configuration.end
+
+//
+// ShardedAssocVector, thread safe map, key space is split by boundaries into range shards,
+// each shard is an AssocVector with its own mutex, so operations on different shards run in parallel
+//
+// boundaries b[ 0 ] < b[ 1 ] < ... split keys into [ -inf, b[ 0 ] ), [ b[ 0 ], b[ 1 ] ), ..., [ b[ n-1 ], +inf ),
+// they may be changed online with resplit or rebalance, a container built without boundaries
+// rebalances itself once the first shard holds AV_SHARD_SPLIT_ITEMS items
+//
+// items are returned by copy, a shard lock is never held outside of a method call,
+// except for for_each which holds at most two neighbouring shard locks during the call of f
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp = std::less< _Key >
+    , typename _Allocator = std::allocator< std::pair< _Key, _Mapped > >
+>
+struct ShardedAssocVector
+{
+public:
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > shard_type;
+
+    typedef _Key key_type;
+    typedef _Mapped mapped_type;
+
+    typedef std::pair< _Key, _Mapped > value_type;
+
+    typedef _Cmp key_compare;
+
+private:
+    //
+    // _Layout, boundaries of shards, immutable once published
+    //
+    struct _Layout
+    {
+        std::vector< _Key > _boundaries;
+
+        // shards filled with this layout carry its version, compared instead of the address
+        // which may be reused once the layout is reclaimed
+        std::size_t _version;
+    };
+
+    //
+    // _Shard, padded so that neighbouring shards do not share a cache line
+    //
+    struct _Shard
+    {
+        _Shard()
+            : _version( 0 )
+        {
+        }
+
+        mutable std::mutex _mutex;
+
+        shard_type _av;
+
+        // version of layout the shard was filled with, guarded by _mutex
+        std::size_t _version;
+
+        char _padding[ AV_CACHE_LINE_SIZE ];
+    };
+
+    typedef std::unique_lock< std::mutex > _Lock;
+
+public:
+    //
+    // constructor, all keys go to the first shard until it holds AV_SHARD_SPLIT_ITEMS items,
+    // then the container is rebalanced once, unless resplit or rebalance was called before
+    //
+    explicit ShardedAssocVector( std::size_t shards = 16, _Cmp const & cmp = _Cmp() );
+
+    //
+    // constructor, boundaries have to be strictly sorted, there are boundaries.size() + 1 shards
+    //
+    explicit ShardedAssocVector( std::vector< _Key > const & boundaries, _Cmp const & cmp = _Cmp() );
+
+    ShardedAssocVector( ShardedAssocVector const & ) = delete;
+    ShardedAssocVector & operator=( ShardedAssocVector const & ) = delete;
+
+    //
+    // methods
+    //
+    bool insert( value_type const & value );
+    bool insert_or_assign( key_type const & k, mapped_type const & m );
+
+    std::size_t erase( key_type const & k );
+
+    //
+    // find, copies mapped value of k into m if k is present
+    //
+    bool find( key_type const & k, mapped_type & m )const;
+
+    std::size_t count( key_type const & k )const;
+
+    //
+    // lower_bound, copies the first item with key not less than k into value, searches following shards
+    //
+    bool lower_bound( key_type const & k, value_type & value )const;
+
+    //
+    // for_each, calls f( value ) for all items in key order, f must not access this container
+    //
+    template< typename __Function >
+    void for_each( __Function f )const;
+
+    //
+    // size, sum of shard sizes, not a snapshot while other threads write
+    //
+    std::size_t size()const;
+    bool empty()const;
+
+    std::size_t shards()const noexcept;
+
+    std::vector< _Key > boundaries()const;
+
+    //
+    // resplit, moves items into shards given by new boundaries, all shards are locked meanwhile, O(N)
+    //
+    void resplit( std::vector< _Key > const & boundaries );
+
+    //
+    // rebalance, resplit so that all shards hold the same number of items
+    //
+    void rebalance();
+
+    key_compare key_comp()const;
+
+private:
+    //
+    // lockShard, locks the shard of k, retries if layout changed between routing and locking
+    //
+    std::size_t lockShard( key_type const & k, _Lock & lock )const;
+
+    std::vector< _Lock > lockAll()const;
+
+    //
+    // splitIfPending, first rebalance of a container built without boundaries, lock of shard
+    // index is released
+    //
+    void splitIfPending( std::size_t index, _Lock & lock );
+
+    void rebalanceLocked();
+    void resplitLocked( std::vector< _Key > const & boundaries );
+
+    //
+    // forEachShard, hand over hand from the first shard, resplit can not run meanwhile
+    //
+    template< typename __Function >
+    void forEachShard( std::size_t first, _Lock & lock, __Function & f )const;
+
+private:
+    _Cmp _cmp;
+
+    std::size_t _shardsCount;
+    std::unique_ptr< _Shard[] > _shards;
+
+    // current layout, owned by _current, guarded by all shard locks
+    std::atomic< _Layout const * > _layout;
+    std::unique_ptr< _Layout > _current;
+
+    // routers reading _layout, counted by parity of _epoch, resplit reclaims the previous layout
+    // once routers of the previous epoch are gone, a router never waits for a lock meanwhile
+    mutable std::atomic< std::size_t > _routers[ 2 ];
+    std::atomic< std::size_t > _epoch;
+
+    // guarded by all shard locks
+    std::size_t _version;
+    bool _splitPending;
+};
+
+namespace detail
+{
+    //
+    // ShardedAssocVectorForEach, for_each adapter calling f per item
+    //
+    template< typename _Function >
+    struct ShardedAssocVectorForEach
+    {
+        ShardedAssocVectorForEach( _Function & f )
+            : _f( f )
+        {
+        }
+
+        template< typename _Shard >
+        void operator()( _Shard const & av )
+        {
+            for( typename _Shard::const_iterator current = av.begin() ; current != av.end() ; ++ current ){
+                _f( * current );
+            }
+        }
+
+        _Function & _f;
+    };
+
+    //
+    // ShardedAssocVectorSize, size adapter summing shard sizes
+    //
+    struct ShardedAssocVectorSize
+    {
+        ShardedAssocVectorSize()
+            : _size( 0 )
+        {
+        }
+
+        template< typename _Shard >
+        void operator()( _Shard const & av )
+        {
+            _size += av.size();
+        }
+
+        std::size_t _size;
+    };
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::ShardedAssocVector(
+      std::size_t shards
+    , _Cmp const & cmp
+)
+    : _cmp( cmp )
+    , _shardsCount( shards )
+    , _shards( new _Shard[ shards ] )
+    , _layout( 0 )
+    , _epoch( 0 )
+    , _version( 0 )
+    , _splitPending( false )
+{
+    AV_PRECONDITION( shards > 0 );
+
+    _routers[ 0 ].store( 0 );
+    _routers[ 1 ].store( 0 );
+
+    resplitLocked( std::vector< _Key >() );
+
+    _splitPending = shards > 1;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::ShardedAssocVector(
+      std::vector< _Key > const & boundaries
+    , _Cmp const & cmp
+)
+    : _cmp( cmp )
+    , _shardsCount( boundaries.size() + 1 )
+    , _shards( new _Shard[ boundaries.size() + 1 ] )
+    , _layout( 0 )
+    , _epoch( 0 )
+    , _version( 0 )
+    , _splitPending( false )
+{
+    _routers[ 0 ].store( 0 );
+    _routers[ 1 ].store( 0 );
+
+    resplitLocked( boundaries );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::lockShard(
+      key_type const & k
+    , _Lock & lock
+)const
+{
+    for( ;; )
+    {
+        // seq_cst, see resplitLocked
+        std::size_t const epoch = _epoch.load();
+
+        AV_SHARD_ROUTER_HOOK();
+
+        _routers[ epoch & 1 ].fetch_add( 1 );
+
+        // epoch moved before registration was seen, a resplit which flips the current epoch
+        // does not wait for this router, so the layout it reads may be reclaimed meanwhile
+        if( _epoch.load() != epoch )
+        {
+            _routers[ epoch & 1 ].fetch_sub( 1 );
+
+            continue;
+        }
+
+        _Layout const * const layout = _layout.load();
+
+        std::size_t const index = std::upper_bound(
+              layout->_boundaries.begin()
+            , layout->_boundaries.end()
+            , k
+            , _cmp
+        ) - layout->_boundaries.begin();
+
+        std::size_t const version = layout->_version;
+
+        // layout may be reclaimed from now on
+        _routers[ epoch & 1 ].fetch_sub( 1 );
+
+        _Lock guard( _shards[ index ]._mutex );
+
+        // resplit changes layout of all shards while holding all locks
+        if( _shards[ index ]._version == version )
+        {
+            lock.swap( guard );
+
+            return index;
+        }
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::vector< typename ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::_Lock >
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::lockAll()const
+{
+    std::vector< _Lock > locks;
+    locks.reserve( _shardsCount );
+
+    // always in increasing order, like forEachShard
+    for( std::size_t index = 0 ; index < _shardsCount ; ++ index ){
+        locks.push_back( _Lock( _shards[ index ]._mutex ) );
+    }
+
+    return locks;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template< typename __Function >
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::forEachShard(
+      std::size_t first
+    , _Lock & lock
+    , __Function & f
+)const
+{
+    AV_PRECONDITION( lock.mutex() == & _shards[ first ]._mutex );
+
+    for( std::size_t index = first ; /*empty*/ ; ++ index )
+    {
+        f( _shards[ index ]._av );
+
+        if( index + 1 == _shardsCount ){
+            break;
+        }
+
+        _Lock next( _shards[ index + 1 ]._mutex );
+        lock.swap( next );
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( value_type const & value )
+{
+    _Lock lock;
+    std::size_t const index = lockShard( value.first, lock );
+
+    bool const result = _shards[ index ]._av.insert( value ).second;
+
+    splitIfPending( index, lock );
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign(
+      key_type const & k
+    , mapped_type const & m
+)
+{
+    _Lock lock;
+    std::size_t const index = lockShard( k, lock );
+
+    bool const result = _shards[ index ]._av.insert_or_assign( k, m ).second;
+
+    splitIfPending( index, lock );
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::splitIfPending(
+      std::size_t index
+    , _Lock & lock
+)
+{
+    // _splitPending is written under all locks, so it is read safely under one of them
+    if( _splitPending == false || _shards[ index ]._av.size() < AV_SHARD_SPLIT_ITEMS ){
+        return;
+    }
+
+    lock.unlock();
+
+    std::vector< _Lock > const locks = lockAll();
+
+    // another writer may have split meanwhile
+    if( _splitPending ){
+        rebalanceLocked();
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase( key_type const & k )
+{
+    _Lock lock;
+    std::size_t const index = lockShard( k, lock );
+
+    return _shards[ index ]._av.erase( k );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::find(
+      key_type const & k
+    , mapped_type & m
+)const
+{
+    _Lock lock;
+    std::size_t const index = lockShard( k, lock );
+
+    shard_type const & av = _shards[ index ]._av;
+
+    typename shard_type::const_iterator const found = av.find( k );
+
+    if( found == av.end() ){
+        return false;
+    }
+
+    m = found->second;
+
+    return true;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::count( key_type const & k )const
+{
+    _Lock lock;
+    std::size_t const index = lockShard( k, lock );
+
+    return _shards[ index ]._av.count( k );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::lower_bound(
+      key_type const & k
+    , value_type & value
+)const
+{
+    _Lock lock;
+    std::size_t index = lockShard( k, lock );
+
+    {
+        shard_type const & av = _shards[ index ]._av;
+
+        typename shard_type::const_iterator const found = av.lower_bound( k );
+
+        if( found != av.end() )
+        {
+            value = * found;
+
+            return true;
+        }
+    }
+
+    // keys of following shards are greater than k, hand over hand so resplit can not interleave
+    for( ++ index ; index < _shardsCount ; ++ index )
+    {
+        _Lock next( _shards[ index ]._mutex );
+        lock.swap( next );
+
+        shard_type const & av = _shards[ index ]._av;
+
+        if( av.empty() == false )
+        {
+            value = * av.begin();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template< typename __Function >
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::for_each( __Function f )const
+{
+    detail::ShardedAssocVectorForEach< __Function > forEach( f );
+
+    _Lock lock( _shards[ 0 ]._mutex );
+
+    forEachShard( 0, lock, forEach );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::size()const
+{
+    detail::ShardedAssocVectorSize size;
+
+    _Lock lock( _shards[ 0 ]._mutex );
+
+    forEachShard( 0, lock, size );
+
+    return size._size;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::empty()const
+{
+    return size() == 0;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::shards()const noexcept
+{
+    return _shardsCount;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::vector< _Key >
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::boundaries()const
+{
+    // resplit holds all locks, so layout can not change nor be reclaimed meanwhile
+    _Lock lock( _shards[ 0 ]._mutex );
+
+    return _layout.load( std::memory_order_relaxed )->_boundaries;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_compare
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_comp()const
+{
+    return _cmp;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::resplit( std::vector< _Key > const & boundaries )
+{
+    std::vector< _Lock > const locks = lockAll();
+
+    resplitLocked( boundaries );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::rebalance()
+{
+    std::vector< _Lock > const locks = lockAll();
+
+    rebalanceLocked();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::rebalanceLocked()
+{
+    std::size_t total = 0;
+
+    for( std::size_t index = 0 ; index < _shardsCount ; ++ index ){
+        total += _shards[ index ]._av.size();
+    }
+
+    std::vector< _Key > boundaries;
+
+    std::size_t shard = 0;
+    std::size_t skipped = 0;
+    std::size_t previous = 0;
+
+    for( std::size_t i = 1 ; i < _shardsCount ; ++ i )
+    {
+        std::size_t const rank = i * total / _shardsCount;
+
+        if( rank == previous ){
+            continue;
+        }
+
+        previous = rank;
+
+        while( rank - skipped >= _shards[ shard ]._av.size() )
+        {
+            skipped += _shards[ shard ]._av.size();
+            ++ shard;
+        }
+
+        boundaries.push_back( _shards[ shard ]._av.nth( rank - skipped )->first );
+    }
+
+    resplitLocked( boundaries );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+ShardedAssocVector< _Key, _Mapped, _Cmp, _Allocator >::resplitLocked( std::vector< _Key > const & boundaries )
+{
+    AV_PRECONDITION( boundaries.size() < _shardsCount );
+    AV_PRECONDITION( util::is_strictly_sorted( boundaries.begin(), boundaries.end(), _cmp ) );
+
+    // shards are ordered, so their flattened storages concatenated are sorted
+    std::vector< value_type > items;
+
+    for( std::size_t index = 0 ; index < _shardsCount ; ++ index )
+    {
+        typename shard_type::_Storage storage = _shards[ index ]._av.release_sorted();
+
+        items.insert(
+              items.end()
+            , std::make_move_iterator( storage.begin() )
+            , std::make_move_iterator( storage.end() )
+        );
+    }
+
+    typename std::vector< value_type >::iterator first = items.begin();
+
+    for( std::size_t index = 0 ; index < _shardsCount ; ++ index )
+    {
+        typename std::vector< value_type >::iterator const last
+            = index < boundaries.size()
+            ? std::lower_bound( first, items.end(), boundaries[ index ], util::CmpByFirst< value_type, _Cmp >( _cmp ) )
+            : items.end();
+
+        shard_type av = shard_type::from_sorted_unique(
+              std::make_move_iterator( first )
+            , std::make_move_iterator( last )
+            , _cmp
+        );
+
+        _shards[ index ]._av.swap( av );
+
+        first = last;
+    }
+
+    std::unique_ptr< _Layout > layout( new _Layout() );
+    layout->_boundaries = boundaries;
+    layout->_version = ++ _version;
+
+    for( std::size_t index = 0 ; index < _shardsCount ; ++ index ){
+        _shards[ index ]._version = layout->_version;
+    }
+
+    _splitPending = false;
+
+    // seq_cst, a router which still reads the previous layout has registered in _routers
+    // of the epoch before the flip and saw that epoch after registering, later ones see the new layout
+    _layout.store( layout.get() );
+
+    // layout holds the previous one from now on, it is destroyed on return
+    _current.swap( layout );
+
+    std::size_t const epoch = _epoch.fetch_add( 1 );
+
+    // routers do not lock, so they leave after one binary search
+    while( _routers[ epoch & 1 ].load() != 0 ){
+        std::this_thread::yield();
+    }
+}
+
+
+namespace detail
+{
+    template< typename _Rcu >
+    struct RcuAssocVectorReader;
+}
+
+//
+// RcuAssocVector, writers modify a private AssocVector under a mutex and publish immutable flat
+// versions of it through an atomic pointer, on every merge boundary ( AssocVector::is_flat ) or on publish,
+// readers are lock free, old versions are reclaimed with epochs
+//
+// a reader sees the last published version, so it may miss up to O( sqrt N ) latest writes
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp = std::less< _Key >
+    , typename _Allocator = std::allocator< std::pair< _Key, _Mapped > >
+>
+struct RcuAssocVector
+{
+public:
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > writer_type;
+
+    typedef _Key key_type;
+    typedef _Mapped mapped_type;
+
+    typedef std::pair< _Key, _Mapped > value_type;
+
+    typedef _Cmp key_compare;
+
+    typedef detail::RcuAssocVectorReader< RcuAssocVector > reader;
+
+private:
+    friend struct detail::RcuAssocVectorReader< RcuAssocVector >;
+
+    //
+    // _Version, immutable once published
+    //
+    struct _Version
+    {
+        template< typename __InputIterator >
+        _Version( __InputIterator first, __InputIterator last )
+            : _items( first, last )
+        {
+        }
+
+        std::vector< value_type > _items;
+    };
+
+    //
+    // _Slot, epoch pinned by one reader, 0 if the reader is not inside a read
+    //
+    struct _Slot
+    {
+        _Slot()
+            : _pinned( 0 )
+            , _used( false )
+        {
+        }
+
+        std::atomic< std::uint64_t > _pinned;
+        std::atomic< bool > _used;
+
+        char _padding[ AV_CACHE_LINE_SIZE ];
+    };
+
+public:
+    explicit RcuAssocVector( _Cmp const & cmp = _Cmp() );
+
+    RcuAssocVector( RcuAssocVector const & ) = delete;
+    RcuAssocVector & operator=( RcuAssocVector const & ) = delete;
+
+    //
+    // destructor, all readers have to be destroyed already
+    //
+    ~RcuAssocVector();
+
+    //
+    // writers, serialized by a mutex, publish if the writer is flat after the change and
+    // at least O( sqrt N ) writes, as many as fill the buffer of the writer, are unpublished
+    //
+    bool insert( value_type const & value );
+    bool insert_or_assign( key_type const & k, mapped_type const & m );
+
+    std::size_t erase( key_type const & k );
+
+    //
+    // publish, flattens the writer and publishes it, all preceding writes become visible to readers
+    //
+    void publish();
+
+    //
+    // size, number of items in the writer, not in the published version
+    //
+    std::size_t size()const;
+
+    key_compare key_comp()const;
+
+    //
+    // retired, versions waiting for readers to leave them, for unit tests
+    //
+    std::size_t retired()const;
+
+private:
+    void publishLocked();
+    void publishIfDueLocked();
+    void reclaimLocked();
+
+private:
+    _Cmp _cmp;
+
+    mutable std::mutex _writerMutex;
+
+    writer_type _writer;
+
+    // versions replaced by newer ones with epochs they were replaced at, guarded by _writerMutex
+    std::vector< std::pair< _Version const *, std::uint64_t > > _retired;
+
+    // writes since the last publish, guarded by _writerMutex
+    std::size_t _pending;
+
+    std::atomic< _Version const * > _current;
+    std::atomic< std::uint64_t > _epoch;
+
+    _Slot _slots[ AV_RCU_READERS ];
+};
+
+namespace detail
+{
+    //
+    // RcuAssocVectorReader, owns a reader slot of RcuAssocVector, to be used by one thread at a time,
+    // a read is: load epoch, pin it in own slot, load version pointer, search, unpin
+    //
+    template< typename _Rcu >
+    struct RcuAssocVectorReader
+    {
+    public:
+        typedef typename _Rcu::key_type key_type;
+        typedef typename _Rcu::mapped_type mapped_type;
+        typedef typename _Rcu::value_type value_type;
+
+        //
+        // constructor, throws std::runtime_error if all AV_RCU_READERS slots are taken
+        //
+        explicit RcuAssocVectorReader( _Rcu & rcu )
+            : _rcu( rcu )
+            , _slot( 0 )
+        {
+            for( std::size_t index = 0 ; index < AV_RCU_READERS ; ++ index )
+            {
+                bool expected = false;
+
+                if( rcu._slots[ index ]._used.compare_exchange_strong( expected, true ) )
+                {
+                    _slot = & rcu._slots[ index ];
+
+                    return;
+                }
+            }
+
+            throw std::runtime_error( "RcuAssocVectorReader: no free reader slot" );
+        }
+
+        RcuAssocVectorReader( RcuAssocVectorReader const & ) = delete;
+        RcuAssocVectorReader & operator=( RcuAssocVectorReader const & ) = delete;
+
+        ~RcuAssocVectorReader()
+        {
+            AV_PRECONDITION( _slot->_pinned.load() == 0 );
+
+            _slot->_used.store( false, std::memory_order_release );
+        }
+
+        //
+        // read, calls f( array::Span< value_type const > ) with the current version pinned,
+        // f must not use this reader
+        //
+        template< typename __Function >
+        void read( __Function f )
+        {
+            // seq_cst, writer either sees the pin or this load sees its new version
+            _slot->_pinned.store( _rcu._epoch.load() );
+
+            typename _Rcu::_Version const * const version = _rcu._current.load();
+
+            f( array::Span< value_type const >( version->_items.data(), version->_items.size() ) );
+
+            _slot->_pinned.store( 0, std::memory_order_release );
+        }
+
+        bool find( key_type const & k, mapped_type & m )
+        {
+            value_type const * found = 0;
+
+            _Find finder( _rcu._cmp, k, m, found );
+            read( finder );
+
+            return found != 0;
+        }
+
+        std::size_t count( key_type const & k )
+        {
+            mapped_type m;
+
+            return find( k, m ) ? 1 : 0;
+        }
+
+        bool lower_bound( key_type const & k, value_type & value )
+        {
+            bool found = false;
+
+            _LowerBound finder( _rcu._cmp, k, value, found );
+            read( finder );
+
+            return found;
+        }
+
+        std::size_t size()
+        {
+            std::size_t size = 0;
+
+            _Size sizer( size );
+            read( sizer );
+
+            return size;
+        }
+
+    private:
+        typedef util::CmpByFirst< value_type, typename _Rcu::key_compare > _ValueCmp;
+
+        struct _Find
+        {
+            _Find( typename _Rcu::key_compare const & cmp, key_type const & k, mapped_type & m, value_type const * & found )
+                : _cmp( cmp ), _k( k ), _m( m ), _found( found )
+            {
+            }
+
+            void operator()( array::Span< value_type const > const & items )
+            {
+                value_type const * const current = std::lower_bound( items.begin(), items.end(), _k, _ValueCmp( _cmp ) );
+
+                if( current != items.end() && _cmp( _k, current->first ) == false )
+                {
+                    _m = current->second;
+                    _found = current;
+                }
+            }
+
+            typename _Rcu::key_compare const & _cmp;
+            key_type const & _k;
+            mapped_type & _m;
+            value_type const * & _found;
+        };
+
+        struct _LowerBound
+        {
+            _LowerBound( typename _Rcu::key_compare const & cmp, key_type const & k, value_type & value, bool & found )
+                : _cmp( cmp ), _k( k ), _value( value ), _found( found )
+            {
+            }
+
+            void operator()( array::Span< value_type const > const & items )
+            {
+                value_type const * const current = std::lower_bound( items.begin(), items.end(), _k, _ValueCmp( _cmp ) );
+
+                if( current != items.end() )
+                {
+                    _value = * current;
+                    _found = true;
+                }
+            }
+
+            typename _Rcu::key_compare const & _cmp;
+            key_type const & _k;
+            value_type & _value;
+            bool & _found;
+        };
+
+        struct _Size
+        {
+            _Size( std::size_t & size )
+                : _size( size )
+            {
+            }
+
+            void operator()( array::Span< value_type const > const & items )
+            {
+                _size = items.size();
+            }
+
+            std::size_t & _size;
+        };
+
+    private:
+        _Rcu & _rcu;
+
+        typename _Rcu::_Slot * _slot;
+    };
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::RcuAssocVector( _Cmp const & cmp )
+    : _cmp( cmp )
+    , _writer( cmp )
+    , _pending( 0 )
+    , _current( 0 )
+    , _epoch( 1 )
+{
+    _current.store( new _Version( _writer.begin(), _writer.end() ) );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::~RcuAssocVector()
+{
+    for( std::size_t index = 0 ; index < AV_RCU_READERS ; ++ index ){
+        AV_PRECONDITION( _slots[ index ]._used.load() == false );
+    }
+
+    for( std::size_t index = 0 ; index < _retired.size() ; ++ index ){
+        delete _retired[ index ].first;
+    }
+
+    delete _current.load();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( value_type const & value )
+{
+    std::lock_guard< std::mutex > const lock( _writerMutex );
+
+    bool const result = _writer.insert( value ).second;
+
+    _pending += result ? 1 : 0;
+
+    publishIfDueLocked();
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign(
+      key_type const & k
+    , mapped_type const & m
+)
+{
+    std::lock_guard< std::mutex > const lock( _writerMutex );
+
+    bool const result = _writer.insert_or_assign( k, m ).second;
+
+    ++ _pending;
+
+    publishIfDueLocked();
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase( key_type const & k )
+{
+    std::lock_guard< std::mutex > const lock( _writerMutex );
+
+    std::size_t const result = _writer.erase( k );
+
+    _pending += result;
+
+    publishIfDueLocked();
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::publish()
+{
+    std::lock_guard< std::mutex > const lock( _writerMutex );
+
+    publishLocked();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::size()const
+{
+    std::lock_guard< std::mutex > const lock( _writerMutex );
+
+    return _writer.size();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_compare
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_comp()const
+{
+    return _cmp;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::retired()const
+{
+    std::lock_guard< std::mutex > const lock( _writerMutex );
+
+    return _retired.size();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::publishIfDueLocked()
+{
+    // a merge of the writer flattens it every O( sqrt N ) writes, appends and assignments in place
+    // keep it flat without a merge, so a publish, O(N), is due after as many writes, not on each,
+    // assignments do not fill the buffer either, so twice as many writes force a merge
+    std::size_t const due = std::max< std::size_t >( 1, writer_type::calculateNewBufferCapacity( _writer.size() ) );
+
+    if( _pending >= 2 * due || ( _pending >= due && _writer.is_flat() ) ){
+        publishLocked();
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::publishLocked()
+{
+    array::Span< value_type const > const items = _writer.sorted_span();
+
+    _Version const * const version = new _Version( items.begin(), items.end() );
+
+    // seq_cst, a reader pinning the new epoch loads the new version
+    _Version const * const old = _current.exchange( version );
+    std::uint64_t const epoch = _epoch.fetch_add( 1 ) + 1;
+
+    _retired.push_back( std::make_pair( old, epoch ) );
+
+    _pending = 0;
+
+    reclaimLocked();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+RcuAssocVector< _Key, _Mapped, _Cmp, _Allocator >::reclaimLocked()
+{
+    std::uint64_t oldestPinned = std::numeric_limits< std::uint64_t >::max();
+
+    for( std::size_t index = 0 ; index < AV_RCU_READERS ; ++ index )
+    {
+        std::uint64_t const pinned = _slots[ index ]._pinned.load();
+
+        if( pinned != 0 ){
+            oldestPinned = std::min( oldestPinned, pinned );
+        }
+    }
+
+    // a version retired at epoch E may be read only by readers pinned before E
+    std::size_t kept = 0;
+
+    for( std::size_t index = 0 ; index < _retired.size() ; ++ index )
+    {
+        if( _retired[ index ].second <= oldestPinned ){
+            delete _retired[ index ].first;
+        }
+        else{
+            _retired[ kept ++ ] = _retired[ index ];
+        }
+    }
+
+    _retired.resize( kept );
+}
+
+
+#ifdef AV_THREAD_SANITIZER
+    extern "C" void AnnotateIgnoreReadsBegin( char const * file, int line );
+    extern "C" void AnnotateIgnoreReadsEnd( char const * file, int line );
+#endif
+
+namespace detail
+{
+    //
+    // seqlockLoad, copies an item the writer of SeqlockAssocVector may change meanwhile into a local,
+    // the copy may be torn, it is used only if the sequence did not change,
+    // ThreadSanitizer cannot see the sequence check so it is told to ignore the copy
+    //
+    template< typename _T >
+    inline void seqlockLoad( _T & to, _T const * from )
+    {
+    #ifdef AV_THREAD_SANITIZER
+        AnnotateIgnoreReadsBegin( __FILE__, __LINE__ );
+    #endif
+
+        std::memcpy( static_cast< void * >( & to ), static_cast< void const * >( from ), sizeof( _T ) );
+
+    #ifdef AV_THREAD_SANITIZER
+        AnnotateIgnoreReadsEnd( __FILE__, __LINE__ );
+    #endif
+    }
+
+    //
+    // SeqlockAssocVectorRetired, blocks given back by AssocVector of SeqlockAssocVector,
+    // an optimistic reader may still read them, so they are freed on destruction only,
+    // blocks are linked through their headers, so retiring one does not allocate and can not throw
+    //
+    struct SeqlockAssocVectorRetired
+    {
+        SeqlockAssocVectorRetired()
+            : _blocks( 0 )
+        {
+        }
+
+        SeqlockAssocVectorRetired( SeqlockAssocVectorRetired const & ) = delete;
+        SeqlockAssocVectorRetired & operator=( SeqlockAssocVectorRetired const & ) = delete;
+
+        ~SeqlockAssocVectorRetired()
+        {
+            while( _blocks != 0 )
+            {
+                void * const next = * static_cast< void ** >( _blocks );
+
+                ::operator delete( _blocks );
+
+                _blocks = next;
+            }
+        }
+
+        void retire( void * block )noexcept
+        {
+            * static_cast< void ** >( block ) = _blocks;
+
+            _blocks = block;
+        }
+
+        void * _blocks;
+    };
+
+    //
+    // SeqlockAssocVectorAllocator, AssocVector reallocates only when it grows, capacities grow
+    // geometrically, so retired blocks take less memory than the live ones
+    //
+    // each block starts with a header for the link of SeqlockAssocVectorRetired, items follow it
+    //
+    template< typename _T >
+    struct SeqlockAssocVectorAllocator
+    {
+        typedef _T value_type;
+
+        typedef _T * pointer;
+        typedef _T const * const_pointer;
+
+        typedef _T & reference;
+        typedef _T const & const_reference;
+
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template< typename __T >
+        struct rebind{ typedef SeqlockAssocVectorAllocator< __T > other; };
+
+        static size_type const header = ( sizeof( void * ) + alignof( _T ) - 1 ) / alignof( _T ) * alignof( _T );
+
+        SeqlockAssocVectorAllocator( SeqlockAssocVectorRetired * retired = 0 )noexcept
+            : _retired( retired )
+        {
+        }
+
+        template< typename __T >
+        SeqlockAssocVectorAllocator( SeqlockAssocVectorAllocator< __T > const & other )noexcept
+            : _retired( other._retired )
+        {
+        }
+
+        pointer allocate( size_type n, void const * = 0 )
+        {
+            char * const block = static_cast< char * >( ::operator new( header + n * sizeof( _T ) ) );
+
+            return reinterpret_cast< pointer >( block + header );
+        }
+
+        void deallocate( pointer p, size_type )noexcept
+        {
+            if( p == 0 ){
+                return;
+            }
+
+            void * const block = reinterpret_cast< char * >( p ) - header;
+
+            if( _retired == 0 ){
+                ::operator delete( block );
+            }
+            else{
+                _retired->retire( block );
+            }
+        }
+
+        template<
+              typename __T
+            , typename... __Args
+        >
+        void construct( __T * p, __Args &&... args )
+        {
+            new ( static_cast< void * >( p ) ) __T( std::forward< __Args >( args )... );
+        }
+
+        template< typename __T >
+        void destroy( __T * p )
+        {
+            p -> ~__T();
+        }
+
+        size_type max_size()const noexcept
+        {
+            return ( size_type( -1 ) - header ) / sizeof( _T );
+        }
+
+        SeqlockAssocVectorRetired * _retired;
+    };
+
+    template<
+          typename _T1
+        , typename _T2
+    >
+    inline bool operator==( SeqlockAssocVectorAllocator< _T1 > const & lhs, SeqlockAssocVectorAllocator< _T2 > const & rhs )
+    {
+        return lhs._retired == rhs._retired;
+    }
+
+    template<
+          typename _T1
+        , typename _T2
+    >
+    inline bool operator!=( SeqlockAssocVectorAllocator< _T1 > const & lhs, SeqlockAssocVectorAllocator< _T2 > const & rhs )
+    {
+        return lhs._retired != rhs._retired;
+    }
+}
+
+//
+// SeqlockAssocVector, one writer and many readers, a write makes the sequence odd for its duration,
+// including any _merge or growth it causes, readers search storage, buffer and erased of the writer
+// optimistically and retry if the sequence changed meanwhile, readers never write shared memory
+//
+// the writer publishes the ranges through atomics before the sequence turns even, readers load them
+// and copy every item or erased entry they look at into a local before using it, see detail::seqlockLoad
+//
+// items have to be trivially copyable, a reader may see them torn before it retries,
+// memory given back by the writer is kept till destruction, so a reader never touches freed memory
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp = std::less< _Key >
+>
+struct SeqlockAssocVector
+{
+public:
+    typedef detail::SeqlockAssocVectorAllocator< std::pair< _Key, _Mapped > > allocator_type;
+
+    typedef AssocVector< _Key, _Mapped, _Cmp, allocator_type > writer_type;
+
+    typedef _Key key_type;
+    typedef _Mapped mapped_type;
+
+    typedef std::pair< _Key, _Mapped > value_type;
+
+    typedef _Cmp key_compare;
+
+    static_assert(
+          util::is_trivially_copyable< value_type >::value
+        , "SeqlockAssocVector: items are read optimistically, they have to be trivially copyable"
+    );
+
+private:
+    typedef typename writer_type::_Storage::const_iterator _ErasedItem;
+
+    //
+    // _Snapshot, storage, buffer and erased ranges read under a stable sequence
+    //
+    struct _Snapshot
+    {
+        value_type const * _storage;
+        value_type const * _storageEnd;
+
+        value_type const * _buffer;
+        value_type const * _bufferEnd;
+
+        _ErasedItem const * _erased;
+        _ErasedItem const * _erasedEnd;
+    };
+
+    //
+    // _Published, ranges of the writer, stored by the writer in odd sequence, loaded by readers
+    //
+    struct _Published
+    {
+        std::atomic< value_type const * > _storage;
+        std::atomic< value_type const * > _storageEnd;
+
+        std::atomic< value_type const * > _buffer;
+        std::atomic< value_type const * > _bufferEnd;
+
+        std::atomic< _ErasedItem const * > _erased;
+        std::atomic< _ErasedItem const * > _erasedEnd;
+    };
+
+public:
+    //
+    // constructor, capacity is reserved upfront
+    //
+    explicit SeqlockAssocVector( std::size_t capacity = 0, _Cmp const & cmp = _Cmp() );
+
+    SeqlockAssocVector( SeqlockAssocVector const & ) = delete;
+    SeqlockAssocVector & operator=( SeqlockAssocVector const & ) = delete;
+
+    //
+    // writers, one thread at a time
+    //
+    bool insert( value_type const & value );
+    bool insert_or_assign( key_type const & k, mapped_type const & m );
+
+    std::size_t erase( key_type const & k );
+
+    //
+    // readers, any number of threads
+    //
+    bool find( key_type const & k, mapped_type & m )const;
+
+    std::size_t count( key_type const & k )const;
+
+    bool lower_bound( key_type const & k, value_type & value )const;
+
+    std::size_t size()const;
+
+    key_compare key_comp()const;
+
+private:
+    void beginWrite();
+    void endWrite();
+
+    void publish();
+
+    //
+    // _WriteGuard, sequence is odd for its lifetime, ranges are published and the sequence
+    // is even again also if the write throws, readers would spin forever otherwise
+    //
+    struct _WriteGuard
+    {
+        explicit _WriteGuard( SeqlockAssocVector & sav )
+            : _sav( sav )
+        {
+            _sav.beginWrite();
+        }
+
+        ~_WriteGuard()
+        {
+            _sav.endWrite();
+        }
+
+        SeqlockAssocVector & _sav;
+    };
+
+    //
+    // read, calls f( snapshot ) until no write happened from taking the snapshot till f returned
+    //
+    template< typename __Function >
+    void read( __Function & f )const;
+
+    value_type const * lowerBound( value_type const * first, value_type const * last, key_type const & k )const;
+
+    _ErasedItem const * lowerBoundInErased( _Snapshot const & snapshot, value_type const * inStorage )const;
+
+    bool isErased( _Snapshot const & snapshot, _ErasedItem const * inErased, value_type const * inStorage )const;
+
+    struct _Find;
+    struct _LowerBound;
+    struct _Size;
+
+private:
+    _Cmp _cmp;
+
+    std::atomic< std::size_t > _sequence;
+
+    _Published _published;
+
+    // declared before _writer, blocks it gives back on destruction are retired first
+    detail::SeqlockAssocVectorRetired _retired;
+
+    writer_type _writer;
+};
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+struct SeqlockAssocVector< _Key, _Mapped, _Cmp >::_Find
+{
+    _Find( SeqlockAssocVector const & sav, key_type const & k )
+        : _sav( sav )
+        , _k( k )
+        , _found( false )
+    {
+    }
+
+    void operator()( _Snapshot const & snapshot )
+    {
+        _found = false;
+
+        key_type key;
+
+        value_type const * const inStorage = _sav.lowerBound( snapshot._storage, snapshot._storageEnd, _k );
+
+        if( inStorage != snapshot._storageEnd )
+        {
+            detail::seqlockLoad( key, & inStorage->first );
+
+            if( _sav._cmp( _k, key ) == false )
+            {
+                // an erased key is never in buffer
+                _ErasedItem const * const inErased = _sav.lowerBoundInErased( snapshot, inStorage );
+
+                if( _sav.isErased( snapshot, inErased, inStorage ) == false )
+                {
+                    detail::seqlockLoad( _m, & inStorage->second );
+                    _found = true;
+                }
+
+                return;
+            }
+        }
+
+        value_type const * const inBuffer = _sav.lowerBound( snapshot._buffer, snapshot._bufferEnd, _k );
+
+        if( inBuffer != snapshot._bufferEnd )
+        {
+            detail::seqlockLoad( key, & inBuffer->first );
+
+            if( _sav._cmp( _k, key ) == false )
+            {
+                detail::seqlockLoad( _m, & inBuffer->second );
+                _found = true;
+            }
+        }
+    }
+
+    SeqlockAssocVector const & _sav;
+    key_type const & _k;
+
+    mapped_type _m;
+    bool _found;
+};
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+struct SeqlockAssocVector< _Key, _Mapped, _Cmp >::_LowerBound
+{
+    _LowerBound( SeqlockAssocVector const & sav, key_type const & k )
+        : _sav( sav )
+        , _k( k )
+        , _found( false )
+    {
+    }
+
+    void operator()( _Snapshot const & snapshot )
+    {
+        value_type const * inStorage = _sav.lowerBound( snapshot._storage, snapshot._storageEnd, _k );
+
+        {// skip erased
+            _ErasedItem const * inErased = _sav.lowerBoundInErased( snapshot, inStorage );
+
+            while( inStorage != snapshot._storageEnd && _sav.isErased( snapshot, inErased, inStorage ) )
+            {
+                ++ inStorage;
+                ++ inErased;
+            }
+        }
+
+        value_type const * const inBuffer = _sav.lowerBound( snapshot._buffer, snapshot._bufferEnd, _k );
+
+        value_type const * result = inStorage;
+
+        if( inStorage == snapshot._storageEnd ){
+            result = inBuffer;
+        }
+        else if( inBuffer != snapshot._bufferEnd )
+        {
+            key_type inBufferKey;
+            detail::seqlockLoad( inBufferKey, & inBuffer->first );
+
+            key_type inStorageKey;
+            detail::seqlockLoad( inStorageKey, & inStorage->first );
+
+            if( _sav._cmp( inBufferKey, inStorageKey ) ){
+                result = inBuffer;
+            }
+        }
+
+        _found = result != snapshot._storageEnd && result != snapshot._bufferEnd;
+
+        if( _found ){
+            detail::seqlockLoad( _value, result );
+        }
+    }
+
+    SeqlockAssocVector const & _sav;
+    key_type const & _k;
+
+    value_type _value;
+    bool _found;
+};
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+struct SeqlockAssocVector< _Key, _Mapped, _Cmp >::_Size
+{
+    void operator()( _Snapshot const & snapshot )
+    {
+        _size
+            = ( snapshot._storageEnd - snapshot._storage )
+            + ( snapshot._bufferEnd - snapshot._buffer )
+            - ( snapshot._erasedEnd - snapshot._erased );
+    }
+
+    std::size_t _size;
+};
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::SeqlockAssocVector(
+      std::size_t capacity
+    , _Cmp const & cmp
+)
+    : _cmp( cmp )
+    , _sequence( 0 )
+    , _writer( cmp, allocator_type( & _retired ) )
+{
+    _writer.reserve( capacity );
+
+    publish();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+void
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::beginWrite()
+{
+    _sequence.store( _sequence.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+
+    // odd sequence is visible before any change of the writer
+    std::atomic_thread_fence( std::memory_order_release );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+void
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::endWrite()
+{
+    publish();
+
+    _sequence.store( _sequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+void
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::publish()
+{
+    _published._storage.store( _writer.storage().begin(), std::memory_order_relaxed );
+    _published._storageEnd.store( _writer.storage().end(), std::memory_order_relaxed );
+    _published._buffer.store( _writer.buffer().begin(), std::memory_order_relaxed );
+    _published._bufferEnd.store( _writer.buffer().end(), std::memory_order_relaxed );
+    _published._erased.store( _writer.erased().begin(), std::memory_order_relaxed );
+    _published._erasedEnd.store( _writer.erased().end(), std::memory_order_relaxed );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+bool
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::insert( value_type const & value )
+{
+    _WriteGuard const guard( * this );
+
+    return _writer.insert( value ).second;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+bool
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::insert_or_assign(
+      key_type const & k
+    , mapped_type const & m
+)
+{
+    _WriteGuard const guard( * this );
+
+    return _writer.insert_or_assign( k, m ).second;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+std::size_t
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::erase( key_type const & k )
+{
+    _WriteGuard const guard( * this );
+
+    return _writer.erase( k );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+template< typename __Function >
+void
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::read( __Function & f )const
+{
+    for( ;; )
+    {
+        std::size_t const sequence = _sequence.load( std::memory_order_acquire );
+
+        if( sequence % 2 == 1 )
+        {
+            std::this_thread::yield();
+
+            continue;
+        }
+
+        _Snapshot snapshot;
+
+        snapshot._storage = _published._storage.load( std::memory_order_relaxed );
+        snapshot._storageEnd = _published._storageEnd.load( std::memory_order_relaxed );
+        snapshot._buffer = _published._buffer.load( std::memory_order_relaxed );
+        snapshot._bufferEnd = _published._bufferEnd.load( std::memory_order_relaxed );
+        snapshot._erased = _published._erased.load( std::memory_order_relaxed );
+        snapshot._erasedEnd = _published._erasedEnd.load( std::memory_order_relaxed );
+
+        // ranges have to be consistent before they are searched
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        if( _sequence.load( std::memory_order_relaxed ) != sequence ){
+            continue;
+        }
+
+        f( snapshot );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        if( _sequence.load( std::memory_order_relaxed ) == sequence ){
+            return;
+        }
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+typename SeqlockAssocVector< _Key, _Mapped, _Cmp >::value_type const *
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::lowerBound(
+      value_type const * first
+    , value_type const * last
+    , key_type const & k
+)const
+{
+    std::size_t count = last - first;
+
+    while( count > 0 )
+    {
+        std::size_t const step = count / 2;
+
+        key_type key;
+        detail::seqlockLoad( key, & first[ step ].first );
+
+        if( _cmp( key, k ) )
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+typename SeqlockAssocVector< _Key, _Mapped, _Cmp >::_ErasedItem const *
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::lowerBoundInErased(
+      _Snapshot const & snapshot
+    , value_type const * inStorage
+)const
+{
+    _ErasedItem const * first = snapshot._erased;
+
+    std::size_t count = snapshot._erasedEnd - first;
+
+    while( count > 0 )
+    {
+        std::size_t const step = count / 2;
+
+        _ErasedItem erased;
+        detail::seqlockLoad( erased, first + step );
+
+        if( std::less< _ErasedItem >()( erased, inStorage ) )
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+bool
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::isErased(
+      _Snapshot const & snapshot
+    , _ErasedItem const * inErased
+    , value_type const * inStorage
+)const
+{
+    if( inErased == snapshot._erasedEnd ){
+        return false;
+    }
+
+    _ErasedItem erased;
+    detail::seqlockLoad( erased, inErased );
+
+    return erased == inStorage;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+bool
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::find(
+      key_type const & k
+    , mapped_type & m
+)const
+{
+    _Find finder( * this, k );
+    read( finder );
+
+    if( finder._found ){
+        m = finder._m;
+    }
+
+    return finder._found;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+std::size_t
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::count( key_type const & k )const
+{
+    _Find finder( * this, k );
+    read( finder );
+
+    return finder._found ? 1 : 0;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+bool
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::lower_bound(
+      key_type const & k
+    , value_type & value
+)const
+{
+    _LowerBound finder( * this, k );
+    read( finder );
+
+    if( finder._found ){
+        value = finder._value;
+    }
+
+    return finder._found;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+std::size_t
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::size()const
+{
+    _Size sizer;
+    read( sizer );
+
+    return sizer._size;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+>
+typename SeqlockAssocVector< _Key, _Mapped, _Cmp >::key_compare
+SeqlockAssocVector< _Key, _Mapped, _Cmp >::key_comp()const
+{
+    return _cmp;
+}
+
+
+namespace detail
+{
+    //
+    // ParallelRunTask, runs f( thread ) and keeps its exception for the calling thread
+    //
+    template< typename _Function >
+    struct ParallelRunTask
+    {
+        ParallelRunTask( _Function & f, std::size_t thread, std::exception_ptr & error )
+            : _f( f )
+            , _thread( thread )
+            , _error( error )
+        {
+        }
+
+        void operator()()
+        {
+            try{
+                _f( _thread );
+            }
+            catch( ... ){
+                _error = std::current_exception();
+            }
+        }
+
+        _Function & _f;
+        std::size_t _thread;
+        std::exception_ptr & _error;
+    };
+
+    //
+    // parallelRun, calls f( thread ) for thread in [ 0, threads ), thread 0 runs on the calling thread,
+    // the first exception thrown by f is rethrown after all threads are joined
+    //
+    template< typename _Function >
+    void parallelRun( std::size_t threads, _Function & f )
+    {
+        AV_PRECONDITION( threads > 0 );
+
+        std::vector< std::exception_ptr > errors( threads );
+        std::vector< std::thread > workers;
+
+        try
+        {
+            for( std::size_t thread = 1 ; thread < threads ; ++ thread ){
+                workers.push_back( std::thread( ParallelRunTask< _Function >( f, thread, errors[ thread ] ) ) );
+            }
+        }
+        catch( ... )
+        {
+            for( std::size_t index = 0 ; index < workers.size() ; ++ index ){
+                workers[ index ].join();
+            }
+
+            throw;
+        }
+
+        ParallelRunTask< _Function >( f, 0, errors[ 0 ] )();
+
+        for( std::size_t index = 0 ; index < workers.size() ; ++ index ){
+            workers[ index ].join();
+        }
+
+        for( std::size_t thread = 0 ; thread < threads ; ++ thread )
+        {
+            if( errors[ thread ] ){
+                std::rethrow_exception( errors[ thread ] );
+            }
+        }
+    }
+
+    //
+    // parallelThreads, 0 means all cores, small inputs are not split
+    //
+    inline std::size_t parallelThreads( std::size_t threads, std::size_t items )
+    {
+        if( threads == 0 ){
+            threads = std::max< std::size_t >( 1, std::thread::hardware_concurrency() );
+        }
+
+        return std::max< std::size_t >( 1, std::min( threads, items / AV_PARALLEL_MIN_ITEMS ) );
+    }
+
+    //
+    // radixKey, order preserving map of an integral key into unsigned
+    //
+    template< typename _Key >
+    typename std::make_unsigned< _Key >::type radixKey( _Key k )
+    {
+        typedef typename std::make_unsigned< _Key >::type Unsigned;
+
+        Unsigned const result = static_cast< Unsigned >( k );
+
+        if( std::is_signed< _Key >::value ){
+            return static_cast< Unsigned >( result ^ ( Unsigned( 1 ) << ( 8 * sizeof( Unsigned ) - 1 ) ) );
+        }
+
+        return result;
+    }
+
+    //
+    // ParallelBuildSortKey, integral keys compared with std::less are sorted as radixKey with radix sort
+    //
+    template<
+          typename _Key
+        , typename _Cmp
+        , bool _Radix = std::is_integral< _Key >::value
+            && std::is_same< _Key, bool >::value == false
+            && std::is_same< _Cmp, std::less< _Key > >::value
+    >
+    struct ParallelBuildSortKey
+    {
+        typedef _Key type;
+        typedef _Cmp compare;
+
+        static bool const radix = false;
+
+        static _Key const & get( _Key const & k ){ return k; }
+        static _Cmp const & getCompare( _Cmp const & cmp ){ return cmp; }
+    };
+
+    template<
+          typename _Key
+        , typename _Cmp
+    >
+    struct ParallelBuildSortKey< _Key, _Cmp, true >
+    {
+        typedef typename std::make_unsigned< _Key >::type type;
+        typedef std::less< type > compare;
+
+        static bool const radix = true;
+
+        static type get( _Key k ){ return radixKey( k ); }
+        static compare getCompare( _Cmp const & ){ return compare(); }
+    };
+
+    //
+    // AssocVectorParallelBuild, state shared by parallel_build phases
+    //
+    // sort: thread t sorts ( key, index ) of its chunk of input, radix sort for integral keys
+    // count: thread t k-way merges key range t of all chunks and counts unique keys
+    // write: thread t merges its range again, constructs winners straight in storage at its offset
+    //
+    template<
+          typename _AssocVector
+        , typename _RandomAccessIterator
+    >
+    struct AssocVectorParallelBuild
+    {
+        typedef typename _AssocVector::key_type _Key;
+        typedef typename _AssocVector::key_compare _Cmp;
+        typedef typename _AssocVector::_Storage _Storage;
+        typedef typename _Storage::value_type _Value;
+
+        typedef ParallelBuildSortKey< _Key, _Cmp > _SortKey;
+
+        typedef typename _SortKey::type _SortKeyType;
+        typedef typename _SortKey::compare _SortCmp;
+
+        typedef std::pair< _SortKeyType, std::size_t > _Entry;
+        typedef std::vector< _Entry > _Chunk;
+
+        //
+        // _EntryCmp, by key, by index for equal keys
+        //
+        struct _EntryCmp
+        {
+            _EntryCmp( _SortCmp const & cmp )
+                : _cmp( cmp )
+            {
+            }
+
+            bool operator()( _Entry const & lhs, _Entry const & rhs )const
+            {
+                if( _cmp( lhs.first, rhs.first ) ){
+                    return true;
+                }
+
+                if( _cmp( rhs.first, lhs.first ) ){
+                    return false;
+                }
+
+                return lhs.second < rhs.second;
+            }
+
+            bool operator()( _Entry const & lhs, _SortKeyType const & rhs )const
+            {
+                return _cmp( lhs.first, rhs );
+            }
+
+            _SortCmp _cmp;
+        };
+
+        //
+        // _Phase, calls a method for a thread, for parallelRun
+        //
+        struct _Phase
+        {
+            _Phase( AssocVectorParallelBuild & build, void ( AssocVectorParallelBuild::*method )( std::size_t ) )
+                : _build( build )
+                , _method( method )
+            {
+            }
+
+            void operator()( std::size_t thread )
+            {
+                ( _build.*_method )( thread );
+            }
+
+            AssocVectorParallelBuild & _build;
+            void ( AssocVectorParallelBuild::*_method )( std::size_t );
+        };
+
+        struct _Count
+        {
+            void operator()( std::size_t )
+            {
+                ++ _count;
+            }
+
+            std::size_t _count;
+        };
+
+        struct _Write
+        {
+            void operator()( std::size_t index )
+            {
+                new ( static_cast< void * >( _current ) ) _Value( _build._first[ index ] );
+
+                ++ _current;
+            }
+
+            AssocVectorParallelBuild const & _build;
+            _Value * _current;
+        };
+
+        AssocVectorParallelBuild(
+              _RandomAccessIterator first
+            , std::size_t size
+            , std::size_t threads
+            , _Cmp const & cmp
+        )
+            : _first( first )
+            , _size( size )
+            , _threads( threads )
+            , _cmp( _SortKey::getCompare( cmp ) )
+            , _chunks( threads )
+            , _counts( threads )
+            , _storage( 0 )
+            , _written( threads, std::pair< _Value *, _Value * >( 0, 0 ) )
+        {
+        }
+
+        void sort( std::size_t thread )
+        {
+            std::size_t const begin = thread * _size / _threads;
+            std::size_t const end = ( thread + 1 ) * _size / _threads;
+
+            _Chunk & chunk = _chunks[ thread ];
+            chunk.reserve( end - begin );
+
+            // keys are copied next to indices, so merge does not jump over input
+            for( std::size_t index = begin ; index != end ; ++ index ){
+                chunk.push_back( _Entry( _SortKey::get( _first[ index ].first ), index ) );
+            }
+
+            sort( chunk, std::integral_constant< bool, _SortKey::radix >() );
+        }
+
+        void sort( _Chunk & chunk, std::true_type /*radix*/ )
+        {
+            // stable, equal keys stay ordered by index
+            util::radix_sort( chunk );
+        }
+
+        void sort( _Chunk & chunk, std::false_type /*radix*/ )
+        {
+            std::sort( chunk.begin(), chunk.end(), _EntryCmp( _cmp ) );
+        }
+
+        //
+        // split, picks threads - 1 keys from samples of sorted chunks
+        //
+        void split()
+        {
+            std::vector< _SortKeyType > samples;
+
+            for( std::size_t chunk = 0 ; chunk < _threads ; ++ chunk )
+            {
+                for( std::size_t i = 0 ; i < _threads ; ++ i )
+                {
+                    if( _chunks[ chunk ].empty() == false ){
+                        samples.push_back( _chunks[ chunk ][ i * _chunks[ chunk ].size() / _threads ].first );
+                    }
+                }
+            }
+
+            std::sort( samples.begin(), samples.end(), _cmp );
+
+            for( std::size_t thread = 1 ; thread < _threads && samples.empty() == false ; ++ thread ){
+                _splitters.push_back( samples[ thread * samples.size() / _threads ] );
+            }
+        }
+
+        //
+        // range, entries of key range [ splitter[ thread - 1 ], splitter[ thread ] ) in a chunk
+        //
+        std::pair< _Entry const *, _Entry const * > range( std::size_t thread, std::size_t chunk )const
+        {
+            _Entry const * first = _chunks[ chunk ].data();
+            _Entry const * last = first + _chunks[ chunk ].size();
+
+            if( thread < _splitters.size() ){
+                last = std::lower_bound( first, last, _splitters[ thread ], _EntryCmp( _cmp ) );
+            }
+
+            if( thread > 0 )
+            {
+                first = thread - 1 < _splitters.size()
+                    ? std::lower_bound( first, last, _splitters[ thread - 1 ], _EntryCmp( _cmp ) )
+                    : last;
+            }
+
+            return std::make_pair( first, last );
+        }
+
+        //
+        // merge, calls visit( index ) for each key of range, index is the last input item with this key
+        //
+        template< typename __Visitor >
+        void merge( std::size_t thread, __Visitor & visit )const
+        {
+            std::vector< std::pair< _Entry const *, _Entry const * > > cursors( _threads );
+
+            for( std::size_t chunk = 0 ; chunk < _threads ; ++ chunk ){
+                cursors[ chunk ] = range( thread, chunk );
+            }
+
+            for( ;; )
+            {
+                std::size_t smallest = _threads;
+
+                for( std::size_t chunk = 0 ; chunk < _threads ; ++ chunk )
+                {
+                    if( cursors[ chunk ].first == cursors[ chunk ].second ){
+                        continue;
+                    }
+
+                    if( smallest == _threads || _cmp( cursors[ chunk ].first->first, cursors[ smallest ].first->first ) ){
+                        smallest = chunk;
+                    }
+                }
+
+                if( smallest == _threads ){
+                    return;
+                }
+
+                _SortKeyType const & k = cursors[ smallest ].first->first;
+
+                std::size_t winner = cursors[ smallest ].first->second;
+
+                for( std::size_t chunk = 0 ; chunk < _threads ; ++ chunk )
+                {
+                    for( /*empty*/ ; cursors[ chunk ].first != cursors[ chunk ].second ; ++ cursors[ chunk ].first )
+                    {
+                        if( _cmp( k, cursors[ chunk ].first->first ) ){
+                            break;
+                        }
+
+                        winner = std::max( winner, cursors[ chunk ].first->second );
+                    }
+                }
+
+                visit( winner );
+            }
+        }
+
+        void count( std::size_t thread )
+        {
+            _Count counter = { 0 };
+
+            merge( thread, counter );
+
+            _counts[ thread ] = counter._count;
+        }
+
+        void write( std::size_t thread )
+        {
+            std::size_t offset = 0;
+
+            for( std::size_t previous = 0 ; previous < thread ; ++ previous ){
+                offset += _counts[ previous ];
+            }
+
+            _Write writer = { * this, _storage->data() + offset };
+
+            _written[ thread ].first = writer._current;
+
+            try{
+                merge( thread, writer );
+            }
+            catch( ... )
+            {
+                _written[ thread ].second = writer._current;
+
+                throw;
+            }
+
+            _written[ thread ].second = writer._current;
+        }
+
+        _RandomAccessIterator _first;
+        std::size_t _size;
+        std::size_t _threads;
+        _SortCmp _cmp;
+
+        std::vector< _Chunk > _chunks;
+        std::vector< _SortKeyType > _splitters;
+        std::vector< std::size_t > _counts;
+
+        _Storage * _storage;
+
+        // items constructed by each thread in write
+        std::vector< std::pair< _Value *, _Value * > > _written;
+    };
+}
+
+//
+// parallel_build, builds a container from unsorted input on threads ( 0 means all cores ),
+// the last of items with equal keys wins, items are constructed straight in storage
+// obtained from allocator
+//
+template<
+      typename _AssocVector
+    , typename _RandomAccessIterator
+>
+_AssocVector
+parallel_build(
+      _RandomAccessIterator first
+    , _RandomAccessIterator last
+    , std::size_t threads = 0
+    , typename _AssocVector::key_compare const & cmp = typename _AssocVector::key_compare()
+    , typename _AssocVector::allocator_type const & allocator = typename _AssocVector::allocator_type()
+)
+{
+    static_assert(
+          std::is_same<
+                typename std::iterator_traits< _RandomAccessIterator >::iterator_category
+              , std::random_access_iterator_tag
+          >::value
+        , "parallel_build: random access iterators are required"
+    );
+
+    typedef detail::AssocVectorParallelBuild< _AssocVector, _RandomAccessIterator > Build;
+
+    AV_PRECONDITION( first <= last );
+
+    std::size_t const size = last - first;
+
+    Build build( first, size, detail::parallelThreads( threads, size ), cmp );
+
+    {
+        typename Build::_Phase sort( build, & Build::sort );
+        detail::parallelRun( build._threads, sort );
+    }
+
+    build.split();
+
+    {
+        typename Build::_Phase count( build, & Build::count );
+        detail::parallelRun( build._threads, count );
+    }
+
+    std::size_t total = 0;
+
+    for( std::size_t thread = 0 ; thread < build._threads ; ++ thread ){
+        total += build._counts[ thread ];
+    }
+
+    // capacity is exactly the final size, as from_sorted_unique does, calculateNewStorageCapacity
+    // would reserve up to twice of it which for a very large map built to be mostly read
+    // is memory never used, the first merge grows storage as usual
+    typename _AssocVector::_Storage storage( total, allocator );
+    build._storage = & storage;
+
+    try
+    {
+        typename Build::_Phase write( build, & Build::write );
+        detail::parallelRun( build._threads, write );
+    }
+    catch( ... )
+    {
+        for( std::size_t thread = 0 ; thread < build._threads ; ++ thread ){
+            util::destroy_range( build._written[ thread ].first, build._written[ thread ].second );
+        }
+
+        throw;
+    }
+
+    storage.setSize( total );
+
+    return _AssocVector::from_sorted_unique( std::move( storage ), cmp );
+}
+
+namespace detail
+{
+    //
+    // AssocVectorParallelForEach, thread t calls its own copy of f on items of part t
+    //
+    template<
+          typename _Part
+        , typename _Function
+    >
+    struct AssocVectorParallelForEach
+    {
+        AssocVectorParallelForEach( std::vector< _Part > const & parts, _Function const & f )
+            : _parts( parts )
+            , _f( f )
+        {
+        }
+
+        void operator()( std::size_t thread )
+        {
+            _Function f( _f );
+
+            for( _Part part = _parts[ thread ] ; part.done() == false ; part.next() ){
+                f( * part.get() );
+            }
+        }
+
+        std::vector< _Part > const & _parts;
+        _Function const & _f;
+    };
+
+    //
+    // AssocVectorParallelReduce, thread t folds items of part t into results[ t ]
+    //
+    template<
+          typename _Part
+        , typename _T
+        , typename _Reduce
+    >
+    struct AssocVectorParallelReduce
+    {
+        AssocVectorParallelReduce( std::vector< _Part > const & parts, _Reduce const & reduce, std::vector< _T > & results )
+            : _parts( parts )
+            , _reduce( reduce )
+            , _results( results )
+        {
+        }
+
+        void operator()( std::size_t thread )
+        {
+            _Reduce reduce( _reduce );
+
+            _T result( _results[ thread ] );
+
+            for( _Part part = _parts[ thread ] ; part.done() == false ; part.next() ){
+                result = reduce( result, * part.get() );
+            }
+
+            _results[ thread ] = result;
+        }
+
+        std::vector< _Part > const & _parts;
+        _Reduce const & _reduce;
+        std::vector< _T > & _results;
+    };
+}
+
+//
+// parallel_for_each, calls f( value ) for all items, parts given by AssocVector::split run on threads,
+// each thread calls its own copy of f, items of one part are visited in key order, 0 threads means all cores
+//
+template<
+      typename _AssocVector
+    , typename _Function
+>
+void parallel_for_each( _AssocVector const & av, _Function f, std::size_t threads = 0 )
+{
+    typedef typename _AssocVector::part_type Part;
+
+    std::vector< Part > const parts = av.split( detail::parallelThreads( threads, av.size() ) );
+
+    detail::AssocVectorParallelForEach< Part, _Function > forEach( parts, f );
+    detail::parallelRun( parts.size(), forEach );
+}
+
+//
+// parallel_reduce, folds items of each part with reduce( result, value ) starting from init,
+// results of parts are combined in key order with combine( lhs, rhs ), so init has to be an identity of combine
+//
+template<
+      typename _AssocVector
+    , typename _T
+    , typename _Reduce
+    , typename _Combine
+>
+_T parallel_reduce( _AssocVector const & av, _T init, _Reduce reduce, _Combine combine, std::size_t threads = 0 )
+{
+    typedef typename _AssocVector::part_type Part;
+
+    std::vector< Part > const parts = av.split( detail::parallelThreads( threads, av.size() ) );
+
+    std::vector< _T > results( parts.size(), init );
+
+    detail::AssocVectorParallelReduce< Part, _T, _Reduce > reducer( parts, reduce, results );
+    detail::parallelRun( parts.size(), reducer );
+
+    _T result = results[ 0 ];
+
+    for( std::size_t part = 1 ; part < results.size() ; ++ part ){
+        result = combine( result, results[ part ] );
+    }
+
+    return result;
+}
+
+
+//
+// FlatCombiningAssocVector, thread safe map, a thread which finds the combiner lock taken publishes
+// its operation in a slot and waits, the thread which takes the lock does operations of all waiting threads as one batch
+//
+// a batch is sorted by key, each key is looked up once in key order, erased keys are erased with
+// erase_keys and new items are inserted with one bulk insert, so a large batch costs at most one merge
+//
+// operations in one batch are concurrent, operations on the same key in one batch are applied in an arbitrary order,
+// if the combiner fails, operations on keys whose change was not applied throw, the others return as usual
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp = std::less< _Key >
+    , typename _Allocator = std::allocator< std::pair< _Key, _Mapped > >
+>
+struct FlatCombiningAssocVector
+{
+public:
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > combined_type;
+
+    typedef _Key key_type;
+    typedef _Mapped mapped_type;
+
+    typedef std::pair< _Key, _Mapped > value_type;
+
+    typedef _Cmp key_compare;
+
+private:
+    enum _Operation
+    {
+          _Insert
+        , _InsertOrAssign
+        , _Erase
+        , _Find
+    };
+
+    enum _State
+    {
+          _Idle
+        , _Pending
+        , _Done
+    };
+
+    enum _Effect
+    {
+          _Keep
+        , _Assign
+        , _Remove
+        , _Add
+    };
+
+    //
+    // _Slot, operation of one thread, arguments point to the stack of the waiting thread
+    //
+    struct _Slot
+    {
+        _Slot()
+            : _used( false )
+            , _state( _Idle )
+        {
+        }
+
+        std::atomic< bool > _used;
+        std::atomic< int > _state;
+
+        _Operation _operation;
+
+        key_type const * _key;
+        mapped_type const * _mapped;
+
+        // find copies mapped value here if it is not null
+        mapped_type * _found;
+
+        // mapped value a find of a batch copies once the batch is staged
+        mapped_type const * _value;
+
+        std::size_t _result;
+        std::exception_ptr _exception;
+
+        char _padding[ AV_CACHE_LINE_SIZE ];
+    };
+
+    //
+    // _SlotCmp, by key, equal keys by slot address, which is an arbitrary order
+    //
+    struct _SlotCmp
+    {
+        _SlotCmp( _Cmp const & cmp )
+            : _cmp( cmp )
+        {
+        }
+
+        bool operator()( _Slot const * lhs, _Slot const * rhs )const
+        {
+            if( _cmp( * lhs->_key, * rhs->_key ) ){
+                return true;
+            }
+
+            if( _cmp( * rhs->_key, * lhs->_key ) ){
+                return false;
+            }
+
+            return lhs < rhs;
+        }
+
+        _Cmp const & _cmp;
+    };
+
+    //
+    // _Change, net effect of operations of slots [ _first, _last ) of the batch, all on one key
+    //
+    struct _Change
+    {
+        std::size_t _first;
+        std::size_t _last;
+
+        _Effect _effect;
+
+        typename combined_type::iterator _found;
+        mapped_type const * _value;
+    };
+
+public:
+    explicit FlatCombiningAssocVector( _Cmp const & cmp = _Cmp() );
+
+    FlatCombiningAssocVector( FlatCombiningAssocVector const & ) = delete;
+    FlatCombiningAssocVector & operator=( FlatCombiningAssocVector const & ) = delete;
+
+    //
+    // methods, block until the operation is done by this or another thread
+    //
+    bool insert( value_type const & value );
+    bool insert_or_assign( key_type const & k, mapped_type const & m );
+
+    std::size_t erase( key_type const & k );
+
+    //
+    // find, copies mapped value of k into m if k is present
+    //
+    bool find( key_type const & k, mapped_type & m );
+
+    std::size_t count( key_type const & k );
+
+    //
+    // size, takes the combiner lock
+    //
+    std::size_t size()const;
+
+    key_compare key_comp()const;
+
+private:
+    std::size_t execute( _Operation operation, key_type const & k, mapped_type const * mapped, mapped_type * found );
+
+    //
+    // acquireSlot, a free slot starting from one given by thread id, yields if all AV_FLAT_COMBINING_SLOTS are taken
+    //
+    _Slot & acquireSlot();
+
+    void combineLocked();
+
+    //
+    // applyLocked, may throw before the map is changed and before finds copy out only, an exception
+    // while the map is changed is given to slots of keys whose change was not applied
+    //
+    void applyLocked();
+
+    //
+    // failLocked, gives exception to all slots of change
+    //
+    void failLocked( _Change const & change, std::exception_ptr const & exception );
+
+    //
+    // applyOneLocked, an operation straight on the map, when there is nothing to combine it with
+    //
+    std::size_t applyOneLocked( _Operation operation, key_type const & k, mapped_type const * mapped, mapped_type * found );
+
+private:
+    _Cmp _cmp;
+
+    mutable std::mutex _combinerMutex;
+
+    combined_type _av;
+
+    // guarded by _combinerMutex, kept between batches to not allocate on each of them
+    std::vector< _Slot * > _batch;
+    std::vector< _Change > _changes;
+    std::vector< key_type > _erasedKeys;
+    std::vector< value_type > _insertedItems;
+
+    // number of pending slots, the combiner does not scan slots if there are none
+    std::atomic< std::size_t > _pending;
+
+    _Slot _slots[ AV_FLAT_COMBINING_SLOTS ];
+};
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::FlatCombiningAssocVector( _Cmp const & cmp )
+    : _cmp( cmp )
+    , _av( cmp )
+    , _pending( 0 )
+{
+    _batch.reserve( AV_FLAT_COMBINING_SLOTS );
+    _changes.reserve( AV_FLAT_COMBINING_SLOTS );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert( value_type const & value )
+{
+    return execute( _Insert, value.first, & value.second, 0 ) != 0;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::insert_or_assign(
+      key_type const & k
+    , mapped_type const & m
+)
+{
+    return execute( _InsertOrAssign, k, & m, 0 ) != 0;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::erase( key_type const & k )
+{
+    return execute( _Erase, k, 0, 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::find(
+      key_type const & k
+    , mapped_type & m
+)
+{
+    return execute( _Find, k, 0, & m ) != 0;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::count( key_type const & k )
+{
+    return execute( _Find, k, 0, 0 );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::size()const
+{
+    std::lock_guard< std::mutex > const lock( _combinerMutex );
+
+    return _av.size();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_compare
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_comp()const
+{
+    return _cmp;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::execute(
+      _Operation operation
+    , key_type const & k
+    , mapped_type const * mapped
+    , mapped_type * found
+)
+{
+    {
+        std::unique_lock< std::mutex > lock( _combinerMutex, std::try_to_lock );
+
+        // uncontended, no slot is needed, threads which published meanwhile are combined after
+        if( lock.owns_lock() )
+        {
+            std::size_t const result = applyOneLocked( operation, k, mapped, found );
+
+            combineLocked();
+
+            return result;
+        }
+    }
+
+    _Slot & slot = acquireSlot();
+
+    slot._operation = operation;
+    slot._key = & k;
+    slot._mapped = mapped;
+    slot._found = found;
+
+    // a combiner which misses the slot is not waited for, this thread tries the lock itself
+    _pending.fetch_add( 1, std::memory_order_relaxed );
+
+    // arguments are visible to the combiner which sees the pending state
+    slot._state.store( _Pending, std::memory_order_release );
+
+    while( slot._state.load( std::memory_order_acquire ) != _Done )
+    {
+        std::unique_lock< std::mutex > lock( _combinerMutex, std::try_to_lock );
+
+        if( lock.owns_lock() ){
+            combineLocked();
+        }
+        else{
+            std::this_thread::yield();
+        }
+    }
+
+    std::size_t const result = slot._result;
+
+    std::exception_ptr exception;
+    std::swap( exception, slot._exception );
+
+    slot._state.store( _Idle, std::memory_order_relaxed );
+    slot._used.store( false, std::memory_order_release );
+
+    if( exception ){
+        std::rethrow_exception( exception );
+    }
+
+    return result;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::_Slot &
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::acquireSlot()
+{
+    // threads start from different slots, so they rarely compete for one
+    std::size_t const start = std::hash< std::thread::id >()( std::this_thread::get_id() );
+
+    for( ;; )
+    {
+        for( std::size_t index = 0 ; index < AV_FLAT_COMBINING_SLOTS ; ++ index )
+        {
+            _Slot & slot = _slots[ ( start + index ) % AV_FLAT_COMBINING_SLOTS ];
+
+            bool expected = false;
+
+            if( slot._used.load( std::memory_order_relaxed ) == false
+                && slot._used.compare_exchange_strong( expected, true, std::memory_order_acquire ) )
+            {
+                return slot;
+            }
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::combineLocked()
+{
+    if( _pending.load( std::memory_order_relaxed ) == 0 ){
+        return;
+    }
+
+    _batch.clear();
+
+    for( std::size_t index = 0 ; index < AV_FLAT_COMBINING_SLOTS ; ++ index )
+    {
+        if( _slots[ index ]._state.load( std::memory_order_acquire ) == _Pending ){
+            _batch.push_back( & _slots[ index ] );
+        }
+    }
+
+    if( _batch.empty() ){
+        return;
+    }
+
+    _pending.fetch_sub( _batch.size(), std::memory_order_relaxed );
+
+    std::sort( _batch.begin(), _batch.end(), _SlotCmp( _cmp ) );
+
+    try
+    {
+        if( _batch.size() == 1 ){
+            _batch[ 0 ]->_result = applyOneLocked( _batch[ 0 ]->_operation, * _batch[ 0 ]->_key, _batch[ 0 ]->_mapped, _batch[ 0 ]->_found );
+        }
+        else{
+            applyLocked();
+        }
+    }
+    catch( ... )
+    {
+        // nothing of the batch is applied
+        std::exception_ptr const exception = std::current_exception();
+
+        for( std::size_t index = 0 ; index < _batch.size() ; ++ index ){
+            _batch[ index ]->_exception = exception;
+        }
+    }
+
+    // a slot may be reused as soon as it is done, so it is not touched afterwards
+    for( std::size_t index = 0 ; index < _batch.size() ; ++ index ){
+        _batch[ index ]->_state.store( _Done, std::memory_order_release );
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::applyLocked()
+{
+    _changes.clear();
+    _erasedKeys.clear();
+    _insertedItems.clear();
+
+    std::size_t first = 0;
+
+    // changes are found and staged first, the map stays as it is if that throws
+    while( first != _batch.size() )
+    {
+        key_type const & k = * _batch[ first ]->_key;
+
+        typename combined_type::iterator const found = _av.find( k );
+
+        bool const wasPresent = found != _av.end();
+
+        // state of k after operations applied so far, value points to the current mapped value
+        bool present = wasPresent;
+        mapped_type const * value = wasPresent ? & found->second : 0;
+
+        std::size_t last = first;
+
+        for( /*empty*/ ; last != _batch.size() && _cmp( k, * _batch[ last ]->_key ) == false ; ++ last )
+        {
+            _Slot & slot = * _batch[ last ];
+
+            switch( slot._operation )
+            {
+                case _Insert:
+                    slot._result = present ? 0 : 1;
+
+                    if( present == false ){
+                        present = true;
+                        value = slot._mapped;
+                    }
+
+                    break;
+
+                case _InsertOrAssign:
+                    slot._result = present ? 0 : 1;
+
+                    present = true;
+                    value = slot._mapped;
+
+                    break;
+
+                case _Erase:
+                    slot._result = present ? 1 : 0;
+
+                    present = false;
+                    value = 0;
+
+                    break;
+
+                case _Find:
+                    slot._result = present ? 1 : 0;
+                    slot._value = value;
+
+                    break;
+            }
+        }
+
+        _Change change;
+
+        change._first = first;
+        change._last = last;
+        change._effect = _Keep;
+        change._found = found;
+        change._value = value;
+
+        if( wasPresent && present && value != & found->second ){
+            change._effect = _Assign;
+        }
+        else if( wasPresent && present == false )
+        {
+            change._effect = _Remove;
+            _erasedKeys.push_back( k );
+        }
+        else if( wasPresent == false && present )
+        {
+            change._effect = _Add;
+            _insertedItems.push_back( value_type( k, * value ) );
+        }
+
+        _changes.push_back( change );
+
+        first = last;
+    }
+
+    // finds copy out once nothing can fail the whole batch, before assignments change what they saw,
+    // a copy which fails fails its find only
+    for( std::size_t index = 0 ; index < _batch.size() ; ++ index )
+    {
+        _Slot & slot = * _batch[ index ];
+
+        if( slot._operation != _Find || slot._result == 0 || slot._found == 0 ){
+            continue;
+        }
+
+        try
+        {
+            * slot._found = * slot._value;
+        }
+        catch( ... )
+        {
+            slot._exception = std::current_exception();
+        }
+    }
+
+    // an assignment which fails fails operations on its key only
+    for( std::size_t index = 0 ; index < _changes.size() ; ++ index )
+    {
+        _Change const & change = _changes[ index ];
+
+        if( change._effect != _Assign ){
+            continue;
+        }
+
+        try
+        {
+            change._found->second = * change._value;
+        }
+        catch( ... )
+        {
+            failLocked( change, std::current_exception() );
+        }
+    }
+
+    try
+    {
+        // keys are sorted and unique, erased and inserted keys are disjoint
+        _av.erase_keys( _erasedKeys.begin(), _erasedKeys.end() );
+        _av.insert( _insertedItems.begin(), _insertedItems.end() );
+    }
+    catch( ... )
+    {
+        std::exception_ptr const exception = std::current_exception();
+
+        // erase_keys and insert do not tell how far they got, the map does
+        for( std::size_t index = 0 ; index < _changes.size() ; ++ index )
+        {
+            _Change const & change = _changes[ index ];
+
+            if( change._effect == _Remove && _av.count( * _batch[ change._first ]->_key ) == 1 ){
+                failLocked( change, exception );
+            }
+            else if( change._effect == _Add && _av.count( * _batch[ change._first ]->_key ) == 0 ){
+                failLocked( change, exception );
+            }
+        }
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+void
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::failLocked(
+      _Change const & change
+    , std::exception_ptr const & exception
+)
+{
+    for( std::size_t index = change._first ; index != change._last ; ++ index ){
+        _batch[ index ]->_exception = exception;
+    }
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+FlatCombiningAssocVector< _Key, _Mapped, _Cmp, _Allocator >::applyOneLocked(
+      _Operation operation
+    , key_type const & k
+    , mapped_type const * mapped
+    , mapped_type * found
+)
+{
+    switch( operation )
+    {
+        case _Insert:
+            return _av.try_emplace( k, * mapped ).second ? 1 : 0;
+
+        case _InsertOrAssign:
+            return _av.insert_or_assign( k, * mapped ).second ? 1 : 0;
+
+        case _Erase:
+            return _av.erase( k );
+
+        case _Find:
+        {
+            typename combined_type::iterator const current = _av.find( k );
+
+            if( current == _av.end() ){
+                return 0;
+            }
+
+            if( found != 0 ){
+                * found = current->second;
+            }
+
+            return 1;
+        }
+    }
+
+    AV_CHECK( false );
+
+    return 0;
+}
+
+
+namespace detail
+{
+    template< typename _Ingest >
+    struct IngestAssocVectorWriter;
+}
+
+//
+// IngestAssocVector, write heavy ingestion from many threads, each thread writes through its own writer
+// into a private AssocVector without locking, a full one is flushed into the shared AssocVector
+// under a short critical section with one insert_or_assign_many, which merges it in one pass
+//
+// readers of the shared map see a write after its buffer is flushed, a writer sees its own writes immediately,
+// the last flushed write of a key wins
+//
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp = std::less< _Key >
+    , typename _Allocator = std::allocator< std::pair< _Key, _Mapped > >
+>
+struct IngestAssocVector
+{
+public:
+    typedef AssocVector< _Key, _Mapped, _Cmp, _Allocator > shared_type;
+
+    typedef _Key key_type;
+    typedef _Mapped mapped_type;
+
+    typedef std::pair< _Key, _Mapped > value_type;
+
+    typedef _Cmp key_compare;
+
+    typedef detail::IngestAssocVectorWriter< IngestAssocVector > writer;
+
+private:
+    friend struct detail::IngestAssocVectorWriter< IngestAssocVector >;
+
+public:
+    explicit IngestAssocVector( _Cmp const & cmp = _Cmp() );
+
+    IngestAssocVector( IngestAssocVector const & ) = delete;
+    IngestAssocVector & operator=( IngestAssocVector const & ) = delete;
+
+    //
+    // readers, see flushed writes only
+    //
+    bool find( key_type const & k, mapped_type & m )const;
+
+    std::size_t count( key_type const & k )const;
+
+    std::size_t size()const;
+
+    key_compare key_comp()const;
+
+private:
+    //
+    // flush, merges sorted unique items of a writer into the shared map
+    //
+    template< typename __Iterator >
+    void flush( __Iterator first, __Iterator last );
+
+private:
+    _Cmp _cmp;
+
+    mutable std::mutex _mutex;
+
+    shared_type _shared;
+};
+
+namespace detail
+{
+    //
+    // IngestAssocVectorWriter, private AssocVector of one thread used as a large sorted buffer,
+    // to be used by one thread at a time, pending items are flushed on destruction,
+    // flush has to be called before to see its exceptions
+    //
+    template< typename _Ingest >
+    struct IngestAssocVectorWriter
+    {
+    public:
+        typedef typename _Ingest::key_type key_type;
+        typedef typename _Ingest::mapped_type mapped_type;
+        typedef typename _Ingest::value_type value_type;
+
+        //
+        // constructor, buffer is flushed when it holds capacity items
+        //
+        explicit IngestAssocVectorWriter( _Ingest & ingest, std::size_t capacity = AV_INGEST_BUFFER )
+            : _ingest( ingest )
+            , _capacity( capacity )
+            , _buffer( ingest._cmp )
+        {
+            AV_PRECONDITION( capacity > 0 );
+
+            _buffer.reserve( capacity );
+        }
+
+        IngestAssocVectorWriter( IngestAssocVectorWriter const & ) = delete;
+        IngestAssocVectorWriter & operator=( IngestAssocVectorWriter const & ) = delete;
+
+        ~IngestAssocVectorWriter()
+        {
+            try{
+                flush();
+            }
+            catch( ... ){
+                // destructor can not throw, pending items are dropped
+            }
+        }
+
+        //
+        // insert_or_assign, no lock unless the buffer gets full
+        //
+        void insert_or_assign( key_type const & k, mapped_type const & m )
+        {
+            _buffer.insert_or_assign( k, m );
+
+            if( _buffer.size() >= _capacity ){
+                flush();
+            }
+        }
+
+        //
+        // find, own pending writes first, then the shared map
+        //
+        bool find( key_type const & k, mapped_type & m )const
+        {
+            typename _Buffer::const_iterator const found = _buffer.find( k );
+
+            if( found != _buffer.end() )
+            {
+                m = found->second;
+
+                return true;
+            }
+
+            return _ingest.find( k, m );
+        }
+
+        std::size_t count( key_type const & k )const
+        {
+            return _buffer.count( k ) == 1 ? 1 : _ingest.count( k );
+        }
+
+        //
+        // flush, makes pending writes visible to all readers, they are kept if flush throws
+        //
+        void flush()
+        {
+            if( _buffer.empty() ){
+                return;
+            }
+
+            array::Span< value_type const > const items = _buffer.sorted_span();
+
+            _ingest.flush( items.begin(), items.end() );
+
+            _buffer.clear();
+        }
+
+        //
+        // pending, number of writes not flushed yet
+        //
+        std::size_t pending()const
+        {
+            return _buffer.size();
+        }
+
+    private:
+        typedef typename _Ingest::shared_type _Buffer;
+
+    private:
+        _Ingest & _ingest;
+
+        std::size_t _capacity;
+
+        _Buffer _buffer;
+    };
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::IngestAssocVector( _Cmp const & cmp )
+    : _cmp( cmp )
+    , _shared( cmp )
+{
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+bool
+IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::find(
+      key_type const & k
+    , mapped_type & m
+)const
+{
+    std::lock_guard< std::mutex > const lock( _mutex );
+
+    typename shared_type::const_iterator const found = _shared.find( k );
+
+    if( found == _shared.end() ){
+        return false;
+    }
+
+    m = found->second;
+
+    return true;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::count( key_type const & k )const
+{
+    std::lock_guard< std::mutex > const lock( _mutex );
+
+    return _shared.count( k );
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+std::size_t
+IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::size()const
+{
+    std::lock_guard< std::mutex > const lock( _mutex );
+
+    return _shared.size();
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+typename IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_compare
+IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::key_comp()const
+{
+    return _cmp;
+}
+
+template<
+      typename _Key
+    , typename _Mapped
+    , typename _Cmp
+    , typename _Allocator
+>
+template< typename __Iterator >
+void
+IngestAssocVector< _Key, _Mapped, _Cmp, _Allocator >::flush( __Iterator first, __Iterator last )
+{
+    std::lock_guard< std::mutex > const lock( _mutex );
+
+    _shared.insert_or_assign_many( first, last );
+}
+
+#endif
@@ -52,14 +52,18 @@
     #include <boost/random/uniform_int_distribution.hpp>
 #endif
 
+#include <chrono>
 #include <ctime>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define AV_ENABLE_EXTENSIONS
 #include "AssocVector.hpp"
+#include "ConcurrentAssocVector.hpp"
 
 #ifdef AV_DEBUG
     #error Are you trying to run perf tests with assertions enabled ?
@@ -160,6 +164,23 @@ struct S2
 template<>
 std::string name< S2 >(){ return "S2"; }
 
+namespace util
+{
+    // S1 and S2 do not keep pointers to themselves, they may be grown with realloc
+
+    template<>
+    struct is_trivially_relocatable< S1 >
+        : std::true_type
+    {
+    };
+
+    template<>
+    struct is_trivially_relocatable< S2 >
+        : std::true_type
+    {
+    };
+}
+
 struct S3
 {
     S3()
@@ -239,6 +260,12 @@ int S3::moves = 0;
 template<>
 std::string name< S3 >(){ return "S3"; }
 
+template<>
+std::string name< int >(){ return "int"; }
+
+template<>
+std::string name< double >(){ return "double"; }
+
 void printSummary(
       std::string const & message
     , unsigned tests
@@ -285,6 +312,29 @@ void test_insert_increasing( unsigned tests, unsigned rep, std::string const & m
     printSummary( message, tests, rep, timeout, total_time );
 }
 
+template< typename _Storage >
+void test_from_sorted_unique( unsigned tests, unsigned rep, std::string const & message )
+{
+    std::vector< std::pair< int, typename _Storage::mapped_type > > input;
+
+    for( unsigned counter = 0 ; counter < rep ; ++counter ){
+        input.push_back( std::make_pair( counter, typename _Storage::mapped_type() ) );
+    }
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; j < tests ; ++ j )
+    {
+        std::clock_t const start_test( std::clock() );
+
+        _Storage av = _Storage::from_sorted_unique( input.begin(), input.end() );
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, rep, false, total_time );
+}
+
 template< typename _Storage >
 void test__insert_increasing( unsigned tests, unsigned rep, std::string const & message )
 {
@@ -464,6 +514,31 @@ void test_insert_random( unsigned tests, std::vector< int > const & array, std::
     printSummary( message, tests, array.size(), timeout, total_time );
 }
 
+template< typename _Storage >
+void test_insert_range_random( unsigned tests, std::vector< int > const & array, std::string const & message )
+{
+    std::vector< std::pair< int, typename _Storage::mapped_type > > input;
+
+    for( unsigned counter = 0 ; counter < array.size() ; ++counter ){
+        input.push_back( std::make_pair( array[ counter ], typename _Storage::mapped_type() ) );
+    }
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; j < tests ; ++ j )
+    {
+        _Storage av;
+
+        std::clock_t const start_test( std::clock() );
+
+        av.insert( input.begin(), input.end() );
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, array.size(), false, total_time );
+}
+
 
 template< typename _Storage >
 void test__insert_random( unsigned tests, std::vector< int > const & array, std::string const & message )
@@ -585,27 +660,35 @@ void test_erase_random( unsigned tests, std::vector< int > const & array, std::s
     printSummary( message, tests, array.size(), timeout, total_time );
 }
 
+// removes about 30% of items
+inline bool shouldBePurged( int key )
+{
+    return key % 10 < 3;
+}
+
 template< typename _Storage >
-void test_find( unsigned tests, unsigned rep, std::string const & message )
+void test_purge_erase( unsigned tests, std::vector< int > const & array, std::string const & message )
 {
     std::clock_t const start_suite( std::clock() );
 
     bool timeout = false;
 
-    _Storage av;
-
-    for( unsigned i = 0 ; i < rep ; ++i ){
-        av.insert( std::make_pair( i, typename _Storage::mapped_type() ) );
-    }
-
     std::clock_t total_time = 0;
 
     for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
     {
+        _Storage av;
+
+        for( unsigned i = 0 ; i < array.size() ; ++i ){
+            av.insert( std::make_pair( array[ i ], typename _Storage::mapped_type() ) );
+        }
+
         std::clock_t const start_test( std::clock() );
 
-        for( unsigned counter = 0 ; ! timeout && counter < rep ; ++counter ){
-            av.find( counter );
+        for( unsigned counter = 0 ; ! timeout && counter < array.size() ; ++counter ){
+            if( shouldBePurged( array[ counter ] ) ){
+                av.erase( array[ counter ] );
+            }
 
             AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
         }
@@ -613,11 +696,34 @@ void test_find( unsigned tests, unsigned rep, std::string const & message )
         total_time += ( std::clock() - start_test );
     }
 
-    printSummary( message, tests, rep, timeout, total_time );
+    printSummary( message, tests, array.size(), timeout, total_time );
 }
 
 template< typename _Storage >
-void test__find( unsigned tests, unsigned rep, std::string const & message )
+void test_purge_erase_if( unsigned tests, std::vector< int > const & array, std::string const & message )
+{
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; j < tests ; ++ j )
+    {
+        _Storage av;
+
+        for( unsigned i = 0 ; i < array.size() ; ++i ){
+            av.insert( std::make_pair( array[ i ], typename _Storage::mapped_type() ) );
+        }
+
+        std::clock_t const start_test( std::clock() );
+
+        av.erase_if( []( typename _Storage::value_type const & value ){ return shouldBePurged( value.first ); } );
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, array.size(), false, total_time );
+}
+
+template< typename _Storage >
+void test_find( unsigned tests, unsigned rep, std::string const & message )
 {
     std::clock_t const start_suite( std::clock() );
 
@@ -636,7 +742,7 @@ void test__find( unsigned tests, unsigned rep, std::string const & message )
         std::clock_t const start_test( std::clock() );
 
         for( unsigned counter = 0 ; ! timeout && counter < rep ; ++counter ){
-            av._find( counter );
+            av.find( counter );
 
             AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
         }
@@ -648,338 +754,1601 @@ void test__find( unsigned tests, unsigned rep, std::string const & message )
 }
 
 template< typename _Storage >
-void test_index_operator_increasing( unsigned tests, unsigned rep, std::string const & message )
+void test_find_random( unsigned size, std::vector< int > const & array, std::string const & message )
 {
     std::clock_t const start_suite( std::clock() );
 
     bool timeout = false;
 
-    std::clock_t total_time = 0;
-
-    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
-    {
-        _Storage av;
-
-        std::clock_t const start_test( std::clock() );
+    _Storage av;
 
-        for( unsigned counter = 0 ; ! timeout && counter < rep ; ++counter ){
-            av[ counter ] = typename _Storage::mapped_type();
-            typename _Storage::mapped_type s = av[counter];
+    for( unsigned i = 0 ; i < size ; ++i ){
+        av.insert( std::make_pair( i, typename _Storage::mapped_type() ) );
+    }
 
-            (void)s;
+    std::clock_t const start_test( std::clock() );
 
-            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
-        }
+    for( unsigned counter = 0 ; ! timeout && counter < array.size() ; ++counter ){
+        av.find( array[ counter ] );
 
-        total_time += ( std::clock() - start_test );
+        AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
     }
 
-    printSummary( message, tests, rep, timeout, total_time );
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, size, array.size(), timeout, total_time );
 }
 
+enum FindBatch { FIND, FIND_MANY, FIND_MANY_INTERLEAVED };
+
 template< typename _Storage >
-void test_index_operator_decreasing( unsigned tests, unsigned rep, std::string const & message )
+void test_find_batch( _Storage const & av, std::vector< int > const & keys, FindBatch method, std::string const & message )
 {
-    std::clock_t const start_suite( std::clock() );
+    std::vector< typename _Storage::const_iterator > found( keys.size() );
 
-    bool timeout = false;
+    std::clock_t const start_test( std::clock() );
 
-    std::clock_t total_time = 0;
+    if( method == FIND_MANY ){
+        av.find_many( keys.begin(), keys.end(), found.begin() );
+    }
+    else if( method == FIND_MANY_INTERLEAVED ){
+        av.find_many_interleaved( keys.begin(), keys.end(), found.begin() );
+    }
+    else{
+        for( unsigned counter = 0 ; counter < keys.size() ; ++counter ){
+            found[ counter ] = av.find( keys[ counter ] );
+        }
+    }
 
-    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
-    {
-        _Storage av;
+    std::clock_t const total_time = std::clock() - start_test;
 
-        std::clock_t const start_test( std::clock() );
+    printSummary( message, av.size(), keys.size(), false, total_time );
+}
 
-        for( unsigned counter = rep ; ! timeout && counter > 0 ; --counter ){
-            av[ counter ] = typename _Storage::mapped_type();
-            typename _Storage::mapped_type s = av[counter];
+template< typename _Storage >
+void test_intersection( _Storage const & av1, _Storage const & av2, bool linear, std::string const & message )
+{
+    std::clock_t const start_test( std::clock() );
 
-            (void)s;
+    _Storage result;
 
-            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+    if( linear ){
+        result = set_intersection( av1, av2 );
+    }
+    else{
+        for( typename _Storage::const_iterator current = av1.begin() ; current != av1.end() ; ++ current ){
+            if( av2.find( current->first ) != av2.end() ){
+                result.insert( * current );
+            }
         }
-
-        total_time += ( std::clock() - start_test );
     }
 
-    printSummary( message, tests, rep, timeout, total_time );
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, av1.size(), result.size(), false, total_time );
 }
 
 template< typename _Storage >
-void test_index_operator_random( unsigned tests, std::vector< int > const & array, std::string const & message )
+void test_combine( std::vector< _Storage > parts, bool absorb, std::string const & message )
 {
-    std::clock_t const start_suite( std::clock() );
-
-    bool timeout = false;
+    std::clock_t const start_test( std::clock() );
 
-    std::clock_t total_time = 0;
+    _Storage result;
 
-    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    for( unsigned i = 0 ; i < parts.size() ; ++ i )
     {
-        _Storage av;
+        if( absorb ){
+            result.absorb( std::move( parts[ i ] ) );
+        }
+        else{
+            for( typename _Storage::const_iterator current = parts[ i ].begin() ; current != parts[ i ].end() ; ++ current ){
+                result.insert( * current );
+            }
+        }
+    }
 
-        std::clock_t const start_test( std::clock() );
+    std::clock_t const total_time = std::clock() - start_test;
 
-        for( unsigned counter = 0 ; ! timeout && counter < array.size() ; ++ counter ){
-            int const value = array[ counter ];
+    printSummary( message, parts.size(), result.size(), false, total_time );
+}
 
-            av[ value ] = typename _Storage::mapped_type();
-            typename _Storage::mapped_type s = av[ value ];
+template< typename _Storage >
+void test_export( _Storage av, bool release, std::string const & message )
+{
+    std::size_t const size = av.size();
 
-            (void)s;
+    std::clock_t const start_test( std::clock() );
 
-            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
-        }
+    std::size_t exported = 0;
 
-        total_time += ( std::clock() - start_test );
+    if( release ){
+        exported = av.release_sorted().size();
     }
+    else{
+        std::vector< typename _Storage::value_type > array( av.begin(), av.end() );
 
-    printSummary( message, tests, array.size(), timeout, total_time );
+        exported = array.size();
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, size, exported, false, total_time );
 }
 
 template< typename _Storage >
-void test_random_operations(
-      unsigned tests
-    , std::vector< std::pair< int, int > > const & array
-    , std::string const & message
-)
+void test_index_hit( _Storage & av, std::vector< int > const & keys, bool tryEmplace, std::string const & message )
 {
-    std::clock_t const start_suite( std::clock() );
-
-    bool timeout = false;
+    std::clock_t const start_test( std::clock() );
 
-    std::clock_t total_time = 0;
-
-    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    for( unsigned counter = 0 ; counter < keys.size() ; ++counter )
     {
-        _Storage av;
+        if( tryEmplace ){
+            av[ keys[ counter ] ];
+        }
+        else{
+            // operator[] as it was, mapped value is built and destroyed on every hit
+            av.insert( typename _Storage::value_type( keys[ counter ], typename _Storage::mapped_type() ) ).first->second;
+        }
+    }
 
-        std::clock_t const start_test( std::clock() );
+    std::clock_t const total_time = std::clock() - start_test;
 
-        for( unsigned counter = 0 ; ! timeout && counter < array.size() ; ++ counter ){
-            int const operation = array[ counter ].first;
-            int const value = array[ counter ].second;
+    printSummary( message, av.size(), keys.size(), false, total_time );
+}
 
-            switch( operation )
-            {
-                case 0:
-                    av.insert( std::make_pair( value, typename _Storage::mapped_type() ) );
-                    break;
+template< typename _Storage >
+void test_insert_nearly_sorted( std::vector< int > const & keys, bool hinted, std::string const & message )
+{
+    std::clock_t const start_test( std::clock() );
 
-                case 1:
-                    av.find( value );
-                    break;
+    _Storage av;
 
-                case 2:
-                    av.erase( value );
-                    break;
+    typename _Storage::iterator hint = av.end();
 
-                default:
-                    assert( false );
-            }
+    for( unsigned counter = 0 ; counter < keys.size() ; ++counter )
+    {
+        typename _Storage::value_type const value( keys[ counter ], typename _Storage::mapped_type() );
 
-            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+        if( hinted ){
+            hint = av.insert( hint, value );
+        }
+        else{
+            av.insert( value );
         }
-
-        total_time += ( std::clock() - start_test );
     }
 
-    printSummary( message, tests, array.size(), timeout, total_time );
-}
+    std::clock_t const total_time = std::clock() - start_test;
 
+    printSummary( message, keys.size(), av.size(), false, total_time );
+}
 
+//
+// LockedAssocVector, AssocVector behind one mutex, baseline for ShardedAssocVector
+//
 template< typename _T >
-void insert_increasing()
+struct LockedAssocVector
 {
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    typedef _T mapped_type;
+
+    bool insert( std::pair< int, _T > const & value )
     {
-        test_insert_increasing< AssocVector< int, _T > >( REPS / i, i, "insert_increasing.AssocVector< int, " + name< _T >() + " >" );
+        std::lock_guard< std::mutex > const lock( _mutex );
 
-#ifdef AV_TEST_EXTENSIONS
-        test__insert_increasing< AssocVector< int, _T > >( REPS / i, i, "    _insert_increasing.AssocVector< int, " + name< _T >() + " >" );
-#endif
+        return _av.insert( value ).second;
+    }
 
-#ifdef AV_TEST_LOKI
-        test_insert_increasing< Loki::AssocVector< int, _T > >( REPS / i, i, "insert_increasing.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+    bool insert_or_assign( int k, _T const & m )
+    {
+        std::lock_guard< std::mutex > const lock( _mutex );
 
-#ifdef AV_TEST_STD_MAP
-        test_insert_increasing< std::map< int, _T > >( REPS / i, i, "insert_increasing.std::map< int, " + name< _T >() + " >" );
-#endif
+        return _av.insert_or_assign( k, m ).second;
+    }
 
-#ifdef AV_TEST_BOOST_HASH
-        test_insert_increasing< boost::unordered_map< int, _T > >( REPS / i, i, "insert_increasing.boost::map< int, " + name< _T >() + " >" );
-#endif
+    std::size_t erase( int k )
+    {
+        std::lock_guard< std::mutex > const lock( _mutex );
 
-        std::cout << std::endl;
+        return _av.erase( k );
     }
-}
 
-template< typename _T >
-void insert_decreasing()
-{
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    std::size_t count( int k )const
     {
-        test_insert_decreasing< AssocVector< int, _T > >( REPS / i, i, "insert_decreasing.AssocVector< int, " + name< _T >() + " >" );
+        std::lock_guard< std::mutex > const lock( _mutex );
 
-#ifdef AV_TEST_EXTENSIONS
-        test__insert_decreasing< AssocVector< int, _T > >( REPS / i, i, "    _insert_decreasing.AssocVector< int, " + name< _T >() + " >" );
-#endif
+        return _av.count( k );
+    }
 
-#ifdef AV_TEST_VECTOR
-        test_insert_decreasing_push_back_reverse< std::vector< std::pair< int, _T > > >( REPS / i, i, "    insert_decreasing.std::vector< int, _T >.push_back.reverse" );
-#endif
+    std::size_t size()const
+    {
+        std::lock_guard< std::mutex > const lock( _mutex );
 
-#ifdef AV_TEST_LOKI
-        test_insert_decreasing< Loki::AssocVector< int, _T > >( REPS / i, i, "insert_decreasing.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+        return _av.size();
+    }
 
-#ifdef AV_TEST_STD_MAP
-        test_insert_decreasing< std::map< int, _T > >( REPS / i, i, "insert_decreasing.std::map< int, " + name< _T >() + " >" );
-#endif
+    void rebalance()
+    {
+    }
 
-#ifdef AV_TEST_BOOST_HASH
-        test_insert_decreasing< boost::unordered_map< int, _T > >( REPS / i, i, "insert_decreasing.boost::map< int, " + name< _T >() + " >" );
-#endif
+    void publish()
+    {
+    }
+
+    //
+    // reader, same interface as RcuAssocVector::reader
+    //
+    struct reader
+    {
+        reader( LockedAssocVector & av )
+            : _av( av )
+        {
+        }
+
+        std::size_t count( int k )
+        {
+            return _av.count( k );
+        }
+
+        LockedAssocVector & _av;
+    };
+
+    //
+    // writer, same interface as IngestAssocVector::writer
+    //
+    struct writer
+    {
+        writer( LockedAssocVector & av )
+            : _av( av )
+        {
+        }
+
+        void insert_or_assign( int k, _T const & m )
+        {
+            _av.insert_or_assign( k, m );
+        }
+
+        LockedAssocVector & _av;
+    };
+
+    mutable std::mutex _mutex;
+
+    AssocVector< int, _T > _av;
+};
+
+//
+// ConcurrentWorker, 1/8 inserts, 1/8 erases, 3/4 lookups
+//
+template< typename _Storage >
+struct ConcurrentWorker
+{
+    ConcurrentWorker( _Storage & storage, std::vector< int > const & keys, std::size_t & found )
+        : _storage( storage )
+        , _keys( keys )
+        , _found( found )
+    {
+    }
+
+    void operator()()
+    {
+        std::size_t found = 0;
+
+        for( unsigned counter = 0 ; counter < _keys.size() ; ++counter )
+        {
+            switch( counter % 8 )
+            {
+                case 0: _storage.insert( std::make_pair( _keys[ counter ], typename _Storage::mapped_type() ) ); break;
+                case 1: _storage.erase( _keys[ counter ] ); break;
+                default: found += _storage.count( _keys[ counter ] );
+            }
+        }
+
+        _found = found;
+    }
+
+    _Storage & _storage;
+    std::vector< int > const & _keys;
+    std::size_t & _found;
+};
+
+template< typename _Storage >
+void test_concurrent( std::vector< std::vector< int > > const & keys, std::string const & message )
+{
+    _Storage storage;
+
+    for( unsigned counter = 0 ; counter < REPS / 2 ; ++counter ){
+        storage.insert( std::make_pair( my_random( 0, 2 * REPS ), typename _Storage::mapped_type() ) );
+    }
+
+    storage.rebalance();
+
+    std::vector< std::size_t > found( keys.size() );
+    std::vector< std::thread > threads;
+
+    // wall time, std::clock sums time of all threads
+    std::chrono::steady_clock::time_point const start_test = std::chrono::steady_clock::now();
+
+    for( unsigned i = 0 ; i < keys.size() ; ++ i ){
+        threads.push_back( std::thread( ConcurrentWorker< _Storage >( storage, keys[ i ], found[ i ] ) ) );
+    }
+
+    for( unsigned i = 0 ; i < threads.size() ; ++ i ){
+        threads[ i ].join();
+    }
+
+    double const seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start_test ).count();
+
+    printSummary( message, keys.size(), keys[ 0 ].size(), false, static_cast< std::clock_t >( seconds * CLOCKS_PER_SEC ) );
+}
+
+//
+// FlatCombiningAssocVectorPerf, FlatCombiningAssocVector with interface of test_concurrent
+//
+template< typename _T >
+struct FlatCombiningAssocVectorPerf : FlatCombiningAssocVector< int, _T >
+{
+    void rebalance()
+    {
+    }
+};
+
+//
+// SeqlockAssocVectorPerf, SeqlockAssocVector with reader interface of RcuAssocVector
+//
+template< typename _T >
+struct SeqlockAssocVectorPerf : SeqlockAssocVector< int, _T >
+{
+    void publish()
+    {
+    }
+
+    struct reader
+    {
+        reader( SeqlockAssocVectorPerf & av )
+            : _av( av )
+        {
+        }
+
+        std::size_t count( int k )
+        {
+            return _av.count( k );
+        }
+
+        SeqlockAssocVectorPerf & _av;
+    };
+};
+
+//
+// ReadWorker, lookups through a reader until the writer is done
+//
+template< typename _Storage >
+struct ReadWorker
+{
+    ReadWorker( _Storage & storage, std::vector< int > const & keys, std::size_t & found )
+        : _storage( storage )
+        , _keys( keys )
+        , _found( found )
+    {
+    }
+
+    void operator()()
+    {
+        typename _Storage::reader reader( _storage );
+
+        std::size_t found = 0;
+
+        for( unsigned counter = 0 ; counter < _keys.size() ; ++counter ){
+            found += reader.count( _keys[ counter ] );
+        }
+
+        _found = found;
+    }
+
+    _Storage & _storage;
+    std::vector< int > const & _keys;
+    std::size_t & _found;
+};
+
+template< typename _Storage >
+void test_concurrent_read( std::vector< std::vector< int > > const & keys, std::string const & message )
+{
+    _Storage storage;
+
+    for( unsigned counter = 0 ; counter < REPS / 2 ; ++counter ){
+        storage.insert( std::make_pair( my_random( 0, 2 * REPS ), typename _Storage::mapped_type() ) );
+    }
+
+    storage.publish();
+
+    std::vector< std::size_t > found( keys.size() );
+    std::vector< std::thread > threads;
+
+    std::chrono::steady_clock::time_point const start_test = std::chrono::steady_clock::now();
+
+    for( unsigned i = 0 ; i < keys.size() ; ++ i ){
+        threads.push_back( std::thread( ReadWorker< _Storage >( storage, keys[ i ], found[ i ] ) ) );
+    }
+
+    // one write per 1000 reads
+    for( unsigned counter = 0 ; counter < keys.size() * keys[ 0 ].size() / 1000 ; ++counter ){
+        storage.insert( std::make_pair( keys[ 0 ][ counter ] + 1, typename _Storage::mapped_type() ) );
+    }
+
+    for( unsigned i = 0 ; i < threads.size() ; ++ i ){
+        threads[ i ].join();
+    }
+
+    double const seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start_test ).count();
+
+    printSummary( message, keys.size(), keys[ 0 ].size(), false, static_cast< std::clock_t >( seconds * CLOCKS_PER_SEC ) );
+}
+
+enum Write { WRITE_APPEND, WRITE_ASSIGN };
+
+template< typename _Storage >
+void test_write( unsigned items, Write method, std::string const & message )
+{
+    typedef typename _Storage::mapped_type _T;
+
+    _Storage storage;
+
+    if( method == WRITE_ASSIGN ){
+        for( unsigned counter = 0 ; counter < items ; ++counter ){
+            storage.insert( std::make_pair( counter, _T() ) );
+        }
+    }
+
+    std::clock_t const start_test( std::clock() );
+
+    // keys in increasing order, appends keep AssocVector flat without a merge
+    for( unsigned counter = 0 ; counter < items ; ++counter )
+    {
+        if( method == WRITE_APPEND ){
+            storage.insert( std::make_pair( counter, _T() ) );
+        }
+        else{
+            storage.insert_or_assign( counter, _T( counter ) );
+        }
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, storage.size(), items, false, total_time );
+}
+
+//
+// IngestWorker, writes through a writer of its own
+//
+template< typename _Storage >
+struct IngestWorker
+{
+    IngestWorker( _Storage & storage, std::vector< int > const & keys )
+        : _storage( storage )
+        , _keys( keys )
+    {
+    }
+
+    void operator()()
+    {
+        typename _Storage::writer writer( _storage );
+
+        for( unsigned counter = 0 ; counter < _keys.size() ; ++counter ){
+            writer.insert_or_assign( _keys[ counter ], typename _Storage::mapped_type() );
+        }
+    }
+
+    _Storage & _storage;
+    std::vector< int > const & _keys;
+};
+
+template< typename _Storage >
+void test_ingest( std::vector< std::vector< int > > const & keys, std::string const & message )
+{
+    _Storage storage;
+
+    std::vector< std::thread > threads;
+
+    // wall time, std::clock sums time of all threads
+    std::chrono::steady_clock::time_point const start_test = std::chrono::steady_clock::now();
+
+    for( unsigned i = 0 ; i < keys.size() ; ++ i ){
+        threads.push_back( std::thread( IngestWorker< _Storage >( storage, keys[ i ] ) ) );
+    }
+
+    for( unsigned i = 0 ; i < threads.size() ; ++ i ){
+        threads[ i ].join();
+    }
+
+    double const seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start_test ).count();
+
+    printSummary( message, keys.size(), storage.size(), false, static_cast< std::clock_t >( seconds * CLOCKS_PER_SEC ) );
+}
+
+template< typename _Storage >
+void test_parallel_build( std::vector< std::pair< int, typename _Storage::mapped_type > > const & input, unsigned threads, std::string const & message )
+{
+    std::chrono::steady_clock::time_point const start_test = std::chrono::steady_clock::now();
+
+    // threads == 0, sequential range constructor
+    _Storage const av
+        = threads == 0
+        ? _Storage( input.begin(), input.end() )
+        : parallel_build< _Storage >( input.begin(), input.end(), threads );
+
+    double const seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start_test ).count();
+
+    printSummary( message, input.size(), av.size(), false, static_cast< std::clock_t >( seconds * CLOCKS_PER_SEC ) );
+}
+
+//
+// ReduceMapped, reduce of parallel_reduce
+//
+template< typename _T >
+struct ReduceMapped
+{
+    _T operator()( _T result, std::pair< int, _T > const & value )const
+    {
+        return result + value.second;
+    }
+};
+
+template< typename _Storage >
+void test_parallel_reduce( _Storage const & av, unsigned threads, std::string const & message )
+{
+    typedef typename _Storage::mapped_type Mapped;
+
+    std::chrono::steady_clock::time_point const start_test = std::chrono::steady_clock::now();
+
+    std::vector< Mapped > sums( 10 );
+
+    for( unsigned counter = 0 ; counter < sums.size() ; ++counter )
+    {
+        if( threads == 0 )
+        {
+            // threads == 0, sequential loop over iterators
+            for( typename _Storage::const_iterator current = av.begin() ; current != av.end() ; ++ current ){
+                sums[ counter ] += current->second;
+            }
+        }
+        else
+        {
+            sums[ counter ] = parallel_reduce( av, Mapped(), ReduceMapped< Mapped >(), std::plus< Mapped >(), threads );
+        }
+    }
+
+    double const seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start_test ).count();
+
+    printSummary( message, av.size(), sums.size(), false, static_cast< std::clock_t >( seconds * CLOCKS_PER_SEC ) );
+}
+
+template< typename _Storage >
+void test_nth( _Storage const & av, std::vector< unsigned > const & positions, bool nth, std::string const & message )
+{
+    std::vector< typename _Storage::const_iterator > found( positions.size() );
+
+    std::clock_t const start_test( std::clock() );
+
+    for( unsigned counter = 0 ; counter < positions.size() ; ++counter )
+    {
+        if( nth ){
+            found[ counter ] = av.nth( positions[ counter ] );
+        }
+        else{
+            typename _Storage::const_iterator current = av.begin();
+
+            for( unsigned i = 0 ; i < positions[ counter ] ; ++ i ){
+                ++ current;
+            }
+
+            found[ counter ] = current;
+        }
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, av.size(), positions.size(), false, total_time );
+}
+
+template< typename _Storage >
+void test_aggregate( _Storage const & av, std::vector< int > const & lows, int width, bool aggregate, std::string const & message )
+{
+    typedef typename _Storage::mapped_type _T;
+
+    std::vector< _T > sums( lows.size() );
+
+    std::clock_t const start_test( std::clock() );
+
+    for( unsigned counter = 0 ; counter < lows.size() ; ++counter )
+    {
+        if( aggregate ){
+            sums[ counter ] = av.aggregate( lows[ counter ], lows[ counter ] + width, _T(), std::plus< _T >() );
+        }
+        else{
+            typename _Storage::const_iterator current = av.lower_bound( lows[ counter ] );
+            typename _Storage::const_iterator const last = av.lower_bound( lows[ counter ] + width );
+
+            for( /*empty*/ ; current != last ; ++ current ){
+                sums[ counter ] += current->second;
+            }
+        }
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, av.size(), lows.size(), false, total_time );
+}
+
+enum Scan { SCAN_VECTOR, SCAN_ITERATOR, SCAN_CURSOR, SCAN_FOR_EACH };
+
+//
+// ScanSum, for_each functor
+//
+template< typename _T >
+struct ScanSum
+{
+    template< typename _Value >
+    void operator()( _Value const & value )
+    {
+        _sum += value.second;
+    }
+
+    _T _sum;
+};
+
+template< typename _Storage >
+void test_scan( _Storage const & av, Scan method, std::string const & message )
+{
+    typedef typename _Storage::mapped_type _T;
+
+    std::vector< std::pair< int, _T > > const vector( av.begin(), av.end() );
+
+    std::vector< _T > sums( 10 );
+
+    std::clock_t const start_test( std::clock() );
+
+    for( unsigned counter = 0 ; counter < sums.size() ; ++counter )
+    {
+        if( method == SCAN_VECTOR ){
+            for( typename std::vector< std::pair< int, _T > >::const_iterator current = vector.begin() ; current != vector.end() ; ++ current ){
+                sums[ counter ] += current->second;
+            }
+        }
+        else if( method == SCAN_ITERATOR ){
+            for( typename _Storage::const_iterator current = av.begin() ; current != av.end() ; ++ current ){
+                sums[ counter ] += current->second;
+            }
+        }
+        else if( method == SCAN_CURSOR ){
+            for( typename _Storage::const_cursor current = av.cursor() ; current.done() == false ; current.next() ){
+                sums[ counter ] += current.get()->second;
+            }
+        }
+        else{
+            ScanSum< _T > const sum = { _T() };
+
+            sums[ counter ] = av.for_each( sum )._sum;
+        }
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, av.size(), sums.size(), false, total_time );
+}
+
+enum Range { RANGE_ITERATOR, RANGE_FOR_EACH, RANGE_SPAN };
+
+template< typename _Storage >
+void test_range( _Storage const & av, std::vector< int > const & lows, int width, Range method, std::string const & message )
+{
+    typedef typename _Storage::mapped_type _T;
+
+    std::vector< _T > sums( lows.size() );
+
+    std::clock_t const start_test( std::clock() );
+
+    for( unsigned counter = 0 ; counter < lows.size() ; ++counter )
+    {
+        if( method == RANGE_ITERATOR ){
+            typename _Storage::const_iterator current = av.lower_bound( lows[ counter ] );
+            typename _Storage::const_iterator const last = av.lower_bound( lows[ counter ] + width );
+
+            for( /*empty*/ ; current != last ; ++ current ){
+                sums[ counter ] += current->second;
+            }
+        }
+        else if( method == RANGE_FOR_EACH ){
+            ScanSum< _T > const sum = { _T() };
+
+            sums[ counter ] = av.range( lows[ counter ], lows[ counter ] + width ).for_each( sum )._sum;
+        }
+        else{
+            typename _Storage::const_range const range = av.range( lows[ counter ], lows[ counter ] + width );
+
+            AV_CHECK( range.is_contiguous() );
+
+            for( std::size_t i = 0 ; i < range.span().size() ; ++ i ){
+                sums[ counter ] += range.span()[ i ].second;
+            }
+        }
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, av.size(), lows.size(), false, total_time );
+}
+
+template< typename _Storage >
+void test_handle( _Storage av, std::vector< int > const & keys, bool useHandles, std::string const & message )
+{
+    typedef typename _Storage::mapped_type _T;
+
+    std::vector< typename _Storage::handle > handles;
+
+    for( unsigned i = 0 ; i < keys.size() ; ++ i ){
+        handles.push_back( av.make_handle( keys[ i ] ) );
+    }
+
+    unsigned const rounds = 1000;
+
+    std::clock_t const start_test( std::clock() );
+
+    for( unsigned counter = 0 ; counter < rounds ; ++counter )
+    {
+        // a write batch, new items go to buffer, a merge happens now and then
+        for( unsigned i = 0 ; i < 4 ; ++ i ){
+            av.insert( std::make_pair( my_random( 0, 4 * av.size() ), _T( i ) ) );
+        }
+
+        if( useHandles ){
+            for( unsigned i = 0 ; i < handles.size() ; ++ i ){
+                * av.resolve( handles[ i ] ) += _T( 1 );
+            }
+        }
+        else{
+            for( unsigned i = 0 ; i < keys.size() ; ++ i ){
+                av.find( keys[ i ] )->second += _T( 1 );
+            }
+        }
+    }
+
+    std::clock_t const total_time = std::clock() - start_test;
+
+    printSummary( message, av.size(), rounds * keys.size(), false, total_time );
+}
+
+template< typename _Storage >
+void test__find( unsigned tests, unsigned rep, std::string const & message )
+{
+    std::clock_t const start_suite( std::clock() );
+
+    bool timeout = false;
+
+    _Storage av;
+
+    for( unsigned i = 0 ; i < rep ; ++i ){
+        av.insert( std::make_pair( i, typename _Storage::mapped_type() ) );
+    }
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    {
+        std::clock_t const start_test( std::clock() );
+
+        for( unsigned counter = 0 ; ! timeout && counter < rep ; ++counter ){
+            av._find( counter );
+
+            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+        }
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, rep, timeout, total_time );
+}
+
+template< typename _Storage >
+void test_index_operator_increasing( unsigned tests, unsigned rep, std::string const & message )
+{
+    std::clock_t const start_suite( std::clock() );
+
+    bool timeout = false;
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    {
+        _Storage av;
+
+        std::clock_t const start_test( std::clock() );
+
+        for( unsigned counter = 0 ; ! timeout && counter < rep ; ++counter ){
+            av[ counter ] = typename _Storage::mapped_type();
+            typename _Storage::mapped_type s = av[counter];
+
+            (void)s;
+
+            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+        }
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, rep, timeout, total_time );
+}
+
+template< typename _Storage >
+void test_index_operator_decreasing( unsigned tests, unsigned rep, std::string const & message )
+{
+    std::clock_t const start_suite( std::clock() );
+
+    bool timeout = false;
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    {
+        _Storage av;
+
+        std::clock_t const start_test( std::clock() );
+
+        for( unsigned counter = rep ; ! timeout && counter > 0 ; --counter ){
+            av[ counter ] = typename _Storage::mapped_type();
+            typename _Storage::mapped_type s = av[counter];
+
+            (void)s;
+
+            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+        }
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, rep, timeout, total_time );
+}
+
+template< typename _Storage >
+void test_index_operator_random( unsigned tests, std::vector< int > const & array, std::string const & message )
+{
+    std::clock_t const start_suite( std::clock() );
+
+    bool timeout = false;
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    {
+        _Storage av;
+
+        std::clock_t const start_test( std::clock() );
+
+        for( unsigned counter = 0 ; ! timeout && counter < array.size() ; ++ counter ){
+            int const value = array[ counter ];
+
+            av[ value ] = typename _Storage::mapped_type();
+            typename _Storage::mapped_type s = av[ value ];
+
+            (void)s;
+
+            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+        }
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, array.size(), timeout, total_time );
+}
+
+template< typename _Storage >
+void test_random_operations(
+      unsigned tests
+    , std::vector< std::pair< int, int > > const & array
+    , std::string const & message
+)
+{
+    std::clock_t const start_suite( std::clock() );
+
+    bool timeout = false;
+
+    std::clock_t total_time = 0;
+
+    for( unsigned j = 0 ; ! timeout && j < tests ; ++ j )
+    {
+        _Storage av;
+
+        std::clock_t const start_test( std::clock() );
+
+        for( unsigned counter = 0 ; ! timeout && counter < array.size() ; ++ counter ){
+            int const operation = array[ counter ].first;
+            int const value = array[ counter ].second;
+
+            switch( operation )
+            {
+                case 0:
+                    av.insert( std::make_pair( value, typename _Storage::mapped_type() ) );
+                    break;
+
+                case 1:
+                    av.find( value );
+                    break;
+
+                case 2:
+                    av.erase( value );
+                    break;
+
+                default:
+                    assert( false );
+            }
+
+            AV_BREAK_IF_TIMEOUT( AV_TIMEOUT );
+        }
+
+        total_time += ( std::clock() - start_test );
+    }
+
+    printSummary( message, tests, array.size(), timeout, total_time );
+}
+
+
+template< typename _T >
+void insert_increasing()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        test_insert_increasing< AssocVector< int, _T > >( REPS / i, i, "insert_increasing.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_EXTENSIONS
+        test__insert_increasing< AssocVector< int, _T > >( REPS / i, i, "    _insert_increasing.AssocVector< int, " + name< _T >() + " >" );
+
+        test_insert_increasing< AssocVector< int, _T, std::less< int >, array::ReallocAllocator< std::pair< int, _T > > > >( REPS / i, i, "    insert_increasing.AssocVector< int, " + name< _T >() + ", realloc >" );
+#endif
+
+        test_from_sorted_unique< AssocVector< int, _T > >( REPS / i, i, "    from_sorted_unique.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_LOKI
+        test_insert_increasing< Loki::AssocVector< int, _T > >( REPS / i, i, "insert_increasing.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+        test_insert_increasing< std::map< int, _T > >( REPS / i, i, "insert_increasing.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+        test_insert_increasing< boost::unordered_map< int, _T > >( REPS / i, i, "insert_increasing.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void insert_decreasing()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        test_insert_decreasing< AssocVector< int, _T > >( REPS / i, i, "insert_decreasing.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_EXTENSIONS
+        test__insert_decreasing< AssocVector< int, _T > >( REPS / i, i, "    _insert_decreasing.AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_VECTOR
+        test_insert_decreasing_push_back_reverse< std::vector< std::pair< int, _T > > >( REPS / i, i, "    insert_decreasing.std::vector< int, _T >.push_back.reverse" );
+#endif
+
+#ifdef AV_TEST_LOKI
+        test_insert_decreasing< Loki::AssocVector< int, _T > >( REPS / i, i, "insert_decreasing.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+        test_insert_decreasing< std::map< int, _T > >( REPS / i, i, "insert_decreasing.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+        test_insert_decreasing< boost::unordered_map< int, _T > >( REPS / i, i, "insert_decreasing.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void insert_random()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        std::vector< int > array;
+
+        for( unsigned j = 0 ; j < i ; ++ j )
+            array.push_back( my_random() );
+
+        test_insert_random< AssocVector< int, _T > >( REPS / i, array, "insert_random.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_EXTENSIONS
+        test__insert_random< AssocVector< int, _T > >( REPS / i, array, "    _insert_random.AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+        test_insert_range_random< AssocVector< int, _T > >( REPS / i, array, "    insert_range_random.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_VECTOR
+        //test_insert_random_push_back_sort< std::vector< std::pair< int, _T > > >( REPS / i, array, "    insert_random.std::vector< int, _T >.push_back.sort" );
+#endif
+
+#ifdef AV_TEST_LOKI
+        test_insert_random< Loki::AssocVector< int, _T > >( REPS / i, array, "insert_random.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+        test_insert_random< std::map< int, _T > >( REPS / i, array, "insert_random.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+        test_insert_random< boost::unordered_map< int, _T > >( REPS / i, array, "insert_random.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void index_operator_increasing()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        test_index_operator_increasing< AssocVector< int, _T > >( REPS / i, i, "index_operator_increasing.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_LOKI
+        test_index_operator_increasing< Loki::AssocVector< int, _T > >( REPS / i, i, "index_operator_increasing.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+        test_index_operator_increasing< std::map< int, _T > >( REPS / i, i, "index_operator_increasing.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+        test_index_operator_increasing< boost::unordered_map< int, _T > >( REPS / i, i, "index_operator_increasing.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void index_operator_decreasing()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        test_index_operator_decreasing< AssocVector< int, _T > >( REPS / i, i, "index_operator_decreasing.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_LOKI
+        test_index_operator_decreasing< Loki::AssocVector< int, _T > >( REPS / i, i, "index_operator_decreasing.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+        test_index_operator_decreasing< std::map< int, _T > >( REPS / i, i, "index_operator_decreasing.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+        test_index_operator_decreasing< boost::unordered_map< int, _T > >( REPS / i, i, "index_operator_decreasing.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void index_operator_random()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        std::vector< int > array;
+
+        for( unsigned j = 0 ; j < i ; ++ j )
+            array.push_back( my_random() );
+
+        test_index_operator_random< AssocVector< int, _T > >( REPS / i, array, "index_operator_random.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_LOKI
+        test_index_operator_random< Loki::AssocVector< int, _T > >( REPS / i, array, "index_operator_random.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+        test_index_operator_random< std::map< int, _T > >( REPS / i, array, "index_operator_random.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+        test_index_operator_random< boost::unordered_map< int, _T > >( REPS / i, array, "index_operator_random.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void find()
+{
+    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    {
+        test_find< AssocVector< int, _T > >( REPS / i, i, "find.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_TEST_EXTENSIONS
+        test__find< AssocVector< int, _T > >( REPS / i, i, "    _find.AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_LOKI
+    test_find< Loki::AssocVector< int, _T > >( REPS / i, i, "find.Loki::AssocVector< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_STD_MAP
+    test_find< std::map< int, _T > >( REPS / i, i, "find.std::map< int, " + name< _T >() + " >" );
+#endif
+
+#ifdef AV_TEST_BOOST_HASH
+    test_find< boost::unordered_map< int, _T > >( REPS / i, i, "find.boost::map< int, " + name< _T >() + " >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void find_large()
+{
+    // maps bigger than TLB reach, random lookups miss TLB on almost every probe with 4KB pages
+    for( unsigned i = REPS ; i <= 16 * REPS ; i *= 4 )
+    {
+        std::vector< int > array;
+
+        for( unsigned j = 0 ; j < REPS ; ++ j )
+            array.push_back( my_random( 0, i - 1 ) );
+
+        test_find_random< AssocVector< int, _T > >( i, array, "find_large.AssocVector< int, " + name< _T >() + " >" );
+
+#ifdef AV_HAS_HUGE_PAGE_ALLOCATOR
+        test_find_random< AssocVector< int, _T, std::less< int >, array::HugePageAllocator< std::pair< int, _T > > > >( i, array, "    find_large.AssocVector< int, " + name< _T >() + ", huge pages >" );
+#endif
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void set_operations()
+{
+    typedef AssocVector< int, _T > AV;
+
+    for( unsigned i = REPS / 100 ; i <= REPS ; i *= 10 )
+    {
+        std::vector< std::pair< int, _T > > input1, input2;
+
+        for( unsigned j = 0 ; j < i ; ++ j )
+        {
+            input1.push_back( std::make_pair( 2 * j, _T() ) );
+            input2.push_back( std::make_pair( 3 * j, _T() ) );
+        }
+
+        AV const av1 = AV::from_sorted_unique( input1.begin(), input1.end() );
+        AV const av2 = AV::from_sorted_unique( input2.begin(), input2.end() );
+
+        test_intersection( av1, av2, false, "intersection.find.AssocVector< int, " + name< _T >() + " >" );
+        test_intersection( av1, av2, true, "    intersection.linear.AssocVector< int, " + name< _T >() + " >" );
 
         std::cout << std::endl;
     }
 }
 
 template< typename _T >
-void insert_random()
+void combine()
 {
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    typedef AssocVector< int, _T > AV;
+
+    // per thread partial results
+    for( unsigned i = 4 ; i <= 32 ; i *= 2 )
     {
-        std::vector< int > array;
+        std::vector< AV > parts( i );
 
-        for( unsigned j = 0 ; j < i ; ++ j )
-            array.push_back( my_random() );
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            for( unsigned k = 0 ; k < REPS / 32 ; ++ k ){
+                parts[ j ].insert( std::make_pair( my_random( 0, 2 * REPS ), _T() ) );
+            }
+        }
 
-        test_insert_random< AssocVector< int, _T > >( REPS / i, array, "insert_random.AssocVector< int, " + name< _T >() + " >" );
+        test_combine( parts, false, "combine.insert.AssocVector< int, " + name< _T >() + " >" );
+        test_combine( parts, true, "    combine.absorb.AssocVector< int, " + name< _T >() + " >" );
 
-#ifdef AV_TEST_EXTENSIONS
-        test__insert_random< AssocVector< int, _T > >( REPS / i, array, "    _insert_random.AssocVector< int, " + name< _T >() + " >" );
-#endif
+        std::cout << std::endl;
+    }
+}
 
-#ifdef AV_TEST_VECTOR
-        //test_insert_random_push_back_sort< std::vector< std::pair< int, _T > > >( REPS / i, array, "    insert_random.std::vector< int, _T >.push_back.sort" );
-#endif
+template< typename _T >
+void export_sorted()
+{
+    typedef AssocVector< int, _T > AV;
 
-#ifdef AV_TEST_LOKI
-        test_insert_random< Loki::AssocVector< int, _T > >( REPS / i, array, "insert_random.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+    for( unsigned i = REPS / 100 ; i <= REPS ; i *= 10 )
+    {
+        AV av;
 
-#ifdef AV_TEST_STD_MAP
-        test_insert_random< std::map< int, _T > >( REPS / i, array, "insert_random.std::map< int, " + name< _T >() + " >" );
-#endif
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            av.insert( std::make_pair( my_random( 0, 2 * REPS ), _T() ) );
+        }
 
-#ifdef AV_TEST_BOOST_HASH
-        test_insert_random< boost::unordered_map< int, _T > >( REPS / i, array, "insert_random.boost::map< int, " + name< _T >() + " >" );
-#endif
+        test_export( av, false, "export.copy.AssocVector< int, " + name< _T >() + " >" );
+        test_export( av, true, "    export.release_sorted.AssocVector< int, " + name< _T >() + " >" );
 
         std::cout << std::endl;
     }
 }
 
 template< typename _T >
-void index_operator_increasing()
+void index_hit()
 {
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    typedef AssocVector< int, _T > AV;
+
+    std::vector< std::pair< int, _T > > input;
+
+    for( unsigned i = 0 ; i < REPS ; ++ i ){
+        input.push_back( std::make_pair( i, _T() ) );
+    }
+
+    AV av = AV::from_sorted_unique( input.begin(), input.end() );
+
+    std::vector< int > keys;
+
+    for( unsigned i = 0 ; i < REPS ; ++ i ){
+        keys.push_back( my_random( 0, REPS - 1 ) );
+    }
+
+    test_index_hit( av, keys, false, "index_hit.insert.AssocVector< int, " + name< _T >() + " >" );
+    test_index_hit( av, keys, true, "    index_hit.try_emplace.AssocVector< int, " + name< _T >() + " >" );
+
+    std::cout << std::endl;
+}
+
+template< typename _T >
+void insert_nearly_sorted()
+{
+    typedef AssocVector< int, _T > AV;
+
+    // time ordered ids, every one of them is late by up to window positions
+    for( unsigned window = 4 ; window <= 64 ; window *= 4 )
     {
-        test_index_operator_increasing< AssocVector< int, _T > >( REPS / i, i, "index_operator_increasing.AssocVector< int, " + name< _T >() + " >" );
+        std::vector< int > keys;
 
-#ifdef AV_TEST_LOKI
-        test_index_operator_increasing< Loki::AssocVector< int, _T > >( REPS / i, i, "index_operator_increasing.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+        for( unsigned i = 0 ; i < REPS ; ++ i ){
+            keys.push_back( i - my_random( 0, window ) );
+        }
 
-#ifdef AV_TEST_STD_MAP
-        test_index_operator_increasing< std::map< int, _T > >( REPS / i, i, "index_operator_increasing.std::map< int, " + name< _T >() + " >" );
-#endif
+        test_insert_nearly_sorted< AV >( keys, false, "insert_nearly_sorted.AssocVector< int, " + name< _T >() + " >" );
+        test_insert_nearly_sorted< AV >( keys, true, "    insert_nearly_sorted.hint.AssocVector< int, " + name< _T >() + " >" );
 
-#ifdef AV_TEST_BOOST_HASH
-        test_index_operator_increasing< boost::unordered_map< int, _T > >( REPS / i, i, "index_operator_increasing.boost::map< int, " + name< _T >() + " >" );
-#endif
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void nth()
+{
+    typedef AssocVector< int, _T > AV;
+
+    for( unsigned i = REPS / 100 ; i <= REPS ; i *= 10 )
+    {
+        AV av;
+
+        // buffer and erased are not empty
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            av.insert( std::make_pair( my_random( 0, 2 * REPS ), _T() ) );
+        }
+
+        for( unsigned j = 0 ; j < i / 1000 ; ++ j ){
+            av.erase( my_random( 0, 2 * REPS ) );
+        }
+
+        // percentiles
+        std::vector< unsigned > positions;
+
+        for( unsigned j = 0 ; j < 100 ; ++ j ){
+            positions.push_back( j * ( av.size() - 1 ) / 100 );
+        }
+
+        test_nth( av, positions, false, "nth.increment.AssocVector< int, " + name< _T >() + " >" );
+        test_nth( av, positions, true, "    nth.nth.AssocVector< int, " + name< _T >() + " >" );
 
         std::cout << std::endl;
     }
 }
 
 template< typename _T >
-void index_operator_decreasing()
+void scan()
 {
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    typedef AssocVector< int, _T > AV;
+
+    for( unsigned i = REPS / 100 ; i <= 10 * REPS ; i *= 10 )
     {
-        test_index_operator_decreasing< AssocVector< int, _T > >( REPS / i, i, "index_operator_decreasing.AssocVector< int, " + name< _T >() + " >" );
+        AV av;
 
-#ifdef AV_TEST_LOKI
-        test_index_operator_decreasing< Loki::AssocVector< int, _T > >( REPS / i, i, "index_operator_decreasing.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+        // buffer and erased are not empty
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            av.insert( std::make_pair( my_random( 0, 2 * i ), _T( j % 7 ) ) );
+        }
 
-#ifdef AV_TEST_STD_MAP
-        test_index_operator_decreasing< std::map< int, _T > >( REPS / i, i, "index_operator_decreasing.std::map< int, " + name< _T >() + " >" );
-#endif
+        for( unsigned j = 0 ; j < i / 1000 ; ++ j ){
+            av.erase( my_random( 0, 2 * i ) );
+        }
 
-#ifdef AV_TEST_BOOST_HASH
-        test_index_operator_decreasing< boost::unordered_map< int, _T > >( REPS / i, i, "index_operator_decreasing.boost::map< int, " + name< _T >() + " >" );
-#endif
+        test_scan( av, SCAN_VECTOR, "scan.std::vector< std::pair< int, " + name< _T >() + " > >" );
+        test_scan( av, SCAN_ITERATOR, "    scan.iterator.AssocVector< int, " + name< _T >() + " >" );
+        test_scan( av, SCAN_CURSOR, "    scan.cursor.AssocVector< int, " + name< _T >() + " >" );
+        test_scan( av, SCAN_FOR_EACH, "    scan.for_each.AssocVector< int, " + name< _T >() + " >" );
 
         std::cout << std::endl;
     }
 }
 
 template< typename _T >
-void index_operator_random()
+void range()
 {
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    typedef AssocVector< int, _T > AV;
+
+    AV av;
+
+    // buffer and erased are not empty
+    for( unsigned j = 0 ; j < REPS ; ++ j ){
+        av.insert( std::make_pair( my_random( 0, 2 * REPS ), _T( j % 7 ) ) );
+    }
+
+    for( unsigned j = 0 ; j < REPS / 1000 ; ++ j ){
+        av.erase( my_random( 0, 2 * REPS ) );
+    }
+
+    AV flat( av );
+    flat.sorted_span();
+
+    for( int width = 4 ; width <= 4096 ; width *= 32 )
     {
-        std::vector< int > array;
+        std::vector< int > lows;
 
-        for( unsigned j = 0 ; j < i ; ++ j )
-            array.push_back( my_random() );
+        for( unsigned j = 0 ; j < 4 * REPS / width ; ++ j ){
+            lows.push_back( my_random( 0, 2 * REPS - width ) );
+        }
 
-        test_index_operator_random< AssocVector< int, _T > >( REPS / i, array, "index_operator_random.AssocVector< int, " + name< _T >() + " >" );
+        test_range( av, lows, width, RANGE_ITERATOR, "range.iterator.AssocVector< int, " + name< _T >() + " >" );
+        test_range( av, lows, width, RANGE_FOR_EACH, "    range.for_each.AssocVector< int, " + name< _T >() + " >" );
+        test_range( flat, lows, width, RANGE_ITERATOR, "    range.iterator.flat.AssocVector< int, " + name< _T >() + " >" );
+        test_range( flat, lows, width, RANGE_FOR_EACH, "    range.for_each.flat.AssocVector< int, " + name< _T >() + " >" );
+        test_range( flat, lows, width, RANGE_SPAN, "    range.span.flat.AssocVector< int, " + name< _T >() + " >" );
 
-#ifdef AV_TEST_LOKI
-        test_index_operator_random< Loki::AssocVector< int, _T > >( REPS / i, array, "index_operator_random.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+        std::cout << std::endl;
+    }
+}
 
-#ifdef AV_TEST_STD_MAP
-        test_index_operator_random< std::map< int, _T > >( REPS / i, array, "index_operator_random.std::map< int, " + name< _T >() + " >" );
-#endif
+template< typename _T >
+void handle()
+{
+    typedef AssocVector< int, _T > AV;
 
-#ifdef AV_TEST_BOOST_HASH
-        test_index_operator_random< boost::unordered_map< int, _T > >( REPS / i, array, "index_operator_random.boost::map< int, " + name< _T >() + " >" );
-#endif
+    for( unsigned i = REPS / 100 ; i <= 10 * REPS ; i *= 10 )
+    {
+        AV av;
+
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            av.insert( std::make_pair( my_random( 0, 2 * i ), _T( j % 7 ) ) );
+        }
+
+        // tracked items are spread over storage and buffer
+        std::vector< int > keys;
+
+        for( unsigned j = 0 ; j < av.size() ; j += av.size() / 1000 + 1 ){
+            keys.push_back( av.nth( j )->first );
+        }
+
+        test_handle( av, keys, false, "handle.find.AssocVector< int, " + name< _T >() + " >" );
+        test_handle( av, keys, true, "    handle.resolve.AssocVector< int, " + name< _T >() + " >" );
 
         std::cout << std::endl;
     }
 }
 
 template< typename _T >
-void find()
+void aggregate()
 {
-    for( unsigned i = 100 ; i <= REPS ; i *= 10 )
+    typedef AssocVector< int, _T > AV;
+
+    AV av;
+
+    // buffer and erased are not empty
+    for( unsigned j = 0 ; j < REPS ; ++ j ){
+        av.insert( std::make_pair( my_random( 0, 2 * REPS ), _T( j % 7 ) ) );
+    }
+
+    for( unsigned j = 0 ; j < REPS / 1000 ; ++ j ){
+        av.erase( my_random( 0, 2 * REPS ) );
+    }
+
+    for( int width = 100 ; width <= static_cast< int >( 2 * REPS ) ; width *= 100 )
     {
-        test_find< AssocVector< int, _T > >( REPS / i, i, "find.AssocVector< int, " + name< _T >() + " >" );
+        std::vector< int > lows;
 
-#ifdef AV_TEST_EXTENSIONS
-        test__find< AssocVector< int, _T > >( REPS / i, i, "    _find.AssocVector< int, " + name< _T >() + " >" );
-#endif
+        for( unsigned j = 0 ; j < 4 * REPS / width ; ++ j ){
+            lows.push_back( my_random( 0, 2 * REPS - width ) );
+        }
 
-#ifdef AV_TEST_LOKI
-    test_find< Loki::AssocVector< int, _T > >( REPS / i, i, "find.Loki::AssocVector< int, " + name< _T >() + " >" );
-#endif
+        test_aggregate( av, lows, width, false, "aggregate.loop.AssocVector< int, " + name< _T >() + " >" );
+        test_aggregate( av, lows, width, true, "    aggregate.AssocVector< int, " + name< _T >() + " >" );
 
-#ifdef AV_TEST_STD_MAP
-    test_find< std::map< int, _T > >( REPS / i, i, "find.std::map< int, " + name< _T >() + " >" );
-#endif
+        std::cout << std::endl;
+    }
+}
 
-#ifdef AV_TEST_BOOST_HASH
-    test_find< boost::unordered_map< int, _T > >( REPS / i, i, "find.boost::map< int, " + name< _T >() + " >" );
-#endif
+template< typename _T >
+void concurrent()
+{
+    // scaling needs as many cores as threads
+    for( unsigned threads = 1 ; threads <= 16 ; threads *= 2 )
+    {
+        std::vector< std::vector< int > > keys( threads );
+
+        for( unsigned i = 0 ; i < threads ; ++ i )
+        {
+            for( unsigned j = 0 ; j < REPS / threads ; ++ j ){
+                keys[ i ].push_back( my_random( 0, 2 * REPS ) );
+            }
+        }
+
+        test_concurrent< LockedAssocVector< _T > >( keys, "concurrent.mutex.AssocVector< int, " + name< _T >() + " >" );
+        test_concurrent< ShardedAssocVector< int, _T > >( keys, "    concurrent.ShardedAssocVector< int, " + name< _T >() + " >" );
+        test_concurrent< FlatCombiningAssocVectorPerf< _T > >( keys, "    concurrent.FlatCombiningAssocVector< int, " + name< _T >() + " >" );
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void concurrent_read()
+{
+    // scaling needs as many cores as threads
+    for( unsigned threads = 1 ; threads <= 8 ; threads *= 2 )
+    {
+        std::vector< std::vector< int > > keys( threads );
+
+        for( unsigned i = 0 ; i < threads ; ++ i )
+        {
+            for( unsigned j = 0 ; j < REPS / threads ; ++ j ){
+                keys[ i ].push_back( my_random( 0, 2 * REPS ) );
+            }
+        }
+
+        test_concurrent_read< LockedAssocVector< _T > >( keys, "concurrent_read.mutex.AssocVector< int, " + name< _T >() + " >" );
+        test_concurrent_read< RcuAssocVector< int, _T > >( keys, "    concurrent_read.RcuAssocVector< int, " + name< _T >() + " >" );
+        test_concurrent_read< SeqlockAssocVectorPerf< _T > >( keys, "    concurrent_read.SeqlockAssocVector< int, " + name< _T >() + " >" );
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void rcu_write()
+{
+    for( unsigned i = REPS / 100 ; i <= REPS / 10 ; i *= 10 )
+    {
+        test_write< LockedAssocVector< _T > >( i, WRITE_APPEND, "rcu_write.append.mutex.AssocVector< int, " + name< _T >() + " >" );
+        test_write< RcuAssocVector< int, _T > >( i, WRITE_APPEND, "    rcu_write.append.RcuAssocVector< int, " + name< _T >() + " >" );
+        test_write< LockedAssocVector< _T > >( i, WRITE_ASSIGN, "rcu_write.assign.mutex.AssocVector< int, " + name< _T >() + " >" );
+        test_write< RcuAssocVector< int, _T > >( i, WRITE_ASSIGN, "    rcu_write.assign.RcuAssocVector< int, " + name< _T >() + " >" );
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void ingest()
+{
+    // scaling needs as many cores as threads
+    for( unsigned threads = 1 ; threads <= 16 ; threads *= 2 )
+    {
+        std::vector< std::vector< int > > keys( threads );
+
+        for( unsigned i = 0 ; i < threads ; ++ i )
+        {
+            for( unsigned j = 0 ; j < REPS / threads ; ++ j ){
+                keys[ i ].push_back( my_random( 0, 2 * REPS ) );
+            }
+        }
+
+        test_ingest< LockedAssocVector< _T > >( keys, "ingest.mutex.AssocVector< int, " + name< _T >() + " >" );
+        test_ingest< IngestAssocVector< int, _T > >( keys, "    ingest.IngestAssocVector< int, " + name< _T >() + " >" );
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void build()
+{
+    typedef AssocVector< int, _T > AV;
+
+    for( unsigned i = REPS / 100 ; i <= 10 * REPS ; i *= 10 )
+    {
+        std::vector< std::pair< int, _T > > input;
+
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            input.push_back( std::make_pair( my_random( 0, 2 * i ), _T() ) );
+        }
+
+        test_parallel_build< AV >( input, 0, "build.AssocVector< int, " + name< _T >() + " >" );
+
+        // scaling needs as many cores as threads
+        for( unsigned threads = 1 ; threads <= 8 ; threads *= 2 )
+        {
+            std::ostringstream message;
+            message << "    parallel_build." << threads << ".AssocVector< int, " << name< _T >() << " >";
+
+            test_parallel_build< AV >( input, threads, message.str() );
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void reduce()
+{
+    typedef AssocVector< int, _T > AV;
+
+    for( unsigned i = REPS / 100 ; i <= 10 * REPS ; i *= 10 )
+    {
+        AV av;
+
+        for( unsigned j = 0 ; j < i ; ++ j ){
+            av.insert( std::make_pair( my_random( 0, 2 * i ), _T( j ) ) );
+        }
+
+        for( unsigned j = 0 ; j < i / 16 ; ++ j ){
+            av.erase( my_random( 0, 2 * i ) );
+        }
+
+        test_parallel_reduce( av, 0, "reduce.loop.AssocVector< int, " + name< _T >() + " >" );
+
+        // scaling needs as many cores as threads
+        for( unsigned threads = 1 ; threads <= 8 ; threads *= 2 )
+        {
+            std::ostringstream message;
+            message << "    parallel_reduce." << threads << ".AssocVector< int, " << name< _T >() << " >";
+
+            test_parallel_reduce( av, threads, message.str() );
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+template< typename _T >
+void find_many()
+{
+    typedef AssocVector< int, _T > AV;
+
+    std::vector< std::pair< int, _T > > input;
+
+    for( unsigned i = 0 ; i < REPS ; ++ i ){
+        input.push_back( std::make_pair( 2 * i, _T() ) );
+    }
+
+    AV const av = AV::from_sorted_unique( input.begin(), input.end() );
+
+    for( unsigned i = 1000 ; i <= REPS / 10 ; i *= 10 )
+    {
+        std::vector< int > keys;
+
+        for( unsigned j = 0 ; j < i ; ++ j )
+            keys.push_back( my_random( 0, 2 * REPS ) );
+
+        test_find_batch( av, keys, FIND, "find_batch.find.AssocVector< int, " + name< _T >() + " >" );
+        test_find_batch( av, keys, FIND_MANY, "    find_batch.find_many.AssocVector< int, " + name< _T >() + " >" );
+        test_find_batch( av, keys, FIND_MANY_INTERLEAVED, "    find_batch.interleaved.AssocVector< int, " + name< _T >() + " >" );
+
+        std::sort( keys.begin(), keys.end() );
+
+        test_find_batch( av, keys, FIND, "find_batch_sorted.find.AssocVector< int, " + name< _T >() + " >" );
+        test_find_batch( av, keys, FIND_MANY, "    find_batch_sorted.find_many.AssocVector< int, " + name< _T >() + " >" );
+        test_find_batch( av, keys, FIND_MANY_INTERLEAVED, "    find_batch_sorted.interleaved.AssocVector< int, " + name< _T >() + " >" );
 
         std::cout << std::endl;
     }
@@ -1043,6 +2412,9 @@ void erase_random()
 
         test_erase_random< AssocVector< int, _T > >( REPS / i, array, "erase_random.AssocVector< int, " + name< _T >() + " >" );
 
+        test_purge_erase< AssocVector< int, _T > >( REPS / i, array, "    purge_30%.erase.AssocVector< int, " + name< _T >() + " >" );
+        test_purge_erase_if< AssocVector< int, _T > >( REPS / i, array, "    purge_30%.erase_if.AssocVector< int, " + name< _T >() + " >" );
+
 #ifdef AV_TEST_LOKI
         test_erase_random< Loki::AssocVector< int, _T > >( REPS / i, array, "erase_random.Loki::AssocVector< int, " + name< _T >() + " >" );
 #endif
@@ -1172,6 +2544,46 @@ int main()
     find< S2 >();
     find< S3 >();
 
+    find_large< S1 >();
+    find_large< S2 >();
+
+    find_many< S1 >();
+    find_many< S2 >();
+
+    set_operations< S1 >();
+    set_operations< S2 >();
+
+    combine< S1 >();
+    combine< S2 >();
+
+    export_sorted< S1 >();
+    export_sorted< S2 >();
+
+    index_hit< S1 >();
+    index_hit< S2 >();
+    index_hit< S3 >();
+
+    insert_nearly_sorted< S1 >();
+    insert_nearly_sorted< S2 >();
+
+    nth< S1 >();
+    nth< S2 >();
+
+    aggregate< int >();
+    aggregate< double >();
+
+    scan< int >();
+    range< int >();
+    handle< int >();
+
+    concurrent< S1 >();
+    concurrent_read< int >();
+    rcu_write< int >();
+
+    build< int >();
+    reduce< double >();
+    ingest< int >();
+
     erase_increasing< S1 >();
     erase_increasing< S2 >();
     erase_increasing< S3 >();
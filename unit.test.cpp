@@ -13,13 +13,24 @@
 
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define AV_ENABLE_EXTENSIONS
 #include "AssocVector.hpp"
 
+#include <atomic>
+
+// routers of concurrent_sharded_resplit_test are stopped before they register, see shardedRouterHook
+void shardedRouterHook();
+
+#define AV_SHARD_ROUTER_HOOK() shardedRouterHook()
+
+#include "ConcurrentAssocVector.hpp"
+
 #ifdef AV_DEBUG
     #define _CORE_DUMP()\
         { int * core_dump = 0; * core_dump = 0; }
@@ -416,6 +427,74 @@ int MyAllocator< _T >::totalMemory = 0;
 template< typename _T >
 int MyAllocator< _T >::notFreedMemory = 0;
 
+//
+// CountingAllocator, stateful, counts bytes in use on the counter it was constructed with
+//
+template< typename _T >
+struct CountingAllocator
+{
+    typedef _T value_type;
+
+    typedef _T * pointer;
+    typedef _T const * const_pointer;
+
+    typedef _T & reference;
+    typedef _T const & const_reference;
+
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    CountingAllocator( std::size_t * used = 0 )
+        : _used( used )
+    {
+    }
+
+    template< typename __T >
+    CountingAllocator( CountingAllocator< __T > const & other )
+        : _used( other._used )
+    {
+    }
+
+    pointer allocate( size_type n )
+    {
+        if( _used ){
+            * _used += n * sizeof( value_type );
+        }
+
+        return std::allocator< value_type >().allocate( n );
+    }
+
+    void deallocate( pointer p, size_type n )
+    {
+        if( _used ){
+            * _used -= n * sizeof( value_type );
+        }
+
+        std::allocator< value_type >().deallocate( p, n );
+    }
+
+    template< typename __T >
+    void construct( pointer p, __T && v )
+    {
+        new ( p ) value_type( std::forward< __T >( v ) );
+    }
+
+    void destroy( pointer p )
+    {
+        p->~value_type();
+    }
+
+    size_type max_size()const throw()
+    {
+        return std::numeric_limits< size_type >::max() / sizeof( value_type );
+    }
+
+    template< typename __T >
+    struct rebind{ typedef CountingAllocator< __T > other; };
+
+    std::size_t * _used;
+};
+
 
 namespace std
 {
@@ -1247,6 +1326,184 @@ void test_move_overlap_copy_to_begining()
     AV_ASSERT( array == expected );
 }
 
+//
+// test_move_trivially_copyable
+//
+void test_move_trivially_copyable()
+{
+    AV_ASSERT( ( util::is_trivially_copyable< int >::value ) );
+    AV_ASSERT( ( util::is_trivially_copyable< std::pair< int, double > >::value ) );
+    AV_ASSERT( ( util::is_trivially_copyable< std::pair< int, std::string > >::value == false ) );
+
+    {
+        std::pair< int, int > array[] = { {1,1}, {2,2}, {3,3}, {4,4}, {5,5}, {6,6} };
+
+        util::move( array, array + 4, array + 2 );
+
+        std::pair< int, int > const expected[] = { {1,1}, {2,2}, {1,1}, {2,2}, {3,3}, {4,4} };
+
+        AV_ASSERT( std::equal( array, array + 6, expected ) );
+    }
+
+    {
+        std::pair< int, int > array[] = { {1,1}, {2,2}, {3,3}, {4,4}, {5,5}, {6,6} };
+
+        util::move( array + 2, array + 6, array );
+
+        std::pair< int, int > const expected[] = { {3,3}, {4,4}, {5,5}, {6,6}, {5,5}, {6,6} };
+
+        AV_ASSERT( std::equal( array, array + 6, expected ) );
+    }
+
+    {
+        std::pair< int, int > array[] = { {1,1}, {2,2}, {3,3} };
+        std::pair< int, int > array2[ 3 ];
+
+        AV_ASSERT( util::uninitialized_move( array, array + 3, array2 ) == array2 + 3 );
+        AV_ASSERT( std::equal( array, array + 3, array2 ) );
+    }
+}
+
+//
+// test_erase_removed
+//
+void test_erase_removed()
+{
+    using array::Array;
+
+    {
+        Array< int > storage( 8 );
+        Array< Array< int >::const_iterator > erased( 8 );
+
+        for( int i = 0 ; i < 8 ; ++ i ){
+            storage.place_back( i );
+        }
+
+        erased.place_back( storage.begin() + 0 );
+        erased.place_back( storage.begin() + 3 );
+        erased.place_back( storage.begin() + 4 );
+        erased.place_back( storage.begin() + 7 );
+
+        array::erase_removed( storage, erased );
+
+        int const expected[] = { 1, 2, 5, 6 };
+
+        checkEqual( storage.begin(), storage.end(), expected, expected + 4 );
+    }
+
+    {
+        Array< std::string > storage( 4 );
+        Array< Array< std::string >::const_iterator > erased( 4 );
+
+        storage.place_back( "a" );
+        storage.place_back( "b" );
+        storage.place_back( "c" );
+        storage.place_back( "d" );
+
+        erased.place_back( storage.begin() + 1 );
+
+        array::erase_removed( storage, erased );
+
+        std::string const expected[] = { "a", "c", "d" };
+
+        checkEqual( storage.begin(), storage.end(), expected, expected + 3 );
+
+        util::destroy_range( storage.end(), storage.end() + 1 );
+    }
+}
+
+//
+// test_gallop_lower_bound
+//
+void test_gallop_lower_bound()
+{
+    std::vector< int > array;
+
+    for( int i = 0 ; i < 100 ; ++ i ){
+        array.push_back( 2 * i );
+    }
+
+    for( int first = 0 ; first < 100 ; first += 7 )
+    {
+        for( int value = -1 ; value < 202 ; ++ value )
+        {
+            AV_ASSERT(
+                   util::gallop_lower_bound( array.begin() + first, array.end(), value, std::less< int >() )
+                == std::lower_bound( array.begin() + first, array.end(), value )
+            );
+        }
+    }
+
+    AV_ASSERT( util::gallop_lower_bound( array.end(), array.end(), 1, std::less< int >() ) == array.end() );
+
+    for( int last = 0 ; last <= 100 ; last += 7 )
+    {
+        for( int value = -1 ; value < 202 ; ++ value )
+        {
+            AV_ASSERT(
+                   util::gallop_lower_bound_backward( array.begin(), array.begin() + last, value, std::less< int >() )
+                == std::lower_bound( array.begin(), array.begin() + last, value )
+            );
+        }
+    }
+}
+
+//
+// test_radix_sort
+//
+void test_radix_sort()
+{
+    for( int test = 0 ; test < 16 ; ++ test )
+    {
+        std::vector< std::pair< unsigned, int > > items;
+
+        for( int i = 0 ; i < test * 64 ; ++ i ){
+            // test 1 has keys sharing all bytes but the lowest one
+            items.push_back( std::make_pair( test == 1 ? 0x12345600u + rand() % 256 : rand() * 2654435761u, i ) );
+        }
+
+        std::vector< std::pair< unsigned, int > > expected = items;
+        std::stable_sort( expected.begin(), expected.end(), util::CmpByFirst< std::pair< unsigned, int >, std::less< unsigned > >() );
+
+        util::radix_sort( items );
+
+        AV_ASSERT( items == expected );
+    }
+}
+
+//
+// test_interleaved_lower_bound
+//
+void test_interleaved_lower_bound()
+{
+    for( int size = 0 ; size < 40 ; ++ size )
+    {
+        std::vector< int > array;
+
+        for( int i = 0 ; i < size ; ++ i ){
+            array.push_back( 2 * i );
+        }
+
+        int values[ 2 * 40 + 2 ];
+        int const * pointers[ 2 * 40 + 2 ];
+        std::vector< int >::iterator results[ 2 * 40 + 2 ];
+
+        int const count = 2 * size + 2;
+
+        for( int i = 0 ; i < count ; ++ i )
+        {
+            values[ i ] = ( i * 7 ) % count - 1;
+            pointers[ i ] = & values[ i ];
+        }
+
+        util::interleaved_lower_bound( array.begin(), array.end(), pointers, count, results, std::less< int >() );
+
+        for( int i = 0 ; i < count ; ++ i ){
+            AV_ASSERT( results[ i ] == std::lower_bound( array.begin(), array.end(), values[ i ] ) );
+        }
+    }
+}
+
 //
 // test_last_less_equal
 //
@@ -1924,6 +2181,179 @@ void test_insert_init_list()
     AV_ASSERT_EQUAL( found->second, 5 );
 }
 
+//
+// test_insert_range
+//
+void test_insert_range()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        // storage, buffer and erased are not empty
+        for( int i = 0 ; i < 256 ; ++ i )
+        {
+            int const key = rand() % 512;
+
+            av.insert( AV::value_type( key, i ) );
+            map.insert( std::make_pair( key, i ) );
+
+            if( rand() % 4 == 0 )
+            {
+                av.erase( key / 2 );
+                map.erase( key / 2 );
+            }
+        }
+
+        std::vector< std::pair< int, int > > input;
+
+        // duplicates in input, first of them wins
+        for( int i = 0 ; i < rand() % 1024 ; ++ i ){
+            input.push_back( std::make_pair( rand() % 1024, 1000 + i ) );
+        }
+
+        if( test % 2 == 0 ){
+            std::sort( input.begin(), input.end() );
+        }
+
+        av.insert( input.begin(), input.end() );
+        map.insert( input.begin(), input.end() );
+
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+    }
+
+    {
+        std::vector< std::pair< int, int > > const input = { { 3, 3 }, { 1, 1 }, { 2, 2 }, { 1, 0 } };
+
+        AV av( input.begin(), input.end() );
+
+        AV::value_type const expected[] = { { 1, 1 }, { 2, 2 }, { 3, 3 } };
+
+        AV_ASSERT_EQUAL( av.size(), 3 );
+        AV_ASSERT( std::equal( av.begin(), av.end(), expected ) );
+    }
+}
+
+//
+// test_insert_or_assign_many
+//
+void test_insert_or_assign_many()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        // storage, buffer and erased are not empty
+        for( int i = 0 ; i < 256 ; ++ i )
+        {
+            int const key = rand() % 512;
+
+            av.insert( AV::value_type( key, i ) );
+            map.insert( std::make_pair( key, i ) );
+
+            if( rand() % 4 == 0 )
+            {
+                av.erase( key / 2 );
+                map.erase( key / 2 );
+            }
+        }
+
+        std::vector< std::pair< int, int > > input;
+
+        // duplicates in input, last of them wins, small inputs go through buffer
+        for( int i = 0 ; i < ( test % 4 == 0 ? rand() % 8 : rand() % 1024 ) ; ++ i ){
+            input.push_back( std::make_pair( rand() % 1024, 1000 + i ) );
+        }
+
+        if( test % 2 == 0 ){
+            std::sort( input.begin(), input.end() );
+        }
+
+        av.insert_or_assign_many( input.begin(), input.end() );
+
+        for( std::size_t i = 0 ; i < input.size() ; ++ i ){
+            map[ input[ i ].first ] = input[ i ].second;
+        }
+
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+    }
+}
+
+//
+// test_from_sorted_unique
+//
+void test_from_sorted_unique()
+{
+    typedef AssocVector< int, int > AV;
+
+    {
+        int const array[] = { 1, 2, 2 };
+
+        AV_ASSERT( util::is_strictly_sorted( array, array, std::less< int >() ) );
+        AV_ASSERT( util::is_strictly_sorted( array, array + 2, std::less< int >() ) );
+        AV_ASSERT( util::is_strictly_sorted( array, array + 3, std::less< int >() ) == false );
+    }
+
+    {
+        std::vector< std::pair< int, int > > input;
+
+        for( int i = 0 ; i < 1000 ; ++ i ){
+            input.push_back( std::make_pair( 2 * i, i ) );
+        }
+
+        AV av = AV::from_sorted_unique( input.begin(), input.end() );
+
+        AV_ASSERT_EQUAL( av.size(), input.size() );
+        AV_ASSERT_EQUAL( av.storageSize(), input.size() );
+        AV_ASSERT_EQUAL( av.bufferCapacity(), AV::calculateNewBufferCapacity( av.storageCapacity() ) );
+        AV_ASSERT( std::equal( av.storage().begin(), av.storage().end(), input.begin() ) );
+
+        av.insert( AV::value_type( 1, 1 ) );
+        av.erase( 0 );
+
+        AV_ASSERT_EQUAL( av.size(), input.size() );
+        AV_ASSERT( av.find( 1 ) != av.end() );
+        AV_ASSERT( av.find( 0 ) == av.end() );
+    }
+
+    {
+        AV::_Storage storage( 16 );
+
+        for( int i = 0 ; i < 10 ; ++ i ){
+            storage.place_back( std::make_pair( i, i ) );
+        }
+
+        AV::_Storage::const_iterator const data = storage.begin();
+
+        AV av = AV::from_sorted_unique( std::move( storage ) );
+
+        AV_ASSERT( av.storage().begin() == data );
+        AV_ASSERT_EQUAL( av.storageCapacity(), 16 );
+        AV_ASSERT_EQUAL( av.size(), 10 );
+        AV_ASSERT( storage.empty() );
+
+        for( int i = 10 ; i < 32 ; ++ i ){
+            av.insert( AV::value_type( i, i ) );
+        }
+
+        AV_ASSERT_EQUAL( av.size(), 32 );
+    }
+
+    {
+        AV av = AV::from_sorted_unique( AV::_Storage() );
+
+        AV_ASSERT( av.empty() );
+    }
+}
+
 //
 // test_erase_in_increasing_order
 //
@@ -1991,1251 +2421,3777 @@ void test_erase_in_random_order()
 }
 
 //
-// test_insert_insert
+// fill_random, storage, buffer and erased are not empty
 //
-void test_insert_insert()
+template< typename _AssocVector >
+void fill_random( _AssocVector & av, std::map< int, int > & map, int size )
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
-
-    TestCase< Key, Value > test( av, map );
+    for( int i = 0 ; i < 2 * size ; ++ i )
+    {
+        int const key = rand() % size;
 
-    test
-        >> insert( 1, 11 )
-        >> insert( 2, 22 )
-        >> insert( 3, 33 )
-        >> insert( 4, 44 )
+        av.insert( typename _AssocVector::value_type( key, i ) );
+        map.insert( std::make_pair( key, i ) );
 
-        >> insert( 1, 111 )
-        >> insert( 2, 222 )
-        >> insert( 3, 333 )
-        >> insert( 4, 444 );
+        if( rand() % 4 == 0 )
+        {
+            av.erase( key / 2 );
+            map.erase( key / 2 );
+        }
+    }
 }
 
 //
-// test_insert_erase_erase
+// test_erase_range
 //
-void test_insert_erase_erase()
+void test_erase_range()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
 
-    TestCase< Key, Value > test( av, map );
+    for( int test = 0 ; test < 256 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
 
-    test
-        >> insert( Range<>( 0, 50 ) )
+        fill_random( av, map, 1024 );
 
-        >> erase( Range<>( 40, 45 ) )
-        >> erase( Range<>( 35, 50 ) )
+        int const lower = rand() % 1024;
+        int const upper = lower + rand() % ( test % 2 ? 8 : 512 );
 
-        >> erase( Range<>( 5, 15 ) )
-        >> erase( Range<>( 0, 20 ) )
+        AV::iterator const result = av.erase( av.lower_bound( lower ), av.lower_bound( upper ) );
+        std::map< int, int >::iterator const expected = map.erase( map.lower_bound( lower ), map.lower_bound( upper ) );
 
-        >> erase( Range<>( 25, 30 ) )
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
 
-        >> erase( Range<>( 0, 50 ) );
+        AV_ASSERT_EQUAL( std::distance( av.begin(), result ), std::distance( map.begin(), expected ) );
+    }
+
+    {
+        AV av;
+        std::map< int, int > map;
+
+        fill_random( av, map, 1024 );
+
+        av.erase( av.lower_bound( 100 ), av.end() );
+        map.erase( map.lower_bound( 100 ), map.end() );
+
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+
+        AV_ASSERT( av.erase( av.begin(), av.end() ) == av.end() );
+        AV_ASSERT( av.empty() );
+    }
 }
 
 //
-// test_insert_erase_insert
+// test_erase_if
 //
-void test_insert_erase_insert()
+void test_erase_if()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
 
-    TestCase< Key, Value > test( av, map );
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
 
-    test
-        >> insert( Range<>( 0, 50, 2 ) )
-        >> insert( Range<>( 1, 51, 2 ) )
+        fill_random( av, map, 1024 );
 
-        >> erase( Range<>( 30, 40, 2 ) )
-        >> erase( Range<>( 31, 41, 2 ) )
+        int const modulo = 1 + rand() % 4;
 
-        >> insert( Range<>( 30, 40, 2 ) )
-        >> insert( Range<>( 31, 41, 2 ) )
+        std::size_t const erased = av.erase_if(
+            [ modulo ]( AV::value_type const & value ){ return value.second % modulo == 0; }
+        );
 
-        >> erase( Range<>( 10, 20, 2 ) )
-        >> erase( Range<>( 11, 21, 2 ) )
+        std::size_t const oldSize = map.size();
 
-        >> insert( Range<>( 10, 20, 2 ) )
-        >> insert( Range<>( 11, 21, 2 ) );
+        for( std::map< int, int >::iterator current = map.begin() ; current != map.end() ; /*empty*/ )
+        {
+            if( current->second % modulo == 0 ){
+                map.erase( current ++ );
+            }
+            else{
+                ++ current;
+            }
+        }
+
+        AV_ASSERT_EQUAL( erased, oldSize - map.size() );
+        AV_ASSERT_EQUAL( av.erasedSize(), 0 );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+    }
 }
 
 //
-// test_find
+// test_erase_keys
 //
-void test_find()
+void test_erase_keys()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
 
-    TestCase< Key, Value > test( av, map );
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
 
-    test
-        >> insert( Range<>( 0, 32, 2 ) )
-        >> find( Range<>( 0, 32, 2 ) )
-        >> find( Range<>( 1, 33, 2 ) );
+        fill_random( av, map, 1024 );
+
+        std::vector< int > keys;
+
+        for( int i = 0 ; i < ( test % 2 ? 4 : 512 ) ; ++ i ){
+            keys.push_back( rand() % 1024 );
+        }
+
+        std::sort( keys.begin(), keys.end() );
+
+        std::size_t expected = 0;
+
+        for( std::size_t i = 0 ; i < keys.size() ; ++ i ){
+            expected += map.erase( keys[ i ] );
+        }
+
+        AV_ASSERT_EQUAL( av.erase_keys( keys.begin(), keys.end() ), expected );
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+    }
 }
 
 //
-// test_find_erase_find
+// test_find_many
 //
-void test_find_erase_find()
+void test_find_many()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
 
-    TestCase< Key, Value > test( av, map );
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
 
-    test
-        >> insert( Range<>( 0, 32, 2 ) )
+        fill_random( av, map, 1024 );
 
-        >> erase( 31 )
-        >> find( 31 )
+        std::vector< int > keys;
 
-        >> erase( 1 )
-        >> find( 1 )
+        for( int i = 0 ; i < rand() % 512 ; ++ i ){
+            keys.push_back( rand() % 1100 - 50 );
+        }
 
-        >> erase( Range<>( 15, 25 ) )
-        >> find( Range<>( 15, 25 ) );
+        if( test % 2 == 0 ){
+            std::sort( keys.begin(), keys.end() );
+        }
+
+        std::vector< AV::iterator > found;
+        av.find_many( keys.begin(), keys.end(), std::back_inserter( found ) );
+
+        std::vector< std::size_t > counted;
+        av.count_many( keys.begin(), keys.end(), std::back_inserter( counted ) );
+
+        AV_ASSERT_EQUAL( found.size(), keys.size() );
+        AV_ASSERT_EQUAL( counted.size(), keys.size() );
+
+        for( std::size_t i = 0 ; i < keys.size() ; ++ i )
+        {
+            AV_ASSERT( found[ i ] == av.find( keys[ i ] ) );
+            AV_ASSERT_EQUAL( counted[ i ], map.count( keys[ i ] ) );
+
+            if( found[ i ] != av.end() )
+            {
+                AV_ASSERT_EQUAL( found[ i ]->second, map[ keys[ i ] ] );
+
+                // iterator is fully usable
+                AV_ASSERT_EQUAL( std::distance( av.begin(), found[ i ] ), std::distance( map.begin(), map.find( keys[ i ] ) ) );
+            }
+        }
+
+        AV const & cav = av;
+
+        std::vector< AV::const_iterator > constFound( keys.size() );
+        cav.find_many( keys.begin(), keys.end(), constFound.begin() );
+
+        for( std::size_t i = 0 ; i < keys.size() ; ++ i ){
+            AV_ASSERT( constFound[ i ] == AV::const_iterator( found[ i ] ) );
+        }
+
+        std::vector< AV::iterator > interleaved;
+        av.find_many_interleaved( keys.begin(), keys.end(), std::back_inserter( interleaved ) );
+
+        AV_ASSERT( interleaved == found );
+
+        std::vector< AV::const_iterator > constInterleaved( keys.size() );
+        cav.find_many_interleaved( keys.begin(), keys.end(), constInterleaved.begin() );
+
+        AV_ASSERT( constInterleaved == constFound );
+    }
 }
 
 //
-// test_find_erase_find_insert_find
+// test_set_operations
 //
-void test_find_erase_find_insert_find()
+void test_set_operations()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
+    typedef std::map< int, int > Map;
 
-    TestCase< Key, Value > test( av, map );
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av1, av2;
+        Map map1, map2;
 
-    test
-        >> insert( Range<>( 0, 30, 2 ) )
+        fill_random( av1, map1, 1 + rand() % 512 );
+        fill_random( av2, map2, 1 + rand() % 512 );
 
-        >> find( Range<>( 0, 10 ) )
-        >> erase( Range<>( 0, 10 ) )
-        >> insert( Range<>( 0, 10 ) )
-        >> find( Range<>( 0, 10 ) )
+        Map expected;
 
-        >> find( Range<>( 10, 20 ) )
-        >> erase( Range<>( 10, 20 ) )
-        >> insert( Range<>( 10, 20 ) )
-        >> find( Range<>( 10, 20 ) )
+        {
+            AV const result = set_union( av1, av2 );
 
-        >> find( Range<>( 20, 30 ) )
-        >> erase( Range<>( 20, 30 ) )
-        >> insert( Range<>( 20, 30 ) )
-        >> find( Range<>( 20, 30 ) );
+            expected = map2;
+            for( Map::const_iterator it = map1.begin() ; it != map1.end() ; ++ it ){
+                expected[ it->first ] = it->second;
+            }
+
+            AV_ASSERT( std::equal( result.begin(), result.end(), expected.begin() ) );
+            AV_ASSERT_EQUAL( result.size(), expected.size() );
+        }
+
+        {
+            AV const result = set_union( av1, av2, std::plus< int >() );
+
+            for( Map::iterator it = expected.begin() ; it != expected.end() ; ++ it ){
+                if( map1.count( it->first ) && map2.count( it->first ) ){
+                    it->second = map1[ it->first ] + map2[ it->first ];
+                }
+            }
+
+            AV_ASSERT( std::equal( result.begin(), result.end(), expected.begin() ) );
+            AV_ASSERT_EQUAL( result.size(), expected.size() );
+        }
+
+        {
+            AV const result = set_intersection( av1, av2 );
+
+            expected.clear();
+            for( Map::const_iterator it = map1.begin() ; it != map1.end() ; ++ it ){
+                if( map2.count( it->first ) ){
+                    expected.insert( * it );
+                }
+            }
+
+            AV_ASSERT( std::equal( result.begin(), result.end(), expected.begin() ) );
+            AV_ASSERT_EQUAL( result.size(), expected.size() );
+        }
+
+        {
+            AV const result = set_intersection( av1, av2, std::minus< int >() );
+
+            for( Map::iterator it = expected.begin() ; it != expected.end() ; ++ it ){
+                it->second = map1[ it->first ] - map2[ it->first ];
+            }
+
+            AV_ASSERT( std::equal( result.begin(), result.end(), expected.begin() ) );
+            AV_ASSERT_EQUAL( result.size(), expected.size() );
+        }
+
+        {
+            AV const result = set_difference( av1, av2 );
+
+            expected.clear();
+            for( Map::const_iterator it = map1.begin() ; it != map1.end() ; ++ it ){
+                if( map2.count( it->first ) == 0 ){
+                    expected.insert( * it );
+                }
+            }
+
+            AV_ASSERT( std::equal( result.begin(), result.end(), expected.begin() ) );
+            AV_ASSERT_EQUAL( result.size(), expected.size() );
+        }
+
+        {
+            AV const result = set_symmetric_difference( av1, av2 );
+
+            for( Map::const_iterator it = map2.begin() ; it != map2.end() ; ++ it ){
+                if( map1.count( it->first ) == 0 ){
+                    expected.insert( * it );
+                }
+            }
+
+            AV_ASSERT( std::equal( result.begin(), result.end(), expected.begin() ) );
+            AV_ASSERT_EQUAL( result.size(), expected.size() );
+        }
+    }
+
+    {
+        AV empty;
+
+        AV_ASSERT( set_union( empty, empty ).empty() );
+        AV_ASSERT( set_intersection( empty, empty ).empty() );
+    }
 }
 
 //
-// test_count
+// test_merge
 //
-void test_count()
+void test_merge()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
+    typedef std::map< int, int > Map;
 
-    TestCase< Key, Value > test( av, map );
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av1, av2;
+        Map map1, map2;
 
-    test
-        >> insert( Range<>( 0, 30, 2 ) )
+        fill_random( av1, map1, 1 + rand() % 512 );
+        fill_random( av2, map2, 1 + rand() % 512 );
 
-        >> count( Range<>( 0, 10 ) )
-        >> erase( Range<>( 0, 10 ) )
-        >> insert( Range<>( 0, 10 ) )
-        >> count( Range<>( 0, 10 ) )
+        // std::map::merge, C++17
+        for( Map::iterator it = map2.begin() ; it != map2.end() ; /*empty*/ )
+        {
+            if( map1.insert( * it ).second ){
+                map2.erase( it ++ );
+            }
+            else{
+                ++ it;
+            }
+        }
 
-        >> count( Range<>( 10, 20 ) )
-        >> erase( Range<>( 10, 20 ) )
-        >> insert( Range<>( 10, 20 ) )
-        >> count( Range<>( 10, 20 ) )
+        av1.merge( av2 );
 
-        >> count( Range<>( 20, 30 ) )
-        >> erase( Range<>( 20, 30 ) )
-        >> insert( Range<>( 20, 30 ) )
-        >> count( Range<>( 20, 30 ) );
+        AV_ASSERT_EQUAL( av1.size(), map1.size() );
+        AV_ASSERT( std::equal( av1.begin(), av1.end(), map1.begin() ) );
+
+        AV_ASSERT_EQUAL( av2.size(), map2.size() );
+        AV_ASSERT( std::equal( av2.begin(), av2.end(), map2.begin() ) );
+
+        // both are still fully usable
+        av2.insert( AV::value_type( 1024, 1 ) );
+        av2.erase( 1024 );
+        AV_ASSERT_EQUAL( av2.size(), map2.size() );
+
+        av1.merge( av1 );
+        AV_ASSERT_EQUAL( av1.size(), map1.size() );
+    }
+
+    {
+        AV av1 = { { 1, 1 }, { 2, 2 } };
+        AV av2 = { { 2, 22 }, { 3, 33 } };
+
+        av1.merge( std::move( av2 ) );
+
+        AV::value_type const expected[] = { { 1, 1 }, { 2, 2 }, { 3, 33 } };
+        AV_ASSERT_EQUAL( av1.size(), 3 );
+        AV_ASSERT( std::equal( av1.begin(), av1.end(), expected ) );
+    }
 }
 
 //
-// test_lower_bound
+// test_absorb
 //
-void test_lower_bound()
+void test_absorb()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef AssocVector< int, int > AV;
+    typedef std::map< int, int > Map;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av1, av2;
+        Map map1, map2;
+
+        if( test % 4 != 0 ){
+            fill_random( av1, map1, 1 + rand() % 512 );
+        }
+
+        fill_random( av2, map2, 1 + rand() % 512 );
+
+        map1.insert( map2.begin(), map2.end() );
+
+        av1.absorb( std::move( av2 ) );
+
+        AV_ASSERT_EQUAL( av1.size(), map1.size() );
+        AV_ASSERT( std::equal( av1.begin(), av1.end(), map1.begin() ) );
+
+        AV_ASSERT( av2.empty() );
+
+        av2.insert( AV::value_type( 1, 1 ) );
+        AV_ASSERT_EQUAL( av2.size(), 1 );
+    }
+}
+
+//
+// test_release_sorted
+//
+void test_release_sorted()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        fill_random( av, map, 1 + rand() % 512 );
+
+        array::Span< std::pair< int, int > const > const span = av.sorted_span();
+
+        AV_ASSERT_EQUAL( av.bufferSize(), 0 );
+        AV_ASSERT_EQUAL( av.erasedSize(), 0 );
+        AV_ASSERT_EQUAL( span.size(), map.size() );
+        AV_ASSERT( std::equal( span.begin(), span.end(), av.storage().begin() ) );
+
+        AV const & cav = av;
+        AV_ASSERT( cav.sorted_span().data() == span.data() );
+
+        AV::_Storage storage = av.release_sorted();
+
+        // no copy
+        AV_ASSERT( storage.data() == span.data() );
+        AV_ASSERT_EQUAL( storage.size(), map.size() );
+
+        AV_ASSERT( av.empty() );
+        AV_ASSERT( av.sorted_span().empty() );
+
+        av.insert( AV::value_type( 1, 1 ) );
+        AV_ASSERT_EQUAL( av.size(), 1 );
+
+        AV const restored = AV::from_sorted_unique( std::move( storage ) );
+
+        AV_ASSERT_EQUAL( restored.size(), map.size() );
+        AV_ASSERT( std::equal( restored.begin(), restored.end(), map.begin() ) );
+    }
+}
+
+//
+// test_insert_hint
+//
+void test_insert_hint()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av, other;
+        std::map< int, int > map;
+
+        other.insert( AV::value_type( 1, 1 ) );
+
+        AV::iterator hint = av.end();
+
+        for( int i = 0 ; i < 1024 ; ++ i )
+        {
+            // nearly sorted with some duplicates
+            int const key = i + rand() % 8 - 4;
+
+            switch( rand() % 8 )
+            {
+                case 0: hint = av.begin(); break;
+                case 1: hint = av.end(); break;
+                case 2: hint = av.find( key + 1 ); break;
+                default: break;
+            }
+
+            if( rand() % 8 == 0 ){
+                // hint from other container is ignored
+                hint = av.insert( AV::const_iterator( other.begin() ), AV::value_type( key, i ) );
+            }
+            else if( i % 3 == 0 ){
+                hint = av.insert( hint, AV::value_type( key, i ) );
+            }
+            else if( i % 3 == 1 ){
+                hint = av.emplace_hint( hint, key, i ).first;
+            }
+            else{
+                hint = av.try_emplace( hint, key, i );
+            }
+
+            map.insert( std::make_pair( key, i ) );
+
+            AV_ASSERT( hint != av.end() );
+            AV_ASSERT_EQUAL( hint->first, key );
+            AV_ASSERT_EQUAL( hint->second, map[ key ] );
+
+            if( rand() % 16 == 0 )
+            {
+                av.erase( key - 2 );
+                map.erase( key - 2 );
+
+                hint = av.end();
+            }
+        }
+
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+    }
+}
+
+//
+// test_rank_nth
+//
+void test_rank_nth()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        fill_random( av, map, 1 + rand() % 512 );
+
+        if( test % 2 == 0 ){
+            // flat container
+            av.sorted_span();
+        }
+
+        AV const & cav = av;
+
+        std::map< int, int >::const_iterator expected = map.begin();
+
+        for( std::size_t i = 0 ; i < map.size() ; ++ i, ++ expected )
+        {
+            AV_ASSERT( av.nth( i ) == av.find( expected->first ) );
+            AV_ASSERT( cav.nth( i ) == cav.find( expected->first ) );
+            AV_ASSERT_EQUAL( av.rank( expected->first ), i );
+        }
+
+        AV_ASSERT( av.nth( map.size() ) == av.end() );
+
+        for( int key = -2 ; key < 520 ; ++ key ){
+            AV_ASSERT_EQUAL( av.rank( key ), static_cast< std::size_t >( std::distance( map.begin(), map.lower_bound( key ) ) ) );
+        }
+
+        if( av.empty() ){
+            continue;
+        }
+
+        {// index, explicit O( log N ) position, iterators stay bidirectional
+            AV_ASSERT( ( std::is_same< std::iterator_traits< AV::iterator >::iterator_category, std::bidirectional_iterator_tag >::value ) );
+
+            AV_ASSERT_EQUAL( av.begin().index(), 0u );
+            AV_ASSERT_EQUAL( av.end().index(), map.size() );
+
+            for( int i = 0 ; i < 32 ; ++ i )
+            {
+                std::size_t const n = rand() % map.size();
+
+                AV::iterator const current = av.nth( n );
+
+                AV_ASSERT_EQUAL( current.index(), n );
+                AV_ASSERT_EQUAL( cav.nth( n ).index(), n );
+                AV_ASSERT( av.nth( current.index() ) == current );
+            }
+        }
+    }
+}
+
+//
+// test_aggregate
+//
+void test_aggregate()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        fill_random( av, map, 1 + rand() % 512 );
+
+        if( test % 2 == 0 ){
+            // flat container
+            av.sorted_span();
+        }
+
+        for( int i = 0 ; i < 64 ; ++ i )
+        {
+            int const lo = rand() % 520 - 4;
+            int const hi = lo + rand() % 260 - 4;
+
+            long long sum = 0;
+            int min = std::numeric_limits< int >::max();
+            int max = std::numeric_limits< int >::min();
+            std::size_t count = 0;
+
+            if( lo < hi )
+            {
+                std::map< int, int >::const_iterator current = map.lower_bound( lo );
+                std::map< int, int >::const_iterator const last = map.lower_bound( hi );
+
+                for( /*empty*/ ; current != last ; ++ current, ++ count )
+                {
+                    sum += current->second;
+                    min = std::min( min, current->second );
+                    max = std::max( max, current->second );
+                }
+            }
+
+            AV_ASSERT_EQUAL( av.aggregate( lo, hi, 0LL, std::plus< long long >() ), sum );
+            AV_ASSERT_EQUAL( av.aggregate( lo, hi, std::numeric_limits< int >::max(), util::Min< int >() ), min );
+            AV_ASSERT_EQUAL( av.aggregate( lo, hi, std::numeric_limits< int >::min(), util::Max< int >() ), max );
+            AV_ASSERT_EQUAL( av.count( lo, hi ), count );
+        }
+    }
+}
+
+//
+// test_split
+//
+void test_split()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        // empty, buffer only and larger containers
+        fill_random( av, map, test < 8 ? test : rand() % 512 );
+
+        if( test % 4 == 0 ){
+            // flat container
+            av.sorted_span();
+        }
+
+        for( std::size_t n = 1 ; n < 12 ; ++ n )
+        {
+            std::vector< AV::part_type > const parts = av.split( n );
+
+            AV_ASSERT_EQUAL( parts.size(), n );
+
+            std::vector< std::pair< int, int > > items;
+
+            for( std::size_t part = 0 ; part < parts.size() ; ++ part )
+            {
+                for( AV::part_type cursor = parts[ part ] ; cursor.done() == false ; cursor.next() ){
+                    items.push_back( * cursor.get() );
+                }
+            }
+
+            std::vector< std::pair< int, int > > const expected( map.begin(), map.end() );
+
+            AV_ASSERT( items == expected );
+        }
+    }
+}
+
+//
+// CollectItems, for_each functor
+//
+struct CollectItems
+{
+    void operator()( std::pair< int, int > const & value )
+    {
+        _items.push_back( value );
+    }
+
+    std::vector< std::pair< int, int > > _items;
+};
+
+//
+// test_for_each
+//
+void test_for_each()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        // empty, buffer only and larger containers
+        fill_random( av, map, test < 8 ? test : rand() % 512 );
+
+        if( test % 4 == 0 ){
+            // flat container
+            av.sorted_span();
+        }
+
+        {
+            std::vector< std::pair< int, int > > const expected( map.begin(), map.end() );
+
+            AV_ASSERT( av.for_each( CollectItems() )._items == expected );
+
+            std::vector< std::pair< int, int > > items;
+
+            for( AV::const_cursor cursor = av.cursor() ; cursor.done() == false ; cursor.next() ){
+                items.push_back( * cursor.get() );
+            }
+
+            AV_ASSERT( items == expected );
+        }
+
+        for( int i = 0 ; i < 16 ; ++ i )
+        {
+            int const lo = rand() % 520 - 4;
+            int const hi = lo + rand() % 260 - 4;
+
+            std::vector< std::pair< int, int > > expected;
+
+            if( lo < hi ){
+                expected.assign( map.lower_bound( lo ), map.lower_bound( hi ) );
+            }
+
+            AV_ASSERT( av.for_each_in_range( lo, hi, CollectItems() )._items == expected );
+
+            std::vector< std::pair< int, int > > items;
+
+            for( AV::const_cursor cursor = av.cursor( lo, hi ) ; cursor.done() == false ; cursor.next() ){
+                items.push_back( * cursor.get() );
+            }
+
+            AV_ASSERT( items == expected );
+        }
+    }
+}
+
+//
+// test_range
+//
+void test_range()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        fill_random( av, map, test < 8 ? test : rand() % 512 );
+
+        if( test % 4 == 0 ){
+            // flat container, every range is contiguous
+            av.sorted_span();
+        }
+
+        for( int i = 0 ; i < 16 ; ++ i )
+        {
+            int const lo = rand() % 520 - 4;
+            int const hi = lo + rand() % 260 - 4;
+
+            std::vector< std::pair< int, int > > expected;
+
+            if( lo < hi ){
+                expected.assign( map.lower_bound( lo ), map.lower_bound( hi ) );
+            }
+
+            AV::const_range const range = av.range( lo, hi );
+
+            AV_ASSERT_EQUAL( range.size(), expected.size() );
+            AV_ASSERT_EQUAL( range.empty(), expected.empty() );
+            AV_ASSERT( range.for_each( CollectItems() )._items == expected );
+
+            std::vector< std::pair< int, int > > items;
+
+            for( AV::const_range::cursor_type cursor = range.cursor() ; cursor.done() == false ; cursor.next() ){
+                items.push_back( * cursor.get() );
+            }
+
+            AV_ASSERT( items == expected );
+
+            // slices are the parts of storage, buffer and erased within [ lo, hi )
+            AV_ASSERT_EQUAL( range.storage().size() + range.buffer().size() - range.erased().size(), expected.size() );
+
+            for( std::size_t j = 0 ; j < range.erased().size() ; ++ j ){
+                AV_ASSERT( range.erased()[ j ] >= range.storage().begin() );
+                AV_ASSERT( range.erased()[ j ] < range.storage().end() );
+            }
+
+            if( test % 4 == 0 ){
+                AV_ASSERT( range.is_contiguous() );
+            }
+
+            if( range.is_contiguous() ){
+                AV_ASSERT( std::equal( range.span().begin(), range.span().end(), expected.begin() ) );
+            }
+        }
+    }
+}
+
+//
+// test_handle
+//
+void test_handle()
+{
+    typedef AssocVector< int, int > AV;
+
+    for( int test = 0 ; test < 64 ; ++ test )
+    {
+        AV av;
+        std::map< int, int > map;
+
+        fill_random( av, map, test < 8 ? test : rand() % 512 );
+
+        std::vector< AV::handle > handles;
+
+        // handles to missing keys too
+        for( int k = -4 ; k < 520 ; k += 1 + rand() % 4 ){
+            handles.push_back( av.make_handle( k ) );
+        }
+
+        for( int round = 0 ; round < 8 ; ++ round )
+        {
+            for( std::size_t i = 0 ; i < handles.size() ; ++ i )
+            {
+                std::map< int, int >::const_iterator const found = map.find( handles[ i ].key() );
+
+                int const * const resolved = av.resolve( handles[ i ] );
+
+                if( found == map.end() ){
+                    AV_ASSERT( resolved == 0 );
+                }
+                else
+                {
+                    AV_ASSERT( resolved != 0 );
+                    AV_ASSERT_EQUAL( * resolved, found->second );
+                }
+            }
+
+            // a write batch, items are inserted, assigned and erased from storage and buffer
+            for( int i = 0 ; i < rand() % 64 ; ++ i )
+            {
+                int const key = rand() % 512;
+
+                if( rand() % 3 == 0 )
+                {
+                    av.erase( key );
+                    map.erase( key );
+                }
+                else
+                {
+                    av.insert_or_assign( key, i );
+                    map[ key ] = i;
+                }
+            }
+        }
+    }
+
+    {
+        AV av;
+
+        for( int i = 0 ; i < 100 ; ++ i ){
+            av.insert( AV::value_type( i, i ) );
+        }
+
+        av._merge();
+
+        AV::handle h = av.make_handle( av.find( 50 ) );
+
+        std::size_t const generation = av.generation();
+
+        // insert to buffer and assignment move no storage item
+        av.insert( AV::value_type( 200, 200 ) );
+        av[ 50 ] = 51;
+
+        AV_ASSERT_EQUAL( av.generation(), generation );
+        AV_ASSERT_EQUAL( * av.resolve( h ), 51 );
+
+        // erased item is not resolved although it is still in storage
+        av.erase( 50 );
+
+        AV_ASSERT( av.generation() != generation );
+        AV_ASSERT( av.resolve( h ) == 0 );
+
+        // reinserted item is found again
+        av[ 50 ] = 52;
+
+        AV_ASSERT_EQUAL( * av.resolve( h ), 52 );
+
+        AV b;
+        b[ 50 ] = 53;
+
+        av.swap( b );
+
+        AV_ASSERT_EQUAL( * av.resolve( h ), 53 );
+        AV_ASSERT_EQUAL( * b.resolve( h ), 52 );
+
+        AV const & c = b;
+        AV_ASSERT_EQUAL( * c.resolve( h ), 52 );
+
+        b.clear();
+
+        AV_ASSERT( b.resolve( h ) == 0 );
+    }
+
+    {
+        typedef AssocVector<
+              int
+            , int
+            , std::less< int >
+            , array::ReallocAllocator< std::pair< int, int > >
+        > AVRealloc;
+
+        AVRealloc av;
+        av.insert( AVRealloc::value_type( 0, 0 ) );
+
+        AVRealloc::handle h = av.make_handle( av.find( 0 ) );
+
+        std::size_t const generation = av.generation();
+        std::size_t const capacity = av.capacity();
+
+        // appends grow storage in place through pushBack, no item changes its index
+        for( int i = 1 ; i < 1000 ; ++ i ){
+            av.insert( AVRealloc::value_type( i, i ) );
+        }
+
+        AV_ASSERT( av.capacity() > capacity );
+        AV_ASSERT_EQUAL( av.generation(), generation );
+
+        av[ 0 ] = 1;
+
+        AV_ASSERT( av.resolve( h ) == & av.find( 0 )->second );
+        AV_ASSERT_EQUAL( * av.resolve( h ), 1 );
+        AV_ASSERT_EQUAL( av.generation(), generation );
+    }
+}
+
+//
+// test_insert_insert
+//
+void test_insert_insert()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( 1, 11 )
+        >> insert( 2, 22 )
+        >> insert( 3, 33 )
+        >> insert( 4, 44 )
+
+        >> insert( 1, 111 )
+        >> insert( 2, 222 )
+        >> insert( 3, 333 )
+        >> insert( 4, 444 );
+}
+
+//
+// test_insert_erase_erase
+//
+void test_insert_erase_erase()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 0, 50 ) )
+
+        >> erase( Range<>( 40, 45 ) )
+        >> erase( Range<>( 35, 50 ) )
+
+        >> erase( Range<>( 5, 15 ) )
+        >> erase( Range<>( 0, 20 ) )
+
+        >> erase( Range<>( 25, 30 ) )
+
+        >> erase( Range<>( 0, 50 ) );
+}
+
+//
+// test_insert_erase_insert
+//
+void test_insert_erase_insert()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 0, 50, 2 ) )
+        >> insert( Range<>( 1, 51, 2 ) )
+
+        >> erase( Range<>( 30, 40, 2 ) )
+        >> erase( Range<>( 31, 41, 2 ) )
+
+        >> insert( Range<>( 30, 40, 2 ) )
+        >> insert( Range<>( 31, 41, 2 ) )
+
+        >> erase( Range<>( 10, 20, 2 ) )
+        >> erase( Range<>( 11, 21, 2 ) )
+
+        >> insert( Range<>( 10, 20, 2 ) )
+        >> insert( Range<>( 11, 21, 2 ) );
+}
+
+//
+// test_find
+//
+void test_find()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 0, 32, 2 ) )
+        >> find( Range<>( 0, 32, 2 ) )
+        >> find( Range<>( 1, 33, 2 ) );
+}
+
+//
+// test_find_erase_find
+//
+void test_find_erase_find()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 0, 32, 2 ) )
+
+        >> erase( 31 )
+        >> find( 31 )
+
+        >> erase( 1 )
+        >> find( 1 )
+
+        >> erase( Range<>( 15, 25 ) )
+        >> find( Range<>( 15, 25 ) );
+}
+
+//
+// test_find_erase_find_insert_find
+//
+void test_find_erase_find_insert_find()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 0, 30, 2 ) )
+
+        >> find( Range<>( 0, 10 ) )
+        >> erase( Range<>( 0, 10 ) )
+        >> insert( Range<>( 0, 10 ) )
+        >> find( Range<>( 0, 10 ) )
+
+        >> find( Range<>( 10, 20 ) )
+        >> erase( Range<>( 10, 20 ) )
+        >> insert( Range<>( 10, 20 ) )
+        >> find( Range<>( 10, 20 ) )
+
+        >> find( Range<>( 20, 30 ) )
+        >> erase( Range<>( 20, 30 ) )
+        >> insert( Range<>( 20, 30 ) )
+        >> find( Range<>( 20, 30 ) );
+}
+
+//
+// test_count
+//
+void test_count()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 0, 30, 2 ) )
+
+        >> count( Range<>( 0, 10 ) )
+        >> erase( Range<>( 0, 10 ) )
+        >> insert( Range<>( 0, 10 ) )
+        >> count( Range<>( 0, 10 ) )
+
+        >> count( Range<>( 10, 20 ) )
+        >> erase( Range<>( 10, 20 ) )
+        >> insert( Range<>( 10, 20 ) )
+        >> count( Range<>( 10, 20 ) )
+
+        >> count( Range<>( 20, 30 ) )
+        >> erase( Range<>( 20, 30 ) )
+        >> insert( Range<>( 20, 30 ) )
+        >> count( Range<>( 20, 30 ) );
+}
+
+//
+// test_lower_bound
+//
+void test_lower_bound()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 30, 10, -1 ) )
+        >> erase( 11 )
+        >> erase( 20 )
+        >> erase( 28 )
+
+        >> lower_bound( Range<>( 0, 40, 2 ) )
+        >> lower_bound( Range<>( 1, 41, 2 ) );
+}
+
+//
+// test_upper_bound
+//
+void test_upper_bound()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 30, 10, -1 ) )
+        >> erase( 11 )
+        >> erase( 20 )
+        >> erase( 28 )
+
+        >> upper_bound( Range<>( 0, 40, 2 ) )
+        >> upper_bound( Range<>( 1, 41, 2 ) );
+}
+
+//
+// test_equal_range
+//
+void test_equal_range()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> insert( Range<>( 30, 10, -1 ) )
+        >> erase( 11 )
+        >> erase( 20 )
+        >> erase( 28 )
+
+        >> equal_range( Range<>( 0, 40, 2 ) )
+        >> equal_range( Range<>( 1, 41, 2 ) );
+}
+
+//
+// test_swap
+//
+void test_swap()
+{
+    // todo
+}
+
+//
+// test_operator_index
+//
+void test_operator_index()
+{
+    AssocVector< Key, Value > av;
+    std::map< Key, Value > map;
+
+    TestCase< Key, Value > test( av, map );
+
+    test
+        >> index_put( 1, 1 )
+        >> index_put( 1, 11 )
+        >> index_put( 1, 111 )
+
+        >> index_get( 2 )
+
+        >> insert( 3, 33 )
+        >> index_get( 3 )
+
+        >> erase( 3 )
+        >> index_get( 3 );
+}
+
+//
+// test_user_type
+//
+void test_user_type()
+{
+    typedef AssocVector< Key, Value > AssocVector;
+
+    AssocVector av;
+    av.insert( AssocVector::value_type( Key(), Value() ) );
+    Value & m = av[ Key() ];
+    av[ Key() ] = m;
+    av.find( Key() );
+}
+
+//
+// Relocatable, counts every move and copy, relocated bitwise by user's request
+//
+struct Relocatable
+{
+    Relocatable( int i = 0 )
+        : value( i )
+    {
+    }
+
+    Relocatable( Relocatable const & other )
+        : value( other.value )
+    {
+        ++ moves;
+    }
+
+    Relocatable( Relocatable && other )
+        : value( other.value )
+    {
+        ++ moves;
+    }
+
+    Relocatable & operator=( Relocatable const & other )
+    {
+        ++ moves;
+
+        value = other.value;
+
+        return * this;
+    }
+
+    int value;
+
+    static int moves;
+};
+
+int Relocatable::moves = 0;
+
+namespace util
+{
+    template<>
+    struct is_trivially_relocatable< Relocatable >
+        : std::true_type
+    {
+    };
+}
+
+//
+// test_realloc_growth
+//
+void test_realloc_growth()
+{
+    AV_ASSERT( ( array::Array< int, array::ReallocAllocator< int > >::can_reallocate ) );
+    AV_ASSERT( ( array::Array< int >::can_reallocate == false ) );
+    AV_ASSERT( ( array::Array< std::string, array::ReallocAllocator< std::string > >::can_reallocate == false ) );
+
+    {
+        typedef AssocVector<
+              int
+            , int
+            , std::less< int >
+            , array::ReallocAllocator< std::pair< int, int > >
+        > AV;
+
+        AV_ASSERT( AV::_Storage::can_reallocate );
+
+        AV av;
+        std::map< int, int > map;
+
+        for( int i = 0 ; i < 4 * 1024 ; ++ i )
+        {
+            int const key = rand() % 1024;
+
+            if( rand() % 3 == 0 )
+            {
+                av.erase( key );
+                map.erase( key );
+            }
+            else
+            {
+                av.insert( AV::value_type( key, i ) );
+                map.insert( std::make_pair( key, i ) );
+            }
+        }
+
+        av.reserve( 4 * av.capacity() );
+
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+    }
+
+    {
+        typedef AssocVector<
+              int
+            , Relocatable
+            , std::less< int >
+            , array::ReallocAllocator< std::pair< int, Relocatable > >
+        > AV;
+
+        AV_ASSERT( AV::_Storage::can_reallocate );
+
+        AV av;
+
+        for( int i = 0 ; i < 1024 ; ++ i ){
+            av.insert( AV::value_type( i, Relocatable( i ) ) );
+        }
+
+        Relocatable::moves = 0;
+
+        av.reserve( 4 * av.capacity() );
+
+        AV_ASSERT_EQUAL( Relocatable::moves, 0 );
+
+        int i = 0;
+
+        for( AV::const_iterator current = av.begin() ; current != av.end() ; ++ current, ++ i ){
+            AV_ASSERT_EQUAL( current->second.value, i );
+        }
+    }
+}
+
+//
+// test_huge_page_allocator
+//
+void test_huge_page_allocator()
+{
+#ifdef AV_HAS_HUGE_PAGE_ALLOCATOR
+    // small threshold, storage crosses it and then grows by mremap
+    typedef array::HugePageAllocator< std::pair< int, int >, 4096 > Allocator;
+
+    typedef AssocVector< int, int, std::less< int >, Allocator > AV;
+
+    AV_ASSERT( AV::_Storage::can_reallocate );
+
+    AV av;
+    std::map< int, int > map;
+
+    for( int i = 0 ; i < 64 * 1024 ; ++ i )
+    {
+        int const key = rand() % ( 16 * 1024 );
+
+        if( rand() % 4 == 0 )
+        {
+            av.erase( key );
+            map.erase( key );
+        }
+        else
+        {
+            av.insert( AV::value_type( key, i ) );
+            map.insert( std::make_pair( key, i ) );
+        }
+    }
+
+    AV_ASSERT_EQUAL( av.size(), map.size() );
+    AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+
+    AV av2( av );
+
+    av.clear();
+
+    AV_ASSERT( std::equal( av2.begin(), av2.end(), map.begin() ) );
+#endif
+}
+
+
+//
+// test_constructor
+//
+void test_constructor()
+{
+    typedef std::vector< std::pair< std::string, int > > Vector;
+
+    Vector v;
+    v.push_back( std::make_pair( "1", 1 ) );
+    v.push_back( std::make_pair( "2", 2 ) );
+    v.push_back( std::make_pair( "3", 3 ) );
+    v.push_back( std::make_pair( "4", 4 ) );
+    v.push_back( std::make_pair( "5", 5 ) );
+
+    typedef AssocVector< std::string, int > AssocVector;
+
+    AssocVector av( v.begin(), v.end() );
+
+    AV_ASSERT_EQUAL( av.size(), 5 );
+
+    AssocVector::const_iterator found;
+
+    found = av.find( "1" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "1" );
+    AV_ASSERT_EQUAL( found->second, 1 );
+
+    found = av.find( "2" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "2" );
+    AV_ASSERT_EQUAL( found->second, 2 );
+
+    found = av.find( "3" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "3" );
+    AV_ASSERT_EQUAL( found->second, 3 );
+
+    found = av.find( "4" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "4" );
+    AV_ASSERT_EQUAL( found->second, 4 );
+
+    found = av.find( "5" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "5" );
+    AV_ASSERT_EQUAL( found->second, 5 );
+}
+
+//
+// test_copy_constructor
+//
+void test_copy_constructor()
+{
+    typedef AssocVector< std::string, int > AssocVector;
+
+    AssocVector assocVector1;
+
+    assocVector1[ "a" ] = 1;
+    assocVector1[ "b" ] = 2;
+    assocVector1[ "c" ] = 3;
+    assocVector1[ "d" ] = 4;
+    assocVector1[ "e" ] = 5;
+
+    AssocVector assocVector2( assocVector1 );
+    AV_ASSERT( assocVector1 == assocVector2 );
+
+    // erased items have to refer to the copy
+    assocVector1.erase( "b" );
+    AV_ASSERT_EQUAL( assocVector1.erased().size(), 1 );
+
+    AssocVector assocVector3( assocVector1 );
+    assocVector1.clear();
+
+    AV_ASSERT_EQUAL( assocVector3.size(), 4 );
+    AV_ASSERT( assocVector3.find( "b" ) == assocVector3.end() );
+    AV_ASSERT( assocVector3.find( "c" ) != assocVector3.end() );
+}
+
+//
+// test_constructor_init_list
+//
+void test_constructor_init_list()
+{
+    typedef AssocVector< std::string, int > AssocVector;
+
+    AssocVector av( { { "1", 1 }, { "4", 4 }, { "2", 2 }, { "5", 5 }, { "3", 3 }, { "2", 2 } } );
+
+    AV_ASSERT_EQUAL( av.size(), 5 );
+
+    AssocVector::const_iterator found;
+
+    found = av.find( "1" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "1" );
+    AV_ASSERT_EQUAL( found->second, 1 );
+
+    found = av.find( "2" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "2" );
+    AV_ASSERT_EQUAL( found->second, 2 );
+
+    found = av.find( "3" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "3" );
+    AV_ASSERT_EQUAL( found->second, 3 );
+
+    found = av.find( "4" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "4" );
+    AV_ASSERT_EQUAL( found->second, 4 );
+
+    found = av.find( "5" );
+    AV_ASSERT( found != av.end() );
+    AV_ASSERT_EQUAL( found->first, "5" );
+    AV_ASSERT_EQUAL( found->second, 5 );
+}
+
+//
+// test_assign_operator
+//
+void test_assign_operator()
+{
+    typedef AssocVector< std::string, int > AssocVector;
+
+    AssocVector assocVector1;
+
+    assocVector1[ "a" ] = 1;
+    assocVector1[ "b" ] = 2;
+    assocVector1[ "c" ] = 3;
+    assocVector1[ "d" ] = 4;
+    assocVector1[ "e" ] = 5;
+
+    AssocVector assocVector2;
+    assocVector2 = assocVector1;
+
+    AV_ASSERT( assocVector1 == assocVector2 );
+}
+
+//
+// test_clear
+//
+void test_clear()
+{
+    typedef AssocVector< std::string, int > AssocVector;
+
+    AssocVector assocVector;
+
+    assocVector[ "a" ] = 1;
+    assocVector[ "b" ] = 2;
+    assocVector[ "c" ] = 3;
+    assocVector[ "d" ] = 4;
+    assocVector[ "e" ] = 5;
+
+    AV_ASSERT_EQUAL( assocVector.erase( "a" ), 1 );
+
+    AV_ASSERT_EQUAL( assocVector.size(), 4 );
+
+    assocVector.clear();
+
+    AV_ASSERT( assocVector.empty() );
+}
+
+//
+// test_iterator_to_const_iterator_conversion
+//
+void test_iterator_to_const_iterator_conversion()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator iterator;
+    typedef AssocVector::const_iterator const_iterator;
+
+    AssocVector av;
+
+    iterator i = av.find( 10 );
+    AV_ASSERT( i == av.end() );
+
+    const_iterator ci = av.find( 10 );
+    AV_ASSERT( ci == av.end() );
+}
+
+//
+// test_iterators_distance
+//
+void test_iterators_distance()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+
+    AV_ASSERT( av.begin() == av.end() );
+    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 0 );
+
+    av.insert( AssocVector::value_type( 1, 1 ) );
+
+    AV_ASSERT( av.begin() != av.end() );
+    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 1 );
+
+    av.insert( AssocVector::value_type( 2, 2 ) );
+    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 2 );
+
+    av.insert( AssocVector::value_type( 3, 3 ) );
+    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 3 );
+}
+
+//
+// test_reverse_iterators_distance
+//
+void test_reverse_iterators_distance()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+
+    AV_ASSERT( av.rbegin() == av.rend() );
+    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 0 );
+
+    av.insert( AssocVector::value_type( 1, 1 ) );
+
+    AV_ASSERT( av.rbegin() != av.rend() );
+    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 1 );
+
+    av.insert( AssocVector::value_type( 2, 2 ) );
+    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 2 );
+
+    av.insert( AssocVector::value_type( 3, 3 ) );
+    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 3 );
+}
+
+//
+// test_reverse_iterators_base
+//
+void test_reverse_iterators_base()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef std::map< int, int > Map;
+
+    AssocVector av;
+    av[1] = 9;
+    av[0] = 7;
+    av[7] = 9;
+    av[2] = 4;
+
+    Map map;
+    map[1] = 9;
+    map[0] = 7;
+    map[7] = 9;
+    map[2] = 4;
+
+    AV_ASSERT( av.begin() == av.rend().base() );
+    AV_ASSERT( av.end() == av.rbegin().base() );
+
+    AssocVector::reverse_iterator avRBegin = av.rbegin();
+    av.erase( -- avRBegin.base() );
+
+    Map::reverse_iterator  mapRBegin = map.rbegin();
+    map.erase( -- mapRBegin.base() );
+
+    checkEqual( av, map );
+}
+
+//
+// test_iterators_begin_equals_end_in_empty_container
+//
+void test_iterators_begin_equals_end_in_empty_container()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+
+    AV_ASSERT( av.begin() == av.end() );
+}
+
+//
+// test_reverse_iterators_begin_equal_end_in_empty_storage
+//
+void test_reverse_iterators_begin_equal_end_in_empty_storage()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+
+    AV_ASSERT( av.rbegin() == av.rend() );
+}
+
+//
+// test_iterators_iterate_not_empty_storage_empty_cache
+//
+void test_iterators_iterate_not_empty_storage_empty_cache()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+    av.reserve( 32 );
+
+    for( std::size_t i = 0 ; i < 1024 ; ++ i ){
+        av.insert( AssocVector::value_type(  i, 0 ) );
+    }
+
+    AV_ASSERT_EQUAL( av.size(), 1024 );
+    AV_ASSERT_EQUAL( av.bufferSize(), 0 );
+    AV_ASSERT_EQUAL( av.storageSize(), 1024 );
+
+    Iterator current = av.begin();
+    Iterator const end = av.end();
+
+    for( int i = 0 ; current != end ; ++ current, ++i ){
+        AV_ASSERT_EQUAL( current->first, i );
+    }
+}
+
+//
+// test_iterators_increment_decrement_1
+//
+void test_iterators_increment_decrement_1()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+    av.reserve( 128 );
+
+    for( std::size_t i = 0 ; i < av.size() ; ++ i ){
+        av.insert( AssocVector::value_type( i, i ) );
+    }
+
+    Iterator current = av.begin();
+    Iterator const begin = av.begin();
+    Iterator const end = av.end();
+
+    for( /*empty*/ ; current != end ; ++ current );
+    for( /*empty*/ ; current != begin ; -- current );
+
+    AV_ASSERT( current == begin );
+}
+
+//
+// test_iterators_increment_decrement_2
+//
+void test_iterators_increment_decrement_2()
+{
+    typedef AssocVector< int, int > AssocVector;
+    typedef AssocVector::iterator Iterator;
+
+    AssocVector av;
+
+    for( std::size_t i = 16 ; i != 0 ; -- i ){
+        av.insert( AssocVector::value_type( i - 1, i - 1 ) );
+    }
+
+    {
+        Iterator current = av.end();
+        Iterator const begin = av.begin();
+
+        for( int counter = 16 ; current != begin ; /*empty*/ )
+        {
+            -- current;
+            -- counter;
+
+            AV_ASSERT( current->first == counter );
+            AV_ASSERT( current->second == counter );
+        }
+
+        AV_ASSERT( current == begin );
+    }
+
+    {
+        Iterator current = av.begin();
+        Iterator const end = av.end();
+
+        for( int counter = 0 ; current != end ; /*empty*/ )
+        {
+            AV_ASSERT( current->first == counter );
+            AV_ASSERT( current->second == counter );
+
+            ++ current;
+            ++ counter;
+        }
+
+        AV_ASSERT( current == end );
+    }
+}
+
+//
+// black_box_test
+//
+template< typename _Key, typename _Value >
+void black_box_test( int rep )
+{
+    typedef AssocVector< _Key, _Value > AV;
+    AV av;
+
+    typedef std::map< _Key, _Value > MAP;
+    MAP map;
+
+    TestCase< _Key, _Value > test( av, map );
+
+    checkEqual( av, map );
+
+    int percentage = 1;
+    int const progressStep = 20;
+    int const numberOfRepetitions = rep * 256;
+
+    {//draw simple progress bar
+        std::cout << "[0%.."; std::flush( std::cout );
+    }
+
+    for( int i = 0 ; i < numberOfRepetitions ; ++ i )
+    {
+        {//draw simple progress bar
+            if( 100.0 * i / numberOfRepetitions >= progressStep * percentage ){
+                std::cout << progressStep * (percentage++) << "%.."; std::flush( std::cout );
+            }
+        }
+
+        unsigned const maxKeyValue = 128;
+
+        int operation = rand() % 10;
+
+        switch( operation )
+        {
+            case 0:
+            case 1:
+            case 2:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> insert( key, key );
+                }
+
+                break;
+
+            case 3:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> find( key );
+                }
+
+                break;
+
+            case 4:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> erase( key );
+                }
+
+                break;
+
+            case 5:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> findErase( key );
+                }
+
+                break;
+
+            case 6:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> index_put( key, key );
+                }
+
+                break;
+
+            case 7:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> lower_bound( key );
+                }
+
+                break;
+
+            case 8:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> upper_bound( key );
+                }
+
+                break;
+
+            case 9:
+                {
+                    int const key = rand() % maxKeyValue;
+
+                    test >> equal_range( key );
+                }
+
+                break;
+
+            default:
+                AV_ASSERT( false );
+        }
+    }
+
+    {//draw simple progress bar
+        std::cout << "100%] "; std::flush( std::cout );
+    }
+}
+
+//
+// mem_leak_test_1
+//
+void mem_leak_test_1()
+{
+    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Key::createdObjects = 0;
+    Key::destroyedObjects = 0;
+
+    Key::moves = 0;
+    Key::copies = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    Value::moves = 0;
+    Value::copies = 0;
+
+    {
+        unsigned const maxKeyValue = 512;
+
+        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
+        AV av;
+
+        for( int i = 0 ; i < 128 * 1024 ; ++ i )
+        {
+            int const operation = rand() % 5;
+
+            switch( operation )
+            {
+                case 0:
+                    av.insert( typename AV::value_type( rand() % maxKeyValue, Value() ) );
+                    break;
+
+                case 1:
+                    av.find( rand() % maxKeyValue );
+                    break;
+
+                case 2:
+                    av.erase( rand() % maxKeyValue );
+                    break;
+
+                case 3:
+                    {
+                        typename AV::iterator foundAV = av.find( rand() % maxKeyValue );
+
+                        if( foundAV != av.end() ){
+                            av.erase( foundAV );
+                        }
+                    }
+
+                    break;
+
+                case 4:
+                    av[ rand() % maxKeyValue ] = Value();
+                    break;
+            }
+        }
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+
+    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// mem_leak_test_destructor
+//
+void mem_leak_test_destructor()
+{
+    typedef MyAllocator< std::pair< int, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    {
+        int const numberOfObjects = 1024;
+
+        typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
+        AV av;
+
+        for( int i = 0 ; i < numberOfObjects ; ++ i ){
+            av.insert( AV::value_type( i, Value() ) );
+        }
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// mem_leak_test_clear
+//
+void mem_leak_test_clear()
+{
+    typedef MyAllocator< std::pair< int, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    int const numberOfObjects = 1024;
+
+    typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
+    AV av;
+
+    for( int i = 0 ; i < numberOfObjects ; ++ i ){
+        av.insert( AV::value_type( i, Value() ) );
+    }
+
+    av.clear();
+
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// mem_leak_test_copy_constructor
+//
+void mem_leak_test_copy_constructor()
+{
+    typedef MyAllocator< std::pair< int, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    {
+        int const numberOfObjects = 1024;
+
+        typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
+        AV av;
+
+        for( int i = 0 ; i < numberOfObjects ; ++ i ){
+            av.insert( AV::value_type( i, Value() ) );
+        }
+
+        AV av2( av );
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// mem_leak_test_assign_operator
+//
+void mem_leak_test_assign_operator()
+{
+    typedef MyAllocator< std::pair< int, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    {
+        int const numberOfObjects = 1024;
+
+        typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
+        AV av;
+
+        for( int i = 0 ; i < numberOfObjects ; ++ i ){
+            av.insert( AV::value_type( i, Value() ) );
+        }
+
+        AV av2;
+        av2 = av;
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// cxx11x_move_test_1
+//
+void cxx11x_move_test_1()
+{
+    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Key::createdObjects = 0;
+    Key::destroyedObjects = 0;
+
+    Key::moves = 0;
+    Key::copies = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    Value::moves = 0;
+    Value::copies = 0;
+
+    {
+        unsigned const counter = 1024;
+
+        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
+        AV av1;
+
+        {// insert( value_type )
+            for( unsigned i = 0 ; i < counter ; ++ i ){
+                av1.insert( AV::value_type( i, Value() ) );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Value::copies, 0 );
+
+        AV av2 = std::move( av1 );
+
+        AV_ASSERT_EQUAL( Value::copies, 0 );
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+
+    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// cxx11x_move_test_2
+//
+void cxx11x_move_test_2()
+{
+    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Key::createdObjects = 0;
+    Key::destroyedObjects = 0;
+
+    Key::moves = 0;
+    Key::copies = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    Value::moves = 0;
+    Value::copies = 0;
+
+    {
+        unsigned const counter = 1024;
+
+        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
+        AV av;
+
+        {// insert( value_type )
+            for( unsigned i = 0 ; i < counter / 4 ; ++ i ){
+                Value value;
+
+                av.insert( AV::value_type( i, value ) );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 4 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// insert( value_type )
+            for( unsigned i = counter / 4 ; i < counter / 2 ; ++ i ){
+                av.insert( AV::value_type( Key( i ), Value( i ) ) );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// operator[]( value_type )
+            for( unsigned i = counter / 4 ; i < counter / 2 ; ++ i ){
+                av[ i ] = Value();
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// find( value_type )
+            for( unsigned i = 0 ; i < counter / 4 ; ++ i ){
+                av.find( i );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// _find( value_type )
+            for( unsigned i = counter / 4 ; i < counter / 2 ; ++ i ){
+                av._find( i );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// operator[]( value_type ), key is moved in
+            for( unsigned i = counter / 2 ; i < counter ; ++ i ){
+                av[ i ] = i;
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// erase( value_type )
+            for( unsigned i = 0 ; i < counter / 2 ; ++ i ){
+                av.erase( i );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
+        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+
+        {// erase( iterator )
+            for( unsigned i = counter / 2 ; i < counter ; ++ i ){
+                av.erase( av.find( i ) );
+            }
+        }
+
+        AV_ASSERT( Key::copies <= 2 * counter );
+        AV_ASSERT( Value::copies <= 2 * counter );
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+
+    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// cxx11x_forward_test_insert
+//
+void cxx11x_forward_test_insert()
+{
+    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+
+    Allocator::notFreedMemory = 0;
+    Allocator::totalMemory = 0;
+
+    Key::createdObjects = 0;
+    Key::destroyedObjects = 0;
+
+    Key::moves = 0;
+    Key::copies = 0;
+
+    Value::createdObjects = 0;
+    Value::destroyedObjects = 0;
+
+    Value::moves = 0;
+    Value::copies = 0;
+
+    {
+        unsigned const counter = 1024;
+
+        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
+        AV av;
+
+        {// insert( value_type )
+            for( unsigned i = 0 ; i < counter / 2 ; ++ i ){
+                av.insert( std::move( AV::value_type( i, std::move( Value() ) ) ) );
+            }
+        }
+
+        AV_ASSERT_EQUAL( Value::copies, 0 );
+    }
+
+    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+
+    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
+    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+}
+
+//
+// cxx11x_at_test
+//
+void cxx11x_at_test()
+{
+    typedef AssocVector< std::string, int > AssocVector;
+
+    AssocVector av;
+
+    av[ "a" ] = 1;
+    av[ "b" ] = 2;
+    av[ "c" ] = 3;
+
+    av.erase( "b" );
+
+    AV_ASSERT( av.at( "a" ) == 1 );
+    AV_ASSERT( av.at( "c" ) == 3 );
+
+    try{
+        av.at( "b" ) = 2;
+        AV_ASSERT( false );
+    }
+    catch( std::out_of_range & ){
+    }
+    catch( ... ){
+        AV_ASSERT( false );
+    }
+
+    try{
+        av.at( "d" ) = 4;
+        AV_ASSERT( false );
+    }
+    catch( std::out_of_range & ){
+    }
+    catch( ... ){
+        AV_ASSERT( false );
+    }
+}
+
+//
+// cxx11x_emplace_test
+//
+void cxx11x_emplace_test()
+{
+    typedef AssocVector< Key, Value > AssocVector;
+
+    {
+        AssocVector av;
+
+        Key::copies = 0;
+        Value::copies = 0;
+
+        av.emplace( 1 );
+
+        AV_ASSERT_EQUAL( Key::copies, 0 );
+        AV_ASSERT_EQUAL( Value::copies, 0 );
+
+        AV_ASSERT( av.at( 1 ) == Value( 0, "" ) );
+    }
+
+    {
+        AssocVector av;
+
+        Key::copies = 0;
+        Value::copies = 0;
+
+        av.emplace( 11, 22 );
+
+        AV_ASSERT_EQUAL( Key::copies, 0 );
+        AV_ASSERT_EQUAL( Value::copies, 0 );
+
+        AV_ASSERT( av.at( 11 ) == Value( 22, "" ) );
+    }
+
+    {
+        AssocVector av;
+
+        Key::copies = 0;
+        Value::copies = 0;
+
+        av.emplace( 111, 222, "333" );
+
+        AV_ASSERT_EQUAL( Key::copies, 0 );
+        AV_ASSERT_EQUAL( Value::copies, 0 );
+
+        AV_ASSERT( av.at( 111 ) == Value( 222, "333" ) );
+    }
+}
+
+//
+// cxx11x_try_emplace_test
+//
+void cxx11x_try_emplace_test()
+{
+    typedef AssocVector< Key, Value > AssocVector;
+
+    AssocVector av;
+
+    for( int i = 0 ; i < 64 ; ++ i ){
+        av.try_emplace( 2 * i, i, "try_emplace" );
+    }
+
+    Value::createdObjects = 0;
+    Key::copies = 0;
+
+    {// hit, nothing is constructed
+        for( int i = 0 ; i < 64 ; ++ i )
+        {
+            std::pair< AssocVector::iterator, bool > const result = av.try_emplace( 2 * i, -1, "hit" );
+
+            AV_ASSERT( result.second == false );
+            AV_ASSERT( result.first->second == Value( i, "try_emplace" ) );
+        }
+
+        for( int i = 0 ; i < 64 ; ++ i ){
+            av[ 2 * i ];
+        }
+
+        AV_ASSERT_EQUAL( Value::createdObjects, 64 );
+        AV_ASSERT_EQUAL( Key::copies, 0 );
+    }
 
-    TestCase< Key, Value > test( av, map );
+    {// miss, key is not copied
+        Key const key( 1 );
 
-    test
-        >> insert( Range<>( 30, 10, -1 ) )
-        >> erase( 11 )
-        >> erase( 20 )
-        >> erase( 28 )
+        std::pair< AssocVector::iterator, bool > const result = av.try_emplace( Key( 1 ), 11, "miss" );
 
-        >> lower_bound( Range<>( 0, 40, 2 ) )
-        >> lower_bound( Range<>( 1, 41, 2 ) );
-}
+        AV_ASSERT( result.second );
+        AV_ASSERT( result.first->first == key );
+        AV_ASSERT( result.first->second == Value( 11, "miss" ) );
+        AV_ASSERT_EQUAL( Key::copies, 0 );
 
-//
-// test_upper_bound
-//
-void test_upper_bound()
-{
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+        AV_ASSERT( av.try_emplace( av.begin(), key, 12 )->second == Value( 11, "miss" ) );
+        AV_ASSERT_EQUAL( av.size(), 65 );
+    }
 
-    TestCase< Key, Value > test( av, map );
+    {// erased item is reused
+        av.erase( 4 );
+        AV_ASSERT( av.try_emplace( 4, 44 ).second );
+        AV_ASSERT( av.at( 4 ) == Value( 44 ) );
+    }
 
-    test
-        >> insert( Range<>( 30, 10, -1 ) )
-        >> erase( 11 )
-        >> erase( 20 )
-        >> erase( 28 )
+    {// insert_or_assign
+        std::pair< AssocVector::iterator, bool > result = av.insert_or_assign( 6, Value( 66 ) );
 
-        >> upper_bound( Range<>( 0, 40, 2 ) )
-        >> upper_bound( Range<>( 1, 41, 2 ) );
-}
+        AV_ASSERT( result.second == false );
+        AV_ASSERT( av.at( 6 ) == Value( 66 ) );
 
-//
-// test_equal_range
-//
-void test_equal_range()
-{
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+        result = av.insert_or_assign( 7, Value( 77 ) );
 
-    TestCase< Key, Value > test( av, map );
+        AV_ASSERT( result.second );
+        AV_ASSERT( result.first->second == Value( 77 ) );
+        AV_ASSERT( av.insert_or_assign( av.end(), 7, Value( 777 ) )->second == Value( 777 ) );
+        AV_ASSERT_EQUAL( av.size(), 66 );
+    }
 
-    test
-        >> insert( Range<>( 30, 10, -1 ) )
-        >> erase( 11 )
-        >> erase( 20 )
-        >> erase( 28 )
+    {// emplace, piecewise
+        std::pair< AssocVector::iterator, bool > const result = av.emplace(
+              std::piecewise_construct
+            , std::forward_as_tuple( 9 )
+            , std::forward_as_tuple( 99, "piecewise" )
+        );
 
-        >> equal_range( Range<>( 0, 40, 2 ) )
-        >> equal_range( Range<>( 1, 41, 2 ) );
+        AV_ASSERT( result.second );
+        AV_ASSERT( av.at( 9 ) == Value( 99, "piecewise" ) );
+    }
 }
 
 //
-// test_swap
+// ShardedAssocVectorCollect, for_each functor
 //
-void test_swap()
+struct ShardedAssocVectorCollect
 {
-    // todo
-}
+    ShardedAssocVectorCollect( std::vector< std::pair< int, int > > & items )
+        : _items( items )
+    {
+    }
+
+    void operator()( std::pair< int const, int > const & value )
+    {
+        _items.push_back( value );
+    }
+
+    std::vector< std::pair< int, int > > & _items;
+};
 
 //
-// test_operator_index
+// concurrent_sharded_test
 //
-void test_operator_index()
+void concurrent_sharded_test()
 {
-    AssocVector< Key, Value > av;
-    std::map< Key, Value > map;
+    typedef ShardedAssocVector< int, int > SAV;
 
-    TestCase< Key, Value > test( av, map );
+    SAV sav( 8 );
+    std::map< int, int > map;
 
-    test
-        >> index_put( 1, 1 )
-        >> index_put( 1, 11 )
-        >> index_put( 1, 111 )
+    for( int i = 0 ; i < 4096 ; ++ i )
+    {
+        int const key = rand() % 1024;
 
-        >> index_get( 2 )
+        if( rand() % 4 == 0 ){
+            AV_ASSERT_EQUAL( sav.erase( key ), map.erase( key ) );
+        }
+        else if( rand() % 2 == 0 ){
+            AV_ASSERT_EQUAL( sav.insert( std::make_pair( key, i ) ), map.insert( std::make_pair( key, i ) ).second );
+        }
+        else
+        {
+            bool const inserted = map.count( key ) == 0;
+            map[ key ] = i;
 
-        >> insert( 3, 33 )
-        >> index_get( 3 )
+            AV_ASSERT_EQUAL( sav.insert_or_assign( key, i ), inserted );
+        }
 
-        >> erase( 3 )
-        >> index_get( 3 );
-}
+        if( i % 512 == 0 )
+        {
+            sav.rebalance();
 
-//
-// test_user_type
-//
-void test_user_type()
-{
-    typedef AssocVector< Key, Value > AssocVector;
+            AV_ASSERT( sav.boundaries().size() < sav.shards() );
+        }
+    }
 
-    AssocVector av;
-    av.insert( AssocVector::value_type( Key(), Value() ) );
-    Value & m = av[ Key() ];
-    av[ Key() ] = m;
-    av.find( Key() );
-}
+    AV_ASSERT_EQUAL( sav.size(), map.size() );
 
+    std::vector< std::pair< int, int > > const expectedItems( map.begin(), map.end() );
 
-//
-// test_constructor
-//
-void test_constructor()
-{
-    typedef std::vector< std::pair< std::string, int > > Vector;
+    {// for_each visits items in key order across shards
+        std::vector< std::pair< int, int > > items;
+        sav.for_each( ShardedAssocVectorCollect( items ) );
 
-    Vector v;
-    v.push_back( std::make_pair( "1", 1 ) );
-    v.push_back( std::make_pair( "2", 2 ) );
-    v.push_back( std::make_pair( "3", 3 ) );
-    v.push_back( std::make_pair( "4", 4 ) );
-    v.push_back( std::make_pair( "5", 5 ) );
+        AV_ASSERT( items == expectedItems );
+    }
 
-    typedef AssocVector< std::string, int > AssocVector;
+    for( int key = -2 ; key < 1030 ; ++ key )
+    {
+        int mapped = -1;
 
-    AssocVector av( v.begin(), v.end() );
+        AV_ASSERT( sav.find( key, mapped ) == ( map.count( key ) == 1 ) );
+        AV_ASSERT_EQUAL( sav.count( key ), map.count( key ) );
 
-    AV_ASSERT_EQUAL( av.size(), 5 );
+        if( map.count( key ) == 1 ){
+            AV_ASSERT_EQUAL( mapped, map[ key ] );
+        }
 
-    AssocVector::const_iterator found;
+        std::pair< int, int > value;
+        std::map< int, int >::const_iterator const expected = map.lower_bound( key );
 
-    found = av.find( "1" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "1" );
-    AV_ASSERT_EQUAL( found->second, 1 );
+        AV_ASSERT( sav.lower_bound( key, value ) == ( expected != map.end() ) );
 
-    found = av.find( "2" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "2" );
-    AV_ASSERT_EQUAL( found->second, 2 );
+        if( expected != map.end() ){
+            AV_ASSERT( value == std::make_pair( expected->first, expected->second ) );
+        }
+    }
 
-    found = av.find( "3" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "3" );
-    AV_ASSERT_EQUAL( found->second, 3 );
+    {// resplit with user boundaries, keys equal to a boundary go right
+        std::vector< int > boundaries;
+        boundaries.push_back( 100 );
+        boundaries.push_back( 500 );
+        boundaries.push_back( 501 );
 
-    found = av.find( "4" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "4" );
-    AV_ASSERT_EQUAL( found->second, 4 );
+        sav.resplit( boundaries );
 
-    found = av.find( "5" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "5" );
-    AV_ASSERT_EQUAL( found->second, 5 );
-}
+        AV_ASSERT( sav.boundaries() == boundaries );
+        AV_ASSERT_EQUAL( sav.size(), map.size() );
 
-//
-// test_copy_constructor
-//
-void test_copy_constructor()
-{
-    typedef AssocVector< std::string, int > AssocVector;
+        std::vector< std::pair< int, int > > items;
+        sav.for_each( ShardedAssocVectorCollect( items ) );
 
-    AssocVector assocVector1;
+        AV_ASSERT( items == expectedItems );
+    }
 
-    assocVector1[ "a" ] = 1;
-    assocVector1[ "b" ] = 2;
-    assocVector1[ "c" ] = 3;
-    assocVector1[ "d" ] = 4;
-    assocVector1[ "e" ] = 5;
+    {// built without boundaries, rebalanced once the first shard is large enough
+        SAV split( 8 );
 
-    AssocVector assocVector2( assocVector1 );
-    AV_ASSERT( assocVector1 == assocVector2 );
-}
+        for( int i = 0 ; i < AV_SHARD_SPLIT_ITEMS ; ++ i ){
+            AV_ASSERT( split.boundaries().empty() );
 
-//
-// test_constructor_init_list
-//
-void test_constructor_init_list()
-{
-    typedef AssocVector< std::string, int > AssocVector;
+            split.insert( std::make_pair( i, i ) );
+        }
 
-    AssocVector av( { { "1", 1 }, { "4", 4 }, { "2", 2 }, { "5", 5 }, { "3", 3 }, { "2", 2 } } );
+        AV_ASSERT_EQUAL( split.boundaries().size(), split.shards() - 1 );
+        AV_ASSERT_EQUAL( split.size(), static_cast< std::size_t >( AV_SHARD_SPLIT_ITEMS ) );
 
-    AV_ASSERT_EQUAL( av.size(), 5 );
+        // previous layouts are reclaimed on every resplit
+        for( int i = 0 ; i < 64 ; ++ i ){
+            split.resplit( std::vector< int >( 1, i * 64 ) );
+        }
 
-    AssocVector::const_iterator found;
+        AV_ASSERT( split.boundaries() == std::vector< int >( 1, 63 * 64 ) );
 
-    found = av.find( "1" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "1" );
-    AV_ASSERT_EQUAL( found->second, 1 );
+        std::vector< std::pair< int, int > > items;
+        split.for_each( ShardedAssocVectorCollect( items ) );
 
-    found = av.find( "2" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "2" );
-    AV_ASSERT_EQUAL( found->second, 2 );
+        AV_ASSERT_EQUAL( items.size(), static_cast< std::size_t >( AV_SHARD_SPLIT_ITEMS ) );
+    }
 
-    found = av.find( "3" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "3" );
-    AV_ASSERT_EQUAL( found->second, 3 );
+    {// empty
+        SAV empty( std::vector< int >( 1, 0 ) );
+        std::pair< int, int > value;
 
-    found = av.find( "4" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "4" );
-    AV_ASSERT_EQUAL( found->second, 4 );
+        AV_ASSERT( empty.empty() );
+        AV_ASSERT_EQUAL( empty.shards(), 2 );
+        AV_ASSERT( empty.lower_bound( 0, value ) == false );
 
-    found = av.find( "5" );
-    AV_ASSERT( found != av.end() );
-    AV_ASSERT_EQUAL( found->first, "5" );
-    AV_ASSERT_EQUAL( found->second, 5 );
+        empty.rebalance();
+        AV_ASSERT( empty.boundaries().empty() );
+    }
 }
 
 //
-// test_assign_operator
+// ShardedAssocVectorWriter, inserts keys i * threads + id and erases every third of them
 //
-void test_assign_operator()
+struct ShardedAssocVectorWriter
 {
-    typedef AssocVector< std::string, int > AssocVector;
+    ShardedAssocVectorWriter( ShardedAssocVector< int, int > & sav, int id, int threads, int items )
+        : _sav( sav )
+        , _id( id )
+        , _threads( threads )
+        , _items( items )
+    {
+    }
 
-    AssocVector assocVector1;
+    void operator()()
+    {
+        for( int i = 0 ; i < _items ; ++ i )
+        {
+            int const key = i * _threads + _id;
 
-    assocVector1[ "a" ] = 1;
-    assocVector1[ "b" ] = 2;
-    assocVector1[ "c" ] = 3;
-    assocVector1[ "d" ] = 4;
-    assocVector1[ "e" ] = 5;
+            _sav.insert( std::make_pair( key, _id ) );
 
-    AssocVector assocVector2;
-    assocVector2 = assocVector1;
+            if( i % 3 == 0 ){
+                _sav.erase( key );
+            }
 
-    AV_ASSERT( assocVector1 == assocVector2 );
+            if( _id == 0 && i % 1024 == 0 ){
+                _sav.rebalance();
+            }
+        }
+    }
+
+    ShardedAssocVector< int, int > & _sav;
+    int _id;
+    int _threads;
+    int _items;
+};
+
+//
+// shardedResplitStep, scripts concurrent_sharded_resplit_test, -1 when no script runs:
+// 0 the router stops after reading the epoch, 1 it waits there, 2 the first resplit is done,
+// 3 the router waits in its first comparison, 4 the second resplit is done
+//
+std::atomic< int > shardedResplitStep( -1 );
+
+void shardedRouterHook()
+{
+    int expected = 0;
+
+    if( shardedResplitStep.compare_exchange_strong( expected, 1 ) )
+    {
+        while( shardedResplitStep.load() == 1 ){
+            std::this_thread::yield();
+        }
+    }
 }
 
 //
-// test_clear
+// ShardedPoisonedKey, key which is poisoned on destruction, a router which reads boundaries
+// of a reclaimed layout compares a key which is not alive
 //
-void test_clear()
+struct ShardedPoisonedKey
 {
-    typedef AssocVector< std::string, int > AssocVector;
+    ShardedPoisonedKey( int value = 0, bool routed = false )
+        : _value( value )
+        , _alive( 0x5eed )
+        , _routed( routed )
+    {
+    }
 
-    AssocVector assocVector;
+    ~ShardedPoisonedKey()
+    {
+        // volatile, a store to a dying object is removed otherwise
+        * static_cast< int volatile * >( & _alive ) = 0;
+    }
 
-    assocVector[ "a" ] = 1;
-    assocVector[ "b" ] = 2;
-    assocVector[ "c" ] = 3;
-    assocVector[ "d" ] = 4;
-    assocVector[ "e" ] = 5;
+    int _value;
+    int _alive;
+    bool _routed;
+};
 
-    AV_ASSERT_EQUAL( assocVector.erase( "a" ), 1 );
+//
+// ShardedScriptedLess, the router waits in its first comparison till the second resplit is done,
+// or for a while, since a correct resplit waits for the router
+//
+struct ShardedScriptedLess
+{
+    bool operator()( ShardedPoisonedKey const & lhs, ShardedPoisonedKey const & rhs )const
+    {
+        int expected = 2;
 
-    AV_ASSERT_EQUAL( assocVector.size(), 4 );
+        if( ( lhs._routed || rhs._routed ) && shardedResplitStep.compare_exchange_strong( expected, 3 ) )
+        {
+            for( int i = 0 ; i < 4096 && shardedResplitStep.load() == 3 ; ++ i ){
+                std::this_thread::yield();
+            }
+        }
 
-    assocVector.clear();
+        AV_ASSERT_EQUAL( lhs._alive, 0x5eed );
+        AV_ASSERT_EQUAL( rhs._alive, 0x5eed );
 
-    AV_ASSERT( assocVector.empty() );
-}
+        return lhs._value < rhs._value;
+    }
+};
+
+typedef ShardedAssocVector< ShardedPoisonedKey, int, ShardedScriptedLess > ShardedPoisonedAssocVector;
 
 //
-// test_iterator_to_const_iterator_conversion
+// ShardedAssocVectorRouter, finds keys until all resplits are done
 //
-void test_iterator_to_const_iterator_conversion()
+struct ShardedAssocVectorRouter
 {
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator iterator;
-    typedef AssocVector::const_iterator const_iterator;
+    ShardedAssocVectorRouter( ShardedPoisonedAssocVector & sav, std::atomic< bool > & done, int items )
+        : _sav( sav )
+        , _done( done )
+        , _items( items )
+    {
+    }
 
-    AssocVector av;
+    void operator()()
+    {
+        for( int i = 0 ; _done.load() == false ; ++ i )
+        {
+            int const key = i % _items;
 
-    iterator i = av.find( 10 );
-    AV_ASSERT( i == av.end() );
+            int mapped = -1;
 
-    const_iterator ci = av.find( 10 );
-    AV_ASSERT( ci == av.end() );
-}
+            AV_ASSERT( _sav.find( ShardedPoisonedKey( key, true ), mapped ) );
+            AV_ASSERT_EQUAL( mapped, key );
+        }
+    }
+
+    ShardedPoisonedAssocVector & _sav;
+    std::atomic< bool > & _done;
+    int _items;
+};
 
 //
-// test_iterators_distance
+// concurrent_sharded_resplit_test, a router reads the epoch, two resplits run back to back,
+// the first one after the router read the epoch, the second one while the router searches boundaries
 //
-void test_iterators_distance()
+void concurrent_sharded_resplit_test()
 {
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+    int const items = 64;
 
-    AssocVector av;
+    std::vector< ShardedPoisonedKey > even;
+    std::vector< ShardedPoisonedKey > odd;
 
-    AV_ASSERT( av.begin() == av.end() );
-    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 0 );
+    for( int boundary = 8 ; boundary < items ; boundary += 8 )
+    {
+        even.push_back( ShardedPoisonedKey( boundary ) );
+        odd.push_back( ShardedPoisonedKey( boundary - 4 ) );
+    }
 
-    av.insert( AssocVector::value_type( 1, 1 ) );
+    ShardedPoisonedAssocVector sav( even );
 
-    AV_ASSERT( av.begin() != av.end() );
-    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 1 );
+    for( int key = 0 ; key < items ; ++ key ){
+        AV_ASSERT( sav.insert( std::make_pair( ShardedPoisonedKey( key ), key ) ) );
+    }
 
-    av.insert( AssocVector::value_type( 2, 2 ) );
-    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 2 );
+    std::atomic< bool > done( false );
 
-    av.insert( AssocVector::value_type( 3, 3 ) );
-    AV_ASSERT_EQUAL( std::distance( av.begin(), av.end() ), 3 );
-}
+    std::thread router( ShardedAssocVectorRouter( sav, done, items ) );
 
-//
-// test_reverse_iterators_distance
-//
-void test_reverse_iterators_distance()
-{
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+    for( int round = 0 ; round < 64 ; ++ round )
+    {
+        shardedResplitStep.store( 0 );
 
-    AssocVector av;
+        while( shardedResplitStep.load() != 1 ){
+            std::this_thread::yield();
+        }
 
-    AV_ASSERT( av.rbegin() == av.rend() );
-    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 0 );
+        sav.resplit( odd );
 
-    av.insert( AssocVector::value_type( 1, 1 ) );
+        shardedResplitStep.store( 2 );
 
-    AV_ASSERT( av.rbegin() != av.rend() );
-    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 1 );
+        while( shardedResplitStep.load() != 3 ){
+            std::this_thread::yield();
+        }
 
-    av.insert( AssocVector::value_type( 2, 2 ) );
-    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 2 );
+        sav.resplit( even );
 
-    av.insert( AssocVector::value_type( 3, 3 ) );
-    AV_ASSERT_EQUAL( std::distance( av.rbegin(), av.rend() ), 3 );
+        shardedResplitStep.store( 4 );
+    }
+
+    done.store( true );
+    router.join();
+
+    shardedResplitStep.store( -1 );
+
+    AV_ASSERT_EQUAL( sav.size(), static_cast< std::size_t >( items ) );
 }
 
 //
-// test_reverse_iterators_base
+// concurrent_sharded_threads_test
 //
-void test_reverse_iterators_base()
+void concurrent_sharded_threads_test()
 {
-    typedef AssocVector< int, int > AssocVector;
-    typedef std::map< int, int > Map;
+    int const threads = 4;
+    int const items = 8 * 1024;
 
-    AssocVector av;
-    av[1] = 9;
-    av[0] = 7;
-    av[7] = 9;
-    av[2] = 4;
+    ShardedAssocVector< int, int > sav( 8 );
 
-    Map map;
-    map[1] = 9;
-    map[0] = 7;
-    map[7] = 9;
-    map[2] = 4;
+    std::vector< std::thread > workers;
 
-    AV_ASSERT( av.begin() == av.rend().base() );
-    AV_ASSERT( av.end() == av.rbegin().base() );
+    for( int id = 0 ; id < threads ; ++ id ){
+        workers.push_back( std::thread( ShardedAssocVectorWriter( sav, id, threads, items ) ) );
+    }
 
-    AssocVector::reverse_iterator avRBegin = av.rbegin();
-    av.erase( -- avRBegin.base() );
+    for( std::size_t i = 0 ; i < workers.size() ; ++ i ){
+        workers[ i ].join();
+    }
 
-    Map::reverse_iterator  mapRBegin = map.rbegin();
-    map.erase( -- mapRBegin.base() );
+    std::vector< std::pair< int, int > > collected;
+    sav.for_each( ShardedAssocVectorCollect( collected ) );
 
-    checkEqual( av, map );
+    AV_ASSERT_EQUAL( collected.size(), threads * ( items - ( items + 2 ) / 3 ) );
+    AV_ASSERT_EQUAL( sav.size(), collected.size() );
+
+    for( std::size_t i = 0 ; i < collected.size() ; ++ i )
+    {
+        int const key = collected[ i ].first;
+
+        AV_ASSERT( ( key / threads ) % 3 != 0 );
+        AV_ASSERT_EQUAL( collected[ i ].second, key % threads );
+
+        if( i > 0 ){
+            AV_ASSERT( collected[ i - 1 ].first < key );
+        }
+    }
 }
 
 //
-// test_iterators_begin_equals_end_in_empty_container
+// RcuAssocVectorCollect, read functor
 //
-void test_iterators_begin_equals_end_in_empty_container()
+struct RcuAssocVectorCollect
 {
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+    RcuAssocVectorCollect( std::vector< std::pair< int, int > > & items )
+        : _items( items )
+    {
+    }
 
-    AssocVector av;
+    void operator()( array::Span< std::pair< int, int > const > const & items )
+    {
+        _items.assign( items.begin(), items.end() );
+    }
 
-    AV_ASSERT( av.begin() == av.end() );
-}
+    std::vector< std::pair< int, int > > & _items;
+};
 
 //
-// test_reverse_iterators_begin_equal_end_in_empty_storage
+// RcuAssocVectorPublishWhileRead, read functor publishing new versions while the current one is pinned
 //
-void test_reverse_iterators_begin_equal_end_in_empty_storage()
+struct RcuAssocVectorPublishWhileRead
 {
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+    RcuAssocVectorPublishWhileRead( RcuAssocVector< int, int > & rcu )
+        : _rcu( rcu )
+    {
+    }
 
-    AssocVector av;
+    void operator()( array::Span< std::pair< int, int > const > const & items )
+    {
+        std::vector< std::pair< int, int > > const before( items.begin(), items.end() );
 
-    AV_ASSERT( av.rbegin() == av.rend() );
-}
+        for( int i = 0 ; i < 16 ; ++ i )
+        {
+            _rcu.insert( std::make_pair( 1000 + i, i ) );
+            _rcu.publish();
+        }
+
+        // pinned version is neither changed nor reclaimed
+        std::vector< std::pair< int, int > > const after( items.begin(), items.end() );
+        AV_ASSERT( after == before );
+        AV_ASSERT_EQUAL( _rcu.retired(), 16 );
+    }
+
+    RcuAssocVector< int, int > & _rcu;
+};
 
 //
-// test_iterators_iterate_not_empty_storage_empty_cache
+// concurrent_rcu_test
 //
-void test_iterators_iterate_not_empty_storage_empty_cache()
+void concurrent_rcu_test()
 {
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+    typedef RcuAssocVector< int, int > RAV;
 
-    AssocVector av;
-    av.reserve( 32 );
+    RAV rcu;
+    std::map< int, int > map;
 
-    for( std::size_t i = 0 ; i < 1024 ; ++ i ){
-        av.insert( AssocVector::value_type(  i, 0 ) );
-    }
+    RAV::reader reader( rcu );
 
-    AV_ASSERT_EQUAL( av.size(), 1024 );
-    AV_ASSERT_EQUAL( av.bufferSize(), 0 );
-    AV_ASSERT_EQUAL( av.storageSize(), 1024 );
+    AV_ASSERT_EQUAL( reader.size(), 0 );
 
-    Iterator current = av.begin();
-    Iterator const end = av.end();
+    for( int i = 0 ; i < 4096 ; ++ i )
+    {
+        int const key = rand() % 1024;
 
-    for( int i = 0 ; current != end ; ++ current, ++i ){
-        AV_ASSERT_EQUAL( current->first, i );
+        if( rand() % 4 == 0 ){
+            AV_ASSERT_EQUAL( rcu.erase( key ), map.erase( key ) );
+        }
+        else if( rand() % 2 == 0 ){
+            AV_ASSERT_EQUAL( rcu.insert( std::make_pair( key, i ) ), map.insert( std::make_pair( key, i ) ).second );
+        }
+        else
+        {
+            bool const inserted = map.count( key ) == 0;
+            map[ key ] = i;
+
+            AV_ASSERT_EQUAL( rcu.insert_or_assign( key, i ), inserted );
+        }
+
+        // published versions are flat copies of the writer
+        std::vector< std::pair< int, int > > items;
+        reader.read( RcuAssocVectorCollect( items ) );
+
+        typedef util::CmpByFirst< std::pair< int, int >, std::less< int > > Cmp;
+        AV_ASSERT( util::is_strictly_sorted( items.begin(), items.end(), Cmp() ) );
     }
-}
 
-//
-// test_iterators_increment_decrement_1
-//
-void test_iterators_increment_decrement_1()
-{
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+    AV_ASSERT_EQUAL( rcu.size(), map.size() );
 
-    AssocVector av;
-    av.reserve( 128 );
+    rcu.publish();
 
-    for( std::size_t i = 0 ; i < av.size() ; ++ i ){
-        av.insert( AssocVector::value_type( i, i ) );
+    AV_ASSERT_EQUAL( reader.size(), map.size() );
+    AV_ASSERT_EQUAL( rcu.retired(), 0 );
+
+    {
+        std::vector< std::pair< int, int > > items;
+        reader.read( RcuAssocVectorCollect( items ) );
+
+        std::vector< std::pair< int, int > > const expected( map.begin(), map.end() );
+        AV_ASSERT( items == expected );
     }
 
-    Iterator current = av.begin();
-    Iterator const begin = av.begin();
-    Iterator const end = av.end();
+    for( int key = -2 ; key < 1030 ; ++ key )
+    {
+        int mapped = -1;
 
-    for( /*empty*/ ; current != end ; ++ current );
-    for( /*empty*/ ; current != begin ; -- current );
+        AV_ASSERT( reader.find( key, mapped ) == ( map.count( key ) == 1 ) );
+        AV_ASSERT_EQUAL( reader.count( key ), map.count( key ) );
 
-    AV_ASSERT( current == begin );
-}
+        if( map.count( key ) == 1 ){
+            AV_ASSERT_EQUAL( mapped, map[ key ] );
+        }
 
-//
-// test_iterators_increment_decrement_2
-//
-void test_iterators_increment_decrement_2()
-{
-    typedef AssocVector< int, int > AssocVector;
-    typedef AssocVector::iterator Iterator;
+        std::pair< int, int > value;
+        std::map< int, int >::const_iterator const expected = map.lower_bound( key );
 
-    AssocVector av;
+        AV_ASSERT( reader.lower_bound( key, value ) == ( expected != map.end() ) );
 
-    for( std::size_t i = 16 ; i != 0 ; -- i ){
-        av.insert( AssocVector::value_type( i - 1, i - 1 ) );
+        if( expected != map.end() ){
+            AV_ASSERT( value == std::make_pair( expected->first, expected->second ) );
+        }
     }
 
-    {
-        Iterator current = av.end();
-        Iterator const begin = av.begin();
+    {// versions are reclaimed once no reader pins them
+        reader.read( RcuAssocVectorPublishWhileRead( rcu ) );
 
-        for( int counter = 16 ; current != begin ; /*empty*/ )
+        rcu.publish();
+
+        AV_ASSERT_EQUAL( rcu.retired(), 0 );
+    }
+
+    {// appends keep the writer flat, they are published in batches of O( sqrt N )
+        RAV appends;
+        RAV::reader appendsReader( appends );
+
+        std::size_t publishes = 0;
+        std::size_t published = 0;
+
+        for( int i = 0 ; i < 4096 ; ++ i )
         {
-            -- current;
-            -- counter;
+            appends.insert( std::make_pair( i, i ) );
 
-            AV_ASSERT( current->first == counter );
-            AV_ASSERT( current->second == counter );
+            std::size_t const size = appendsReader.size();
+
+            publishes += size != published ? 1 : 0;
+            published = size;
+
+            AV_ASSERT( published + 2 * RAV::writer_type::calculateNewBufferCapacity( i + 1 ) + 2 > static_cast< std::size_t >( i ) );
         }
 
-        AV_ASSERT( current == begin );
+        AV_ASSERT( publishes < 256 );
     }
 
-    {
-        Iterator current = av.begin();
-        Iterator const end = av.end();
+    {// reader slots
+        std::vector< std::unique_ptr< RAV::reader > > readers;
 
-        for( int counter = 0 ; current != end ; /*empty*/ )
-        {
-            AV_ASSERT( current->first == counter );
-            AV_ASSERT( current->second == counter );
+        for( std::size_t i = 1 ; i < AV_RCU_READERS ; ++ i ){
+            readers.push_back( std::unique_ptr< RAV::reader >( new RAV::reader( rcu ) ) );
+        }
 
-            ++ current;
-            ++ counter;
+        bool thrown = false;
+
+        try{
+            RAV::reader extra( rcu );
+        }
+        catch( std::runtime_error const & ){
+            thrown = true;
         }
 
-        AV_ASSERT( current == end );
+        AV_ASSERT( thrown );
+
+        readers.pop_back();
+        RAV::reader extra( rcu );
     }
 }
 
 //
-// black_box_test
+// RcuAssocVectorCheck, read functor, writer inserts 0, 1, 2, ... so a version is a prefix of them
 //
-template< typename _Key, typename _Value >
-void black_box_test( int rep )
+struct RcuAssocVectorCheck
 {
-    typedef AssocVector< _Key, _Value > AV;
-    AV av;
+    RcuAssocVectorCheck( std::size_t & size )
+        : _size( size )
+    {
+    }
 
-    typedef std::map< _Key, _Value > MAP;
-    MAP map;
+    void operator()( array::Span< std::pair< int, int > const > const & items )
+    {
+        AV_ASSERT( items.size() >= _size );
 
-    TestCase< _Key, _Value > test( av, map );
+        for( std::size_t i = 0 ; i < items.size() ; ++ i ){
+            AV_ASSERT( items[ i ] == std::make_pair( static_cast< int >( i ), static_cast< int >( i ) ) );
+        }
 
-    checkEqual( av, map );
+        _size = items.size();
+    }
 
-    int percentage = 1;
-    int const progressStep = 20;
-    int const numberOfRepetitions = rep * 256;
+    std::size_t & _size;
+};
 
-    {//draw simple progress bar
-        std::cout << "[0%.."; std::flush( std::cout );
+//
+// RcuAssocVectorReaderThread, reads until all items of the writer are published
+//
+struct RcuAssocVectorReaderThread
+{
+    RcuAssocVectorReaderThread( RcuAssocVector< int, int > & rcu, std::size_t items )
+        : _rcu( rcu )
+        , _items( items )
+    {
     }
 
-    for( int i = 0 ; i < numberOfRepetitions ; ++ i )
+    void operator()()
     {
-        {//draw simple progress bar
-            if( 100.0 * i / numberOfRepetitions >= progressStep * percentage ){
-                std::cout << progressStep * (percentage++) << "%.."; std::flush( std::cout );
-            }
+        RcuAssocVector< int, int >::reader reader( _rcu );
+
+        std::size_t size = 0;
+
+        while( size < _items ){
+            reader.read( RcuAssocVectorCheck( size ) );
         }
+    }
 
-        unsigned const maxKeyValue = 128;
+    RcuAssocVector< int, int > & _rcu;
+    std::size_t _items;
+};
 
-        int operation = rand() % 10;
+//
+// concurrent_rcu_threads_test
+//
+void concurrent_rcu_threads_test()
+{
+    int const items = 16 * 1024;
 
-        switch( operation )
-        {
-            case 0:
-            case 1:
-            case 2:
-                {
-                    int const key = rand() % maxKeyValue;
+    RcuAssocVector< int, int > rcu;
 
-                    test >> insert( key, key );
-                }
+    std::vector< std::thread > readers;
 
-                break;
+    for( int i = 0 ; i < 3 ; ++ i ){
+        readers.push_back( std::thread( RcuAssocVectorReaderThread( rcu, items ) ) );
+    }
 
-            case 3:
-                {
-                    int const key = rand() % maxKeyValue;
+    for( int i = 0 ; i < items ; ++ i ){
+        rcu.insert( std::make_pair( i, i ) );
+    }
 
-                    test >> find( key );
-                }
+    rcu.publish();
 
-                break;
+    for( std::size_t i = 0 ; i < readers.size() ; ++ i ){
+        readers[ i ].join();
+    }
 
-            case 4:
-                {
-                    int const key = rand() % maxKeyValue;
+    rcu.publish();
+
+    AV_ASSERT_EQUAL( rcu.retired(), 0 );
+}
 
-                    test >> erase( key );
-                }
+//
+// SeqlockThrowingLess, throws when a negative key is compared, so a write of it fails
+//
+struct SeqlockThrowingLess
+{
+    bool operator()( int lhs, int rhs )const
+    {
+        if( lhs < 0 || rhs < 0 ){
+            throw std::runtime_error( "SeqlockThrowingLess" );
+        }
 
-                break;
+        return lhs < rhs;
+    }
+};
 
-            case 5:
-                {
-                    int const key = rand() % maxKeyValue;
+//
+// concurrent_seqlock_test
+//
+void concurrent_seqlock_test()
+{
+    typedef SeqlockAssocVector< int, int > SAV;
 
-                    test >> findErase( key );
-                }
+    SAV sav;
+    std::map< int, int > map;
 
-                break;
+    for( int i = 0 ; i < 4096 ; ++ i )
+    {
+        int const key = rand() % 1024;
 
-            case 6:
-                {
-                    int const key = rand() % maxKeyValue;
+        if( rand() % 4 == 0 ){
+            AV_ASSERT_EQUAL( sav.erase( key ), map.erase( key ) );
+        }
+        else if( rand() % 2 == 0 ){
+            AV_ASSERT_EQUAL( sav.insert( std::make_pair( key, i ) ), map.insert( std::make_pair( key, i ) ).second );
+        }
+        else
+        {
+            bool const inserted = map.count( key ) == 0;
+            map[ key ] = i;
 
-                    test >> index_put( key, key );
-                }
+            AV_ASSERT_EQUAL( sav.insert_or_assign( key, i ), inserted );
+        }
 
-                break;
+        AV_ASSERT_EQUAL( sav.size(), map.size() );
+    }
 
-            case 7:
-                {
-                    int const key = rand() % maxKeyValue;
+    for( int key = -2 ; key < 1030 ; ++ key )
+    {
+        int mapped = -1;
 
-                    test >> lower_bound( key );
-                }
+        AV_ASSERT( sav.find( key, mapped ) == ( map.count( key ) == 1 ) );
+        AV_ASSERT_EQUAL( sav.count( key ), map.count( key ) );
 
-                break;
+        if( map.count( key ) == 1 ){
+            AV_ASSERT_EQUAL( mapped, map[ key ] );
+        }
 
-            case 8:
-                {
-                    int const key = rand() % maxKeyValue;
+        std::pair< int, int > value;
+        std::map< int, int >::const_iterator const expected = map.lower_bound( key );
 
-                    test >> upper_bound( key );
-                }
+        AV_ASSERT( sav.lower_bound( key, value ) == ( expected != map.end() ) );
 
-                break;
+        if( expected != map.end() ){
+            AV_ASSERT( value == std::make_pair( expected->first, expected->second ) );
+        }
+    }
 
-            case 9:
-                {
-                    int const key = rand() % maxKeyValue;
+    {
+        SeqlockAssocVector< int, int, SeqlockThrowingLess > throwing;
 
-                    test >> equal_range( key );
-                }
+        AV_ASSERT( throwing.insert( std::make_pair( 1, 2 ) ) );
 
-                break;
+        bool thrown = false;
 
-            default:
-                AV_ASSERT( false );
+        try
+        {
+            throwing.insert( std::make_pair( -1, 0 ) );
+        }
+        catch( std::runtime_error const & )
+        {
+            thrown = true;
         }
-    }
 
-    {//draw simple progress bar
-        std::cout << "100%] "; std::flush( std::cout );
+        AV_ASSERT( thrown );
+
+        // the sequence is even again, readers do not wait for a write which never ends
+        int mapped = -1;
+
+        AV_ASSERT( throwing.find( 1, mapped ) );
+        AV_ASSERT_EQUAL( mapped, 2 );
+        AV_ASSERT_EQUAL( throwing.size(), 1u );
     }
 }
 
 //
-// mem_leak_test_1
+// SeqlockAssocVectorReaderThread, mapped value is always twice the key
 //
-void mem_leak_test_1()
+struct SeqlockAssocVectorReaderThread
 {
-    typedef MyAllocator< std::pair< Key, Value > > Allocator;
-
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
-
-    Key::createdObjects = 0;
-    Key::destroyedObjects = 0;
-
-    Key::moves = 0;
-    Key::copies = 0;
-
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
-
-    Value::moves = 0;
-    Value::copies = 0;
+    SeqlockAssocVectorReaderThread( SeqlockAssocVector< int, int > const & sav, std::atomic< bool > const & done )
+        : _sav( sav )
+        , _done( done )
+    {
+    }
 
+    void operator()()
     {
-        unsigned const maxKeyValue = 512;
+        for( int key = 0 ; _done.load() == false ; key = ( key + 7 ) % 4096 )
+        {
+            int mapped = 0;
 
-        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
-        AV av;
+            if( _sav.find( key, mapped ) ){
+                AV_ASSERT_EQUAL( mapped, 2 * key );
+            }
 
-        for( int i = 0 ; i < 128 * 1024 ; ++ i )
-        {
-            int const operation = rand() % 5;
+            std::pair< int, int > value;
 
-            switch( operation )
+            if( _sav.lower_bound( key, value ) )
             {
-                case 0:
-                    av.insert( typename AV::value_type( rand() % maxKeyValue, Value() ) );
-                    break;
+                AV_ASSERT( value.first >= key );
+                AV_ASSERT_EQUAL( value.second, 2 * value.first );
+            }
+        }
+    }
 
-                case 1:
-                    av.find( rand() % maxKeyValue );
-                    break;
+    SeqlockAssocVector< int, int > const & _sav;
+    std::atomic< bool > const & _done;
+};
 
-                case 2:
-                    av.erase( rand() % maxKeyValue );
-                    break;
+//
+// concurrent_seqlock_threads_test
+//
+void concurrent_seqlock_threads_test()
+{
+    SeqlockAssocVector< int, int > sav;
+    std::atomic< bool > done( false );
 
-                case 3:
-                    {
-                        typename AV::iterator foundAV = av.find( rand() % maxKeyValue );
+    std::vector< std::thread > readers;
 
-                        if( foundAV != av.end() ){
-                            av.erase( foundAV );
-                        }
-                    }
+    for( int i = 0 ; i < 3 ; ++ i ){
+        readers.push_back( std::thread( SeqlockAssocVectorReaderThread( sav, done ) ) );
+    }
 
-                    break;
+    // storage, buffer and erased change and grow while readers run
+    for( int i = 0 ; i < 4 * 4096 ; ++ i )
+    {
+        int const key = rand() % 4096;
 
-                case 4:
-                    av[ rand() % maxKeyValue ] = Value();
-                    break;
-            }
+        if( i % 3 == 0 ){
+            sav.erase( key );
+        }
+        else{
+            sav.insert_or_assign( key, 2 * key );
         }
     }
 
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+    done.store( true );
 
-    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+    for( std::size_t i = 0 ; i < readers.size() ; ++ i ){
+        readers[ i ].join();
+    }
 }
 
 //
-// mem_leak_test_destructor
+// concurrent_flat_combining_test
 //
-void mem_leak_test_destructor()
+void concurrent_flat_combining_test()
 {
-    typedef MyAllocator< std::pair< int, Value > > Allocator;
+    FlatCombiningAssocVector< int, int > fcav;
+    std::map< int, int > map;
 
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+    for( int i = 0 ; i < 4096 ; ++ i )
+    {
+        int const key = rand() % 1024;
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+        if( rand() % 4 == 0 ){
+            AV_ASSERT_EQUAL( fcav.erase( key ), map.erase( key ) );
+        }
+        else if( rand() % 2 == 0 ){
+            AV_ASSERT_EQUAL( fcav.insert( std::make_pair( key, i ) ), map.insert( std::make_pair( key, i ) ).second );
+        }
+        else
+        {
+            bool const inserted = map.count( key ) == 0;
+            map[ key ] = i;
+
+            AV_ASSERT_EQUAL( fcav.insert_or_assign( key, i ), inserted );
+        }
+
+        AV_ASSERT_EQUAL( fcav.size(), map.size() );
+    }
 
+    for( int key = -2 ; key < 1030 ; ++ key )
     {
-        int const numberOfObjects = 1024;
+        int mapped = -1;
 
-        typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
-        AV av;
+        AV_ASSERT( fcav.find( key, mapped ) == ( map.count( key ) == 1 ) );
+        AV_ASSERT_EQUAL( fcav.count( key ), map.count( key ) );
 
-        for( int i = 0 ; i < numberOfObjects ; ++ i ){
-            av.insert( AV::value_type( i, Value() ) );
+        if( map.count( key ) == 1 ){
+            AV_ASSERT_EQUAL( mapped, map[ key ] );
         }
     }
-
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
 }
 
 //
-// mem_leak_test_clear
+// FlatCombiningAssocVectorWorker, inserts keys i * threads + id, erases every third of them,
+// assigns the rest and checks each step with find
 //
-void mem_leak_test_clear()
+struct FlatCombiningAssocVectorWorker
 {
-    typedef MyAllocator< std::pair< int, Value > > Allocator;
+    FlatCombiningAssocVectorWorker( FlatCombiningAssocVector< int, int > & fcav, int id, int threads, int items )
+        : _fcav( fcav )
+        , _id( id )
+        , _threads( threads )
+        , _items( items )
+    {
+    }
 
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+    void operator()()
+    {
+        for( int i = 0 ; i < _items ; ++ i )
+        {
+            int const key = i * _threads + _id;
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+            int mapped = -1;
 
-    int const numberOfObjects = 1024;
+            AV_ASSERT( _fcav.insert( std::make_pair( key, _id ) ) );
+            AV_ASSERT( _fcav.insert( std::make_pair( key, -1 ) ) == false );
 
-    typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
-    AV av;
+            AV_ASSERT( _fcav.find( key, mapped ) );
+            AV_ASSERT_EQUAL( mapped, _id );
 
-    for( int i = 0 ; i < numberOfObjects ; ++ i ){
-        av.insert( AV::value_type( i, Value() ) );
+            if( i % 3 == 0 )
+            {
+                AV_ASSERT_EQUAL( _fcav.erase( key ), 1u );
+                AV_ASSERT_EQUAL( _fcav.count( key ), 0u );
+            }
+            else
+            {
+                AV_ASSERT( _fcav.insert_or_assign( key, 2 * _id ) == false );
+            }
+        }
     }
 
-    av.clear();
-
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
-}
+    FlatCombiningAssocVector< int, int > & _fcav;
+    int _id;
+    int _threads;
+    int _items;
+};
 
 //
-// mem_leak_test_copy_constructor
+// concurrent_flat_combining_threads_test
 //
-void mem_leak_test_copy_constructor()
+void concurrent_flat_combining_threads_test()
 {
-    typedef MyAllocator< std::pair< int, Value > > Allocator;
+    int const threads = 8;
+    int const items = 4 * 1024;
 
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+    FlatCombiningAssocVector< int, int > fcav;
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+    std::vector< std::thread > workers;
+
+    for( int id = 0 ; id < threads ; ++ id ){
+        workers.push_back( std::thread( FlatCombiningAssocVectorWorker( fcav, id, threads, items ) ) );
+    }
+
+    for( std::size_t i = 0 ; i < workers.size() ; ++ i ){
+        workers[ i ].join();
+    }
+
+    AV_ASSERT_EQUAL( fcav.size(), static_cast< std::size_t >( threads * ( items - ( items + 2 ) / 3 ) ) );
 
+    for( int key = 0 ; key < threads * items ; ++ key )
     {
-        int const numberOfObjects = 1024;
+        int mapped = -1;
 
-        typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
-        AV av;
+        bool const erased = ( key / threads ) % 3 == 0;
 
-        for( int i = 0 ; i < numberOfObjects ; ++ i ){
-            av.insert( AV::value_type( i, Value() ) );
-        }
+        AV_ASSERT( fcav.find( key, mapped ) == ( erased == false ) );
 
-        AV av2( av );
+        if( erased == false ){
+            AV_ASSERT_EQUAL( mapped, 2 * ( key % threads ) );
+        }
     }
-
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
 }
 
 //
-// mem_leak_test_assign_operator
+// FlatCombiningThrowingAssign, mapped value whose copy assignment throws for a negative value,
+// other assignments yield, so other threads publish their operations and the combiner batches them
 //
-void mem_leak_test_assign_operator()
+struct FlatCombiningThrowingAssign
 {
-    typedef MyAllocator< std::pair< int, Value > > Allocator;
-
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+    FlatCombiningThrowingAssign( int value = 0 )
+        : _value( value )
+    {
+    }
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+    FlatCombiningThrowingAssign( FlatCombiningThrowingAssign const & other )
+        : _value( other._value )
+    {
+    }
 
+    FlatCombiningThrowingAssign & operator=( FlatCombiningThrowingAssign const & other )
     {
-        int const numberOfObjects = 1024;
+        if( other._value < 0 ){
+            throw std::runtime_error( "FlatCombiningThrowingAssign" );
+        }
 
-        typedef AssocVector< int, Value, std::less< int >, Allocator > AV;
-        AV av;
+        std::this_thread::yield();
 
-        for( int i = 0 ; i < numberOfObjects ; ++ i ){
-            av.insert( AV::value_type( i, Value() ) );
-        }
+        _value = other._value;
 
-        AV av2;
-        av2 = av;
+        return * this;
     }
 
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
-}
+    int _value;
+};
 
 //
-// cxx11x_move_test_1
+// FlatCombiningAssocVectorAssigner, assigns to key id, assignments of thread 0 throw,
+// an operation batched with them must not
 //
-void cxx11x_move_test_1()
+struct FlatCombiningAssocVectorAssigner
 {
-    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+    FlatCombiningAssocVectorAssigner(
+          FlatCombiningAssocVector< int, FlatCombiningThrowingAssign > & fcav
+        , std::atomic< int > & started
+        , int id
+        , int threads
+        , int items
+    )
+        : _fcav( fcav )
+        , _started( started )
+        , _id( id )
+        , _threads( threads )
+        , _items( items )
+    {
+    }
 
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+    void operator()()
+    {
+        // thread 0 does not finish before the others start
+        ++ _started;
 
-    Key::createdObjects = 0;
-    Key::destroyedObjects = 0;
+        while( _started.load() != _threads ){
+            std::this_thread::yield();
+        }
 
-    Key::moves = 0;
-    Key::copies = 0;
+        for( int i = 0 ; i < _items ; ++ i )
+        {
+            bool thrown = false;
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+            try
+            {
+                _fcav.insert_or_assign( _id, FlatCombiningThrowingAssign( _id == 0 ? -1 : i ) );
+            }
+            catch( std::runtime_error const & )
+            {
+                thrown = true;
+            }
 
-    Value::moves = 0;
-    Value::copies = 0;
+            AV_ASSERT( thrown == ( _id == 0 ) );
 
-    {
-        unsigned const counter = 1024;
+            FlatCombiningThrowingAssign mapped;
+
+            AV_ASSERT( _fcav.find( _id, mapped ) );
+            AV_ASSERT_EQUAL( mapped._value, ( _id == 0 ? 0 : i ) );
+        }
+    }
+
+    FlatCombiningAssocVector< int, FlatCombiningThrowingAssign > & _fcav;
+    std::atomic< int > & _started;
+    int _id;
+    int _threads;
+    int _items;
+};
 
-        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
-        AV av1;
+//
+// concurrent_flat_combining_exception_test
+//
+void concurrent_flat_combining_exception_test()
+{
+    int const threads = 8;
+    int const items = 4 * 1024;
 
-        {// insert( value_type )
-            for( unsigned i = 0 ; i < counter ; ++ i ){
-                av1.insert( AV::value_type( i, Value() ) );
-            }
-        }
+    FlatCombiningAssocVector< int, FlatCombiningThrowingAssign > fcav;
 
-        AV_ASSERT_EQUAL( Value::copies, 0 );
+    for( int id = 0 ; id < threads ; ++ id ){
+        AV_ASSERT( fcav.insert( std::make_pair( id, FlatCombiningThrowingAssign( 0 ) ) ) );
+    }
 
-        AV av2 = std::move( av1 );
+    std::atomic< int > started( 0 );
 
-        AV_ASSERT_EQUAL( Value::copies, 0 );
+    std::vector< std::thread > workers;
+
+    for( int id = 0 ; id < threads ; ++ id ){
+        workers.push_back( std::thread( FlatCombiningAssocVectorAssigner( fcav, started, id, threads, items ) ) );
     }
 
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+    for( std::size_t i = 0 ; i < workers.size() ; ++ i ){
+        workers[ i ].join();
+    }
 
-    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+    AV_ASSERT_EQUAL( fcav.size(), static_cast< std::size_t >( threads ) );
 }
 
 //
-// cxx11x_move_test_2
+// concurrent_ingest_test
 //
-void cxx11x_move_test_2()
+void concurrent_ingest_test()
 {
-    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+    typedef IngestAssocVector< int, int > IAV;
 
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+    IAV iav;
+    std::map< int, int > map;
 
-    Key::createdObjects = 0;
-    Key::destroyedObjects = 0;
+    {
+        IAV::writer writer( iav, 16 );
 
-    Key::moves = 0;
-    Key::copies = 0;
+        for( int i = 0 ; i < 4096 ; ++ i )
+        {
+            int const key = rand() % 1024;
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+            writer.insert_or_assign( key, i );
+            map[ key ] = i;
 
-    Value::moves = 0;
-    Value::copies = 0;
+            int mapped = -1;
 
-    {
-        unsigned const counter = 1024;
+            // own writes are visible at once
+            AV_ASSERT( writer.find( key, mapped ) );
+            AV_ASSERT_EQUAL( mapped, i );
+            AV_ASSERT_EQUAL( writer.count( key ), 1u );
 
-        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
-        AV av;
+            // readers see flushed writes only
+            AV_ASSERT( iav.size() <= map.size() );
+            AV_ASSERT( writer.pending() < 16 );
+        }
 
-        {// insert( value_type )
-            for( unsigned i = 0 ; i < counter / 4 ; ++ i ){
-                Value value;
+        writer.flush();
 
-                av.insert( AV::value_type( i, value ) );
-            }
-        }
+        AV_ASSERT_EQUAL( writer.pending(), 0u );
+        AV_ASSERT_EQUAL( iav.size(), map.size() );
+    }
 
-        AV_ASSERT_EQUAL( Key::copies, counter / 4 );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+    {// a writer flushes on destruction
+        IAV::writer writer( iav );
 
-        {// insert( value_type )
-            for( unsigned i = counter / 4 ; i < counter / 2 ; ++ i ){
-                av.insert( AV::value_type( Key( i ), Value( i ) ) );
-            }
-        }
+        writer.insert_or_assign( -1, -1 );
+        map[ -1 ] = -1;
 
-        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+        AV_ASSERT_EQUAL( iav.count( -1 ), 0u );
+    }
 
-        {// operator[]( value_type )
-            for( unsigned i = counter / 4 ; i < counter / 2 ; ++ i ){
-                av[ i ] = Value();
-            }
-        }
+    for( int key = -2 ; key < 1030 ; ++ key )
+    {
+        int mapped = -2;
 
-        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+        AV_ASSERT( iav.find( key, mapped ) == ( map.count( key ) == 1 ) );
+        AV_ASSERT_EQUAL( iav.count( key ), map.count( key ) );
 
-        {// find( value_type )
-            for( unsigned i = 0 ; i < counter / 4 ; ++ i ){
-                av.find( i );
-            }
+        if( map.count( key ) == 1 ){
+            AV_ASSERT_EQUAL( mapped, map[ key ] );
         }
+    }
+}
 
-        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+//
+// IngestAssocVectorWorker, writes keys i * threads + id twice, the second write wins
+//
+struct IngestAssocVectorWorker
+{
+    IngestAssocVectorWorker( IngestAssocVector< int, int > & iav, int id, int threads, int items )
+        : _iav( iav )
+        , _id( id )
+        , _threads( threads )
+        , _items( items )
+    {
+    }
 
-        {// _find( value_type )
-            for( unsigned i = counter / 4 ; i < counter / 2 ; ++ i ){
-                av._find( i );
-            }
+    void operator()()
+    {
+        IngestAssocVector< int, int >::writer writer( _iav, 64 );
+
+        for( int i = 0 ; i < _items ; ++ i ){
+            writer.insert_or_assign( i * _threads + _id, -1 );
         }
 
-        AV_ASSERT_EQUAL( Key::copies, counter / 2 );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+        for( int i = 0 ; i < _items ; ++ i )
+        {
+            int const key = i * _threads + _id;
 
-        {// operator[]( value_type )
-            for( unsigned i = counter / 2 ; i < counter ; ++ i ){
-                av[ i ] = i;
-            }
-        }
+            writer.insert_or_assign( key, _id );
 
-        AV_ASSERT_EQUAL( Key::copies, counter );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+            int mapped = -1;
 
-        {// erase( value_type )
-            for( unsigned i = 0 ; i < counter / 2 ; ++ i ){
-                av.erase( i );
-            }
+            AV_ASSERT( writer.find( key, mapped ) );
+            AV_ASSERT_EQUAL( mapped, _id );
         }
+    }
 
-        AV_ASSERT_EQUAL( Key::copies, counter );
-        AV_ASSERT_EQUAL( Value::copies, counter / 4 );
+    IngestAssocVector< int, int > & _iav;
+    int _id;
+    int _threads;
+    int _items;
+};
 
-        {// erase( iterator )
-            for( unsigned i = counter / 2 ; i < counter ; ++ i ){
-                av.erase( av.find( i ) );
-            }
-        }
+//
+// concurrent_ingest_threads_test
+//
+void concurrent_ingest_threads_test()
+{
+    int const threads = 4;
+    int const items = 8 * 1024;
 
-        AV_ASSERT( Key::copies <= 2 * counter );
-        AV_ASSERT( Value::copies <= 2 * counter );
+    IngestAssocVector< int, int > iav;
+
+    std::vector< std::thread > workers;
+
+    for( int id = 0 ; id < threads ; ++ id ){
+        workers.push_back( std::thread( IngestAssocVectorWorker( iav, id, threads, items ) ) );
     }
 
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
+    for( std::size_t i = 0 ; i < workers.size() ; ++ i ){
+        workers[ i ].join();
+    }
 
-    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
+    AV_ASSERT_EQUAL( iav.size(), static_cast< std::size_t >( threads * items ) );
+
+    for( int key = 0 ; key < threads * items ; ++ key )
+    {
+        int mapped = -1;
+
+        AV_ASSERT( iav.find( key, mapped ) );
+        AV_ASSERT_EQUAL( mapped, key % threads );
+    }
 }
 
 //
-// cxx11x_forward_test_insert
+// concurrent_parallel_build_test
 //
-void cxx11x_forward_test_insert()
+void concurrent_parallel_build_test()
 {
-    typedef MyAllocator< std::pair< Key, Value > > Allocator;
+    for( int test = 0 ; test < 16 ; ++ test )
+    {
+        std::size_t const size = test == 0 ? 0 : rand() % ( 8 * AV_PARALLEL_MIN_ITEMS );
+        std::size_t const threads = 1 + test % 4;
 
-    Allocator::notFreedMemory = 0;
-    Allocator::totalMemory = 0;
+        std::vector< std::pair< int, int > > input;
+        std::map< int, int > map;
+        std::map< int, int, std::greater< int > > greater;
 
-    Key::createdObjects = 0;
-    Key::destroyedObjects = 0;
+        for( std::size_t i = 0 ; i < size ; ++ i )
+        {
+            // negative keys and duplicates, the last one wins
+            int const key = rand() % 4096 - 2048;
 
-    Key::moves = 0;
-    Key::copies = 0;
+            input.push_back( std::make_pair( key, static_cast< int >( i ) ) );
+            map[ key ] = i;
+            greater[ key ] = i;
+        }
 
-    Value::createdObjects = 0;
-    Value::destroyedObjects = 0;
+        {// radix sort
+            AssocVector< int, int > const av = parallel_build< AssocVector< int, int > >( input.begin(), input.end(), threads );
 
-    Value::moves = 0;
-    Value::copies = 0;
+            AV_ASSERT_EQUAL( av.size(), map.size() );
+            AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
+        }
 
-    {
-        unsigned const counter = 1024;
+        {// comparison sort
+            typedef AssocVector< int, int, std::greater< int > > AV;
 
-        typedef AssocVector< Key, Value, std::less< Key >, Allocator > AV;
-        AV av;
+            AV const av = parallel_build< AV >( input.begin(), input.end(), threads );
 
-        {// insert( value_type )
-            for( unsigned i = 0 ; i < counter / 2 ; ++ i ){
-                av.insert( std::move( AV::value_type( i, std::move( Value() ) ) ) );
-            }
+            AV_ASSERT_EQUAL( av.size(), greater.size() );
+            AV_ASSERT( std::equal( av.begin(), av.end(), greater.begin() ) );
         }
-
-        AV_ASSERT_EQUAL( Value::copies, 0 );
     }
 
-    AV_ASSERT_EQUAL( Allocator::notFreedMemory, 0 );
-
-    AV_ASSERT_EQUAL( Key::createdObjects, Key::destroyedObjects );
-    AV_ASSERT_EQUAL( Value::createdObjects, Value::destroyedObjects );
-}
+    {// keys which are not integral
+        std::vector< std::pair< std::string, std::string > > input;
+        std::map< std::string, std::string > map;
 
-//
-// cxx11x_at_test
-//
-void cxx11x_at_test()
-{
-    typedef AssocVector< std::string, int > AssocVector;
+        for( int i = 0 ; i < 4 * AV_PARALLEL_MIN_ITEMS ; ++ i )
+        {
+            std::string const key = std::string( 1, 'a' + rand() % 26 ) + std::string( 1, 'a' + rand() % 26 );
+            std::string const value( 1 + i % 16, 'x' );
 
-    AssocVector av;
+            input.push_back( std::make_pair( key, value ) );
+            map[ key ] = value;
+        }
 
-    av[ "a" ] = 1;
-    av[ "b" ] = 2;
-    av[ "c" ] = 3;
+        typedef AssocVector< std::string, std::string > AV;
 
-    av.erase( "b" );
+        AV av = parallel_build< AV >( input.begin(), input.end(), 4 );
 
-    AV_ASSERT( av.at( "a" ) == 1 );
-    AV_ASSERT( av.at( "c" ) == 3 );
+        AV_ASSERT_EQUAL( av.size(), map.size() );
+        AV_ASSERT( std::equal( av.begin(), av.end(), map.begin() ) );
 
-    try{
-        av.at( "b" ) = 2;
-        AV_ASSERT( false );
-    }
-    catch( std::out_of_range & ){
-    }
-    catch( ... ){
-        AV_ASSERT( false );
+        // container is usable as built
+        av[ "zzz" ] = "last";
+        AV_ASSERT_EQUAL( av.size(), map.size() + 1 );
     }
 
-    try{
-        av.at( "d" ) = 4;
-        AV_ASSERT( false );
-    }
-    catch( std::out_of_range & ){
-    }
-    catch( ... ){
-        AV_ASSERT( false );
+    {// storage comes from the allocator given
+        std::vector< std::pair< int, int > > input;
+
+        for( int i = 0 ; i < 4 * AV_PARALLEL_MIN_ITEMS ; ++ i ){
+            input.push_back( std::make_pair( rand(), i ) );
+        }
+
+        typedef AssocVector< int, int, std::less< int >, CountingAllocator< std::pair< int, int > > > AV;
+
+        std::size_t used = 0;
+
+        {
+            AV const av = parallel_build< AV >(
+                  input.begin(), input.end(), 4, std::less< int >(), CountingAllocator< std::pair< int, int > >( & used )
+            );
+
+            AV_ASSERT( used >= av.size() * sizeof( std::pair< int, int > ) );
+        }
+
+        AV_ASSERT_EQUAL( used, 0u );
     }
 }
 
 //
-// cxx11x_emplace_test
+// ParallelForEachSum, adds keys and mapped values of visited items
 //
-void cxx11x_emplace_test()
+struct ParallelForEachSum
 {
-    typedef AssocVector< Key, Value > AssocVector;
+    ParallelForEachSum( std::atomic< long long > & sum, std::atomic< std::size_t > & count )
+        : _sum( sum )
+        , _count( count )
+    {
+    }
 
+    void operator()( std::pair< int, int > const & value )
     {
-        AssocVector av;
+        _sum += value.first + value.second;
+        ++ _count;
+    }
 
-        Key::copies = 0;
-        Value::copies = 0;
+    std::atomic< long long > & _sum;
+    std::atomic< std::size_t > & _count;
+};
 
-        av.emplace( 1 );
+//
+// ParallelReduceSum, reduce of parallel_reduce
+//
+struct ParallelReduceSum
+{
+    long long operator()( long long result, std::pair< int, int > const & value )const
+    {
+        return result + value.second;
+    }
+};
 
-        AV_ASSERT_EQUAL( Key::copies, 0 );
-        AV_ASSERT_EQUAL( Value::copies, 0 );
+//
+// ParallelReduceKeys, reduce and combine of parallel_reduce, not commutative
+//
+struct ParallelReduceKeys
+{
+    std::vector< int > operator()( std::vector< int > result, std::pair< int, int > const & value )const
+    {
+        result.push_back( value.first );
 
-        AV_ASSERT( av.at( 1 ) == Value( 0, "" ) );
+        return result;
     }
 
+    std::vector< int > operator()( std::vector< int > lhs, std::vector< int > const & rhs )const
     {
-        AssocVector av;
+        lhs.insert( lhs.end(), rhs.begin(), rhs.end() );
 
-        Key::copies = 0;
-        Value::copies = 0;
+        return lhs;
+    }
+};
 
-        av.emplace( 11, 22 );
+//
+// concurrent_parallel_for_each_test
+//
+void concurrent_parallel_for_each_test()
+{
+    for( int test = 0 ; test < 8 ; ++ test )
+    {
+        std::size_t const threads = test % 5;
 
-        AV_ASSERT_EQUAL( Key::copies, 0 );
-        AV_ASSERT_EQUAL( Value::copies, 0 );
+        AssocVector< int, int > av;
+        std::map< int, int > map;
 
-        AV_ASSERT( av.at( 11 ) == Value( 22, "" ) );
-    }
+        // storage, buffer and erased are not empty
+        fill_random( av, map, test == 0 ? 0 : rand() % ( 8 * AV_PARALLEL_MIN_ITEMS ) );
 
-    {
-        AssocVector av;
+        long long sum = 0;
+        long long sumMapped = 0;
+        std::vector< int > keys;
 
-        Key::copies = 0;
-        Value::copies = 0;
+        for( std::map< int, int >::const_iterator current = map.begin() ; current != map.end() ; ++ current )
+        {
+            sum += current->first + current->second;
+            sumMapped += current->second;
+            keys.push_back( current->first );
+        }
 
-        av.emplace( 111, 222, "333" );
+        std::atomic< long long > visitedSum( 0 );
+        std::atomic< std::size_t > visitedCount( 0 );
 
-        AV_ASSERT_EQUAL( Key::copies, 0 );
-        AV_ASSERT_EQUAL( Value::copies, 0 );
+        parallel_for_each( av, ParallelForEachSum( visitedSum, visitedCount ), threads );
 
-        AV_ASSERT( av.at( 111 ) == Value( 222, "333" ) );
+        AV_ASSERT_EQUAL( visitedSum.load(), sum );
+        AV_ASSERT_EQUAL( visitedCount.load(), map.size() );
+
+        AV_ASSERT_EQUAL( parallel_reduce( av, 0LL, ParallelReduceSum(), std::plus< long long >(), threads ), sumMapped );
+
+        AV_ASSERT( parallel_reduce( av, std::vector< int >(), ParallelReduceKeys(), ParallelReduceKeys(), threads ) == keys );
     }
 }
 
@@ -3256,6 +6212,13 @@ int main( int argc, char * argv[] )
         test_move_overlap_less_then_half();
         test_move_overlap_more_than_half();
         test_move_overlap_copy_to_begining();
+        test_move_trivially_copyable();
+
+        test_erase_removed();
+
+        test_gallop_lower_bound();
+        test_interleaved_lower_bound();
+        test_radix_sort();
 
         test_last_less_equal();
 
@@ -3286,11 +6249,31 @@ int main( int argc, char * argv[] )
         test_insert_in_decreasing_order();
         test_insert_in_random_order();
         test_insert_init_list();
+        test_insert_range();
+        test_insert_or_assign_many();
+        test_from_sorted_unique();
 
         test_erase_in_increasing_order();
         test_erase_in_decreasing_order();
         test_erase_in_random_order();
 
+        test_erase_range();
+        test_erase_if();
+        test_erase_keys();
+
+        test_find_many();
+        test_set_operations();
+        test_merge();
+        test_absorb();
+        test_release_sorted();
+        test_insert_hint();
+        test_rank_nth();
+        test_aggregate();
+        test_split();
+        test_for_each();
+        test_range();
+        test_handle();
+
         test_insert_insert();
         test_insert_erase_erase();
         test_insert_erase_insert();
@@ -3310,6 +6293,9 @@ int main( int argc, char * argv[] )
 
         test_user_type();
 
+        test_realloc_growth();
+        test_huge_page_allocator();
+
         std::cout << "OK." << std::endl;
     }
 
@@ -3343,6 +6329,7 @@ int main( int argc, char * argv[] )
 
         cxx11x_at_test();
         cxx11x_emplace_test();
+        cxx11x_try_emplace_test();
 
         std::cout << "OK." << std::endl;
     }
@@ -3359,6 +6346,32 @@ int main( int argc, char * argv[] )
         std::cout << "OK." << std::endl;
     }
 
+    {
+        std::cout << "Concurrent tests..."; std::flush( std::cout );
+
+        concurrent_sharded_test();
+        concurrent_sharded_threads_test();
+        concurrent_sharded_resplit_test();
+
+        concurrent_rcu_test();
+        concurrent_rcu_threads_test();
+
+        concurrent_seqlock_test();
+        concurrent_seqlock_threads_test();
+
+        concurrent_parallel_build_test();
+        concurrent_parallel_for_each_test();
+
+        concurrent_ingest_test();
+        concurrent_ingest_threads_test();
+
+        concurrent_flat_combining_test();
+        concurrent_flat_combining_threads_test();
+        concurrent_flat_combining_exception_test();
+
+        std::cout << "OK." << std::endl;
+    }
+
     {
         std::cout << "BlackBox tests..."; std::flush( std::cout );
 